@@ -0,0 +1,412 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "src/backends/CPU/cpu_kernels.hpp"
+#include "src/backends/kernels.hpp"
+
+// Number of cells of the benchmark domain, large enough to not fit in the caches
+constexpr int ncells = 10240;
+
+// Distribution of the number of wet levels per cell
+enum t_dolic_distribution {
+    dolic_full = 0,     // every column reaches the bottom level
+    dolic_uniform = 1,  // uniformly distributed column depths
+    dolic_shelf = 2,    // bathymetry-like: shallow shelves, slopes and deep basins
+};
+
+/*! \brief Synthetic domain with all the fields used by the CPU kernels.
+*
+*   The 3D fields are allocated for all the blocks, while the 2D fields are block scratch
+*   arrays reused by every block as in the backend.
+*/
+struct t_bench_domain {
+    int nproma, nlevs, nblocks;
+    // number of wet interfaces (dolic+1) summed over all the cells
+    double nwet;
+
+    std::vector<double *> memory;
+    std::vector<int *> memory_int;
+
+    mdspan_2d_int dolic_c, dolic_e;
+    mdspan_1d_int max_levels;
+    mdspan_3d_int edges_cell_idx, edges_cell_blk;
+    mdspan_1d_double pressure;
+    mdspan_3d_double temp, salt, rho, tke, tke_Lmix, tke_Av, tke_Pr, tke_Tspr, tke_Tbpr, tke_plc, tke_Tiwf,
+                     tke_Tdif, tke_Tdis, a_veloc_v, depth_CellInterface, wlc;
+    mdspan_2d_double hlc, u_stokes;
+    mdspan_2d_double sqrttke, Nsqr, Ssqr, tke_kv, forc, dzw_stretched, dzt_stretched, ke,
+                     a_dif, b_dif, c_dif, a_tri, b_tri, c_tri, d_tri, tke_upd, cp, dp;
+
+    t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal;
+    t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch;
+    t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix;
+    t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> p_gather;
+    t_index_range range;
+    t_constant p_constant;
+    t_constant_tke p_constant_tke;
+
+    t_bench_domain(int nproma_in, int nlevs_in, int distribution)
+        : nproma(nproma_in), nlevs(nlevs_in), nblocks((ncells + nproma_in - 1) / nproma_in) {
+        dolic_c = malloc_int(nblocks, nproma);
+        dolic_e = malloc_int(nblocks, nproma);
+        max_levels = cpu_mdspan_impl::memview_malloc(static_cast<int *>(nullptr), nblocks);
+        memory_int.push_back(max_levels.data_handle());
+        edges_cell_idx = malloc_int(2, nblocks, nproma);
+        edges_cell_blk = malloc_int(2, nblocks, nproma);
+        pressure = cpu_mdspan_impl::memview_malloc(static_cast<double *>(nullptr), nlevs);
+        memory.push_back(pressure.data_handle());
+        p_gather.cell_offset = malloc_int(2, nblocks, nproma);
+        p_gather.fused_block = malloc_int(nblocks, nproma);
+        p_gather.fused_start = cpu_mdspan_impl::memview_malloc(static_cast<int *>(nullptr), nblocks+1);
+        memory_int.push_back(p_gather.fused_start.data_handle());
+        p_gather.fused_edges = cpu_mdspan_impl::memview_malloc(static_cast<int *>(nullptr), nblocks * nproma);
+        memory_int.push_back(p_gather.fused_edges.data_handle());
+
+        mdspan_3d_double *fields_3d[] = {&temp, &salt, &rho, &tke, &tke_Lmix, &tke_Av, &tke_Pr, &tke_Tspr,
+                                         &tke_Tbpr, &tke_plc, &tke_Tiwf, &tke_Tdif, &tke_Tdis, &a_veloc_v,
+                                         &depth_CellInterface, &wlc};
+        for (mdspan_3d_double *field : fields_3d)
+            *field = malloc_double(nblocks, nlevs+1, nproma);
+        hlc = malloc_double(nblocks, nproma);
+        u_stokes = malloc_double(nblocks, nproma);
+        mdspan_2d_double *fields_2d[] = {&sqrttke, &Nsqr, &Ssqr, &tke_kv, &forc, &dzw_stretched, &dzt_stretched,
+                                         &ke, &a_dif, &b_dif, &c_dif, &a_tri, &b_tri, &c_tri, &d_tri, &tke_upd,
+                                         &cp, &dp};
+        for (mdspan_2d_double *field : fields_2d)
+            *field = malloc_double(nlevs+1, nproma);
+
+        // column depths, the padding cells of the last block are land
+        nwet = 0.0;
+        for (int jb = 0; jb < nblocks; jb++) {
+            for (int jc = 0; jc < nproma; jc++) {
+                int cell = jb * nproma + jc;
+                int dolic = 0;
+                if (cell < ncells) {
+                    if (distribution == dolic_full) {
+                        dolic = nlevs;
+                    } else if (distribution == dolic_uniform) {
+                        dolic = 1 + static_cast<int>((cell * 2654435761u) % nlevs);
+                    } else {
+                        double x = static_cast<double>(cell) / ncells;
+                        double depth = 0.5 - 0.5 * cos(2.0 * M_PI * x) + 0.1 * sin(37.0 * M_PI * x);
+                        dolic = max(1, min(nlevs, static_cast<int>(depth * nlevs)));
+                    }
+                    nwet += dolic + 1;
+                }
+                dolic_c(jb, jc) = dolic;
+            }
+        }
+
+        // every edge connects a cell with its next neighbour
+        for (int jb = 0; jb < nblocks; jb++) {
+            for (int jc = 0; jc < nproma; jc++) {
+                int cell = jb * nproma + jc;
+                int next = (cell + 1) % ncells;
+                edges_cell_idx(0, jb, jc) = jc;
+                edges_cell_blk(0, jb, jc) = jb;
+                edges_cell_idx(1, jb, jc) = next % nproma;
+                edges_cell_blk(1, jb, jc) = next / nproma;
+                dolic_e(jb, jc) = cell < ncells ? min(dolic_c(jb, jc), dolic_c(next / nproma, next % nproma)) : 0;
+            }
+        }
+
+        for (int jb = 0; jb < nblocks; jb++) {
+            max_levels(jb) = 0;
+            for (int jc = 0; jc < nproma; jc++)
+                max_levels(jb) = max(max_levels(jb), dolic_c(jb, jc));
+        }
+
+        // stratified ocean with weak turbulence
+        for (int level = 0; level < nlevs; level++)
+            pressure(level) = (10.0 * level + 5.0) * 1035.0 * 9.80665 * 1.0e-4;
+        for (int jb = 0; jb < nblocks; jb++) {
+            for (int level = 0; level < nlevs+1; level++) {
+                for (int jc = 0; jc < nproma; jc++) {
+                    temp(jb, level, jc) = 20.0 - 15.0 * level / nlevs;
+                    salt(jb, level, jc) = 34.5 + 0.5 * level / nlevs;
+                    rho(jb, level, jc) = 0.0;
+                    tke(jb, level, jc) = 1.0e-4 * (1.0 + 0.1 * jc / nproma);
+                    tke_Lmix(jb, level, jc) = 10.0;
+                    tke_Av(jb, level, jc) = 1.0e-3;
+                    tke_Pr(jb, level, jc) = 1.0;
+                    tke_Tspr(jb, level, jc) = 0.0;
+                    tke_Tbpr(jb, level, jc) = 0.0;
+                    tke_plc(jb, level, jc) = 0.0;
+                    tke_Tiwf(jb, level, jc) = 0.0;
+                    tke_Tdif(jb, level, jc) = 0.0;
+                    tke_Tdis(jb, level, jc) = 0.0;
+                    a_veloc_v(jb, level, jc) = 0.0;
+                    depth_CellInterface(jb, level, jc) = 10.0 * level;
+                    wlc(jb, level, jc) = 0.0;
+                }
+            }
+            // Langmuir cells in the upper 50 m
+            for (int jc = 0; jc < nproma; jc++) {
+                hlc(jb, jc) = 50.0;
+                u_stokes(jb, jc) = 0.1;
+            }
+        }
+        for (int level = 0; level < nlevs+1; level++) {
+            for (int jc = 0; jc < nproma; jc++) {
+                sqrttke(level, jc) = 1.0e-2;
+                Nsqr(level, jc) = 1.0e-5;
+                Ssqr(level, jc) = 1.0e-6;
+                tke_kv(level, jc) = 1.0e-4;
+                forc(level, jc) = 1.0e-8;
+                dzw_stretched(level, jc) = 10.0;
+                dzt_stretched(level, jc) = 10.0;
+                ke(level, jc) = 1.0e-3;
+                a_dif(level, jc) = 1.0e-5;
+                b_dif(level, jc) = 2.0e-5;
+                c_dif(level, jc) = 1.0e-5;
+                a_tri(level, jc) = -0.1;
+                b_tri(level, jc) = 1.2;
+                c_tri(level, jc) = -0.1;
+                d_tri(level, jc) = 1.0e-4;
+                tke_upd(level, jc) = 1.0e-4;
+                cp(level, jc) = 0.0;
+                dp(level, jc) = 0.0;
+            }
+        }
+
+        p_patch.dolic_e = dolic_e;
+        p_patch.edges_cell_idx = edges_cell_idx;
+        p_patch.edges_cell_blk = edges_cell_blk;
+        p_cvmix.a_veloc_v = a_veloc_v;
+        p_internal.tke_Av = tke_Av;
+
+        p_constant.nproma = nproma;
+        p_constant.nblocks = nblocks;
+        p_constant.nlevs = nlevs;
+        p_constant.dtime = 60.0;
+        p_constant.clc = 0.15;
+        p_constant.pi = M_PI;
+        init_edge_gather(p_patch, p_gather, p_constant);
+        range = {nproma, 0, nblocks-1, 0, end_index(nblocks-1), nproma, 0, nblocks-1, 0, end_index(nblocks-1)};
+
+        p_constant_tke.c_k = 0.1;
+        p_constant_tke.c_eps = 0.7;
+        p_constant_tke.alpha_tke = 30.0;
+        p_constant_tke.mxl_min = 1.0e-8;
+        p_constant_tke.KappaM_min = 1.0e-4;
+        p_constant_tke.KappaH_min = 1.0e-5;
+        p_constant_tke.KappaM_max = 100.0;
+        p_constant_tke.only_tke = true;
+        p_constant_tke.use_Kappa_min = false;
+    }
+
+    ~t_bench_domain() {
+        for (double *field : memory)
+            cpu_mdspan_impl::memview_free(field);
+        for (int *field : memory_int)
+            cpu_mdspan_impl::memview_free(field);
+    }
+
+    mdspan_2d_double malloc_double(int dim1, int dim2) {
+        mdspan_2d_double view = cpu_mdspan_impl::memview_malloc(static_cast<double *>(nullptr), dim1, dim2);
+        memory.push_back(view.data_handle());
+        return view;
+    }
+
+    mdspan_3d_double malloc_double(int dim1, int dim2, int dim3) {
+        mdspan_3d_double view = cpu_mdspan_impl::memview_malloc(static_cast<double *>(nullptr), dim1, dim2, dim3);
+        memory.push_back(view.data_handle());
+        return view;
+    }
+
+    mdspan_2d_int malloc_int(int dim1, int dim2) {
+        mdspan_2d_int view = cpu_mdspan_impl::memview_malloc(static_cast<int *>(nullptr), dim1, dim2);
+        memory_int.push_back(view.data_handle());
+        return view;
+    }
+
+    mdspan_3d_int malloc_int(int dim1, int dim2, int dim3) {
+        mdspan_3d_int view = cpu_mdspan_impl::memview_malloc(static_cast<int *>(nullptr), dim1, dim2, dim3);
+        memory_int.push_back(view.data_handle());
+        return view;
+    }
+
+    int end_index(int jb) const {
+        return min(nproma, ncells - jb * nproma) - 1;
+    }
+};
+
+/*! \brief Run a kernel over all the blocks of the domain and report the throughput.
+*
+*   narrays is the number of double arrays read or written by the kernel at each wet interface:
+*   the reported bandwidth is the nominal memory traffic, each element being counted once.
+*/
+template <class Kernel>
+void run_kernel(benchmark::State &state, int narrays, Kernel kernel) {
+    t_bench_domain domain(state.range(0), state.range(1), state.range(2));
+
+    for (auto _ : state) {
+        for (int jb = 0; jb < domain.nblocks; jb++)
+            kernel(domain, jb, 0, domain.end_index(jb));
+        benchmark::ClobberMemory();
+    }
+
+    // reported as cells/s and bytes/s (G/s is GB/s)
+    state.counters["cells"] = benchmark::Counter(ncells, benchmark::Counter::kIsIterationInvariantRate,
+                                                 benchmark::Counter::kIs1000);
+    state.counters["bytes"] = benchmark::Counter(domain.nwet * narrays * sizeof(double),
+                                                 benchmark::Counter::kIsIterationInvariantRate,
+                                                 benchmark::Counter::kIs1000);
+}
+
+static void BM_calculate_density(benchmark::State &state) {
+    run_kernel(state, 3, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        for (int level = 0; level < d.max_levels(jb); level++)
+            for (int jc = start_index; jc <= end_index; jc++)
+                if (level < d.dolic_c(jb, jc))
+                    d.rho(jb, level, jc) = calculate_density(d.temp(jb, level, jc), d.salt(jb, level, jc),
+                                                             d.pressure(level));
+    });
+}
+
+static void BM_calc_mxl_2(benchmark::State &state) {
+    run_kernel(state, 3, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        calc_mxl_2(jb, start_index, end_index, d.max_levels(jb), d.p_constant_tke.mxl_min,
+                   d.dolic_c, d.tke_Lmix, d.dzw_stretched);
+    });
+}
+
+static void BM_calc_diffusivity(benchmark::State &state) {
+    run_kernel(state, 7, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        calc_diffusivity(jb, start_index, end_index, d.max_levels(jb), &d.p_constant_tke,
+                         d.dolic_c, d.tke_Lmix, d.sqrttke, d.Nsqr, d.Ssqr,
+                         d.tke_Av, d.tke_kv, d.tke_Pr);
+    });
+}
+
+static void BM_calc_forcing(benchmark::State &state) {
+    run_kernel(state, 7, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        calc_forcing(jb, start_index, end_index, d.max_levels(jb), false, d.p_constant_tke.only_tke,
+                     d.p_constant.clc, d.p_constant.pi,
+                     d.dolic_c, d.Ssqr, d.Nsqr, d.tke_Av, d.tke_kv, d.tke_Tspr, d.tke_Tbpr,
+                     d.depth_CellInterface, d.hlc, d.u_stokes, d.wlc, d.tke_plc, d.tke_Tiwf, d.forc);
+    });
+}
+
+// with the Langmuir production computed in the same pass (depth read, wlc and tke_plc written)
+static void BM_calc_forcing_langmuir(benchmark::State &state) {
+    run_kernel(state, 10, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        calc_forcing(jb, start_index, end_index, d.max_levels(jb), true, d.p_constant_tke.only_tke,
+                     d.p_constant.clc, d.p_constant.pi,
+                     d.dolic_c, d.Ssqr, d.Nsqr, d.tke_Av, d.tke_kv, d.tke_Tspr, d.tke_Tbpr,
+                     d.depth_CellInterface, d.hlc, d.u_stokes, d.wlc, d.tke_plc, d.tke_Tiwf, d.forc);
+    });
+}
+
+static void BM_build_diffusion_dissipation_tridiag(benchmark::State &state) {
+    run_kernel(state, 7, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        build_diffusion_dissipation_tridiag(jb, start_index, end_index, d.max_levels(jb),
+                                            d.dolic_c, d.p_constant_tke.alpha_tke,
+                                            d.tke_Av, d.dzt_stretched, d.dzw_stretched,
+                                            d.ke, d.a_dif, d.b_dif, d.c_dif);
+    });
+}
+
+static void BM_build_tridiag(benchmark::State &state) {
+    run_kernel(state, 11, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        build_tridiag(jb, start_index, end_index, d.max_levels(jb), d.dolic_c,
+                      d.p_constant.dtime, d.p_constant_tke.c_eps, d.nlevs,
+                      d.a_dif, d.b_dif, d.c_dif, d.sqrttke, d.tke_Lmix, d.tke_upd, d.forc,
+                      d.a_tri, d.b_tri, d.c_tri, d.d_tri);
+    });
+}
+
+static void BM_solve_tridiag(benchmark::State &state) {
+    run_kernel(state, 7, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        solve_tridiag(jb, start_index, end_index, d.max_levels(jb), d.dolic_c,
+                      d.a_tri, d.b_tri, d.c_tri, d.d_tri, d.tke, d.cp, d.dp);
+    });
+}
+
+static void BM_solve_tridiag_pcr(benchmark::State &state) {
+    run_kernel(state, 5, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        solve_tridiag_pcr(jb, start_index, end_index, d.dolic_c, d.a_tri, d.b_tri, d.c_tri, d.d_tri, d.tke);
+    });
+}
+
+static void BM_tke_vertical_diffusion(benchmark::State &state) {
+    run_kernel(state, 5, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        tke_vertical_diffusion(jb, start_index, end_index, d.max_levels(jb), d.dolic_c, 0.0, 0.0,
+                               d.a_dif, d.b_dif, d.c_dif, d.tke, d.tke_Tdif);
+    });
+}
+
+static void BM_tke_vertical_dissipation(benchmark::State &state) {
+    run_kernel(state, 4, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        tke_vertical_dissipation(jb, start_index, end_index, d.max_levels(jb), d.dolic_c,
+                                 d.nlevs, d.p_constant_tke.c_eps, d.tke_Lmix, d.sqrttke,
+                                 d.tke, d.tke_Tdis);
+    });
+}
+
+static void BM_calc_impl_edges(benchmark::State &state) {
+    run_kernel(state, 3, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        calc_impl_edges(jb, start_index, end_index, d.p_patch, d.p_cvmix, d.p_internal, d.p_constant);
+    });
+}
+
+// edges on the precomputed gather table
+static void BM_calc_impl_edges_gather(benchmark::State &state) {
+    run_kernel(state, 3, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        calc_impl_edges_gather(jb, start_index, end_index, 0, -1, d.p_patch, d.p_cvmix, d.p_internal,
+                               d.p_gather, d.p_constant);
+    });
+}
+
+// edges with both neighbours in the block computed after the cells of the block, then the others
+static void BM_calc_impl_edges_fused(benchmark::State &state) {
+    run_kernel(state, 3, [](t_bench_domain &d, int jb, int start_index, int end_index) {
+        calc_fused_edges(jb, d.range, d.p_patch, d.p_cvmix, d.p_internal, d.p_gather, d.p_constant);
+        calc_impl_edges_gather(jb, start_index, end_index, 0, d.nblocks-1, d.p_patch, d.p_cvmix, d.p_internal,
+                               d.p_gather, d.p_constant);
+    });
+}
+
+// nproma, nlevs and dolic distribution
+#define KERNEL_BENCHMARK(name)                                                \
+    BENCHMARK(name)->ArgNames({"nproma", "nlevs", "dolic"})                   \
+                   ->ArgsProduct({{8, 32, 128, 512}, {40, 64, 128},           \
+                                  {dolic_full, dolic_uniform, dolic_shelf}})  \
+                   ->Unit(benchmark::kMicrosecond)
+
+// tridiagonal solvers, also for deep columns and few columns per block
+#define TRIDIAG_BENCHMARK(name)                                               \
+    BENCHMARK(name)->ArgNames({"nproma", "nlevs", "dolic"})                   \
+                   ->ArgsProduct({{1, 8, 32, 128}, {40, 64, 128, 256},        \
+                                  {dolic_full, dolic_shelf}})                 \
+                   ->Unit(benchmark::kMicrosecond)
+
+KERNEL_BENCHMARK(BM_calculate_density);
+KERNEL_BENCHMARK(BM_calc_mxl_2);
+KERNEL_BENCHMARK(BM_calc_diffusivity);
+KERNEL_BENCHMARK(BM_calc_forcing);
+KERNEL_BENCHMARK(BM_calc_forcing_langmuir);
+KERNEL_BENCHMARK(BM_build_diffusion_dissipation_tridiag);
+KERNEL_BENCHMARK(BM_build_tridiag);
+TRIDIAG_BENCHMARK(BM_solve_tridiag);
+TRIDIAG_BENCHMARK(BM_solve_tridiag_pcr);
+KERNEL_BENCHMARK(BM_tke_vertical_diffusion);
+KERNEL_BENCHMARK(BM_tke_vertical_dissipation);
+KERNEL_BENCHMARK(BM_calc_impl_edges);
+KERNEL_BENCHMARK(BM_calc_impl_edges_gather);
+KERNEL_BENCHMARK(BM_calc_impl_edges_fused);
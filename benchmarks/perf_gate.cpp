@@ -0,0 +1,261 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "src/YAOP.hpp"
+#include "src/shared/synthetic_input.hpp"
+
+/*! \brief Options of the performance gate.
+*
+*   The problem is fixed by default so that the baselines of a machine stay comparable.
+*   The baseline file is baseline_dir/<hostname>.json unless it is given explicitly.
+*/
+struct t_gate_options {
+    int ncells = 20480;
+    int nlevs = 64;
+    int nproma = 128;
+    int threads = 1;
+    int warmup = 2;
+    int steps = 5;
+    int repeat = 5;
+    double tolerance = 0.10;
+    double min_share = 0.01;
+    bool update = false;
+    std::string baseline_dir = ".";
+    std::string baseline;
+};
+
+// Rate of one stage: cells per second, share of the step time
+struct t_gate_rate {
+    std::string name;
+    double cells_per_second;
+    double share;
+};
+
+static void usage() {
+    std::cerr << "Usage: yaop_perf_gate [--baseline file | --baseline-dir dir] [--update] [--tolerance 0.10]" << std::endl
+              << "                      [--min-share 0.01] [--ncells 20480] [--nlevs 64] [--nproma 128]" << std::endl
+              << "                      [--threads 1] [--warmup 2] [--steps 5] [--repeat 5]" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+static t_gate_options parse_options(int argc, char **argv) {
+    t_gate_options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--update")
+            options.update = true;
+        else if (arg == "--baseline" && has_value)
+            options.baseline = argv[++i];
+        else if (arg == "--baseline-dir" && has_value)
+            options.baseline_dir = argv[++i];
+        else if (arg == "--tolerance" && has_value)
+            options.tolerance = std::atof(argv[++i]);
+        else if (arg == "--min-share" && has_value)
+            options.min_share = std::atof(argv[++i]);
+        else if (arg == "--ncells" && has_value)
+            options.ncells = std::atoi(argv[++i]);
+        else if (arg == "--nlevs" && has_value)
+            options.nlevs = std::atoi(argv[++i]);
+        else if (arg == "--nproma" && has_value)
+            options.nproma = std::atoi(argv[++i]);
+        else if (arg == "--threads" && has_value)
+            options.threads = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && has_value)
+            options.warmup = std::atoi(argv[++i]);
+        else if (arg == "--steps" && has_value)
+            options.steps = std::atoi(argv[++i]);
+        else if (arg == "--repeat" && has_value)
+            options.repeat = std::atoi(argv[++i]);
+        else
+            usage();
+    }
+    if (options.ncells < 1 || options.nlevs < 1 || options.nproma < 1 || options.threads < 1 ||
+        options.warmup < 0 || options.steps < 1 || options.repeat < 1 || options.tolerance < 0.0)
+        usage();
+    if (options.baseline.empty()) {
+        char hostname[256] = "unknown";
+        gethostname(hostname, sizeof(hostname) - 1);
+        options.baseline = options.baseline_dir + "/" + hostname + ".json";
+    }
+    return options;
+}
+
+/*! \brief Run the fixed problem and measure the cells per second of the step and of each stage.
+*
+*   Each stage keeps its best rate over the repetitions, which filters out most of the noise
+*   of a shared machine. The stages are measured only when the library is built with ENABLE_TIMING.
+*/
+static std::vector<t_gate_rate> measure(const t_gate_options &options) {
+#ifdef _OPENMP
+    omp_set_num_threads(options.threads);
+#endif
+    synthetic_input input(options.ncells, options.nlevs, options.nproma);
+
+    double OceanReferenceDensity = 1025.022;
+    double grav = 9.80665;
+    double ReferencePressureIndbars = 1035.0*grav*1.0e-4;
+    double pi = 3.14159265358979323846264338327950288;
+    YAOP ocean_physics(options.nproma, options.nlevs, input.nblocks, 2, 4, 0, 600.0, OceanReferenceDensity, grav,
+                       0, 0.15, ReferencePressureIndbars, pi);
+    input.register_fields(&ocean_physics);
+
+    for (int t = 0; t < options.warmup; t++)
+        ocean_physics.step(input.range);
+
+    double step_seconds = 0.0;
+    std::vector<double> stage_seconds(timing_nstages, 0.0);
+    bool is_timing_enabled = false;
+    for (int r = 0; r < options.repeat; r++) {
+        ocean_physics.reset_timing();
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < options.steps; t++)
+            ocean_physics.step(input.range);
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count() / options.steps;
+        step_seconds = r == 0 ? seconds : std::min(step_seconds, seconds);
+
+        t_timing_report timing = ocean_physics.timing_report();
+        is_timing_enabled = timing.enabled;
+        for (int stage = 0; stage < timing_nstages; stage++) {
+            seconds = timing.seconds[stage] / options.steps;
+            stage_seconds[stage] = r == 0 ? seconds : std::min(stage_seconds[stage], seconds);
+        }
+    }
+
+    std::vector<t_gate_rate> rates;
+    rates.push_back({"step", options.ncells / step_seconds, 1.0});
+    if (is_timing_enabled) {
+        for (int stage = 0; stage < timing_nstages; stage++) {
+            if (stage_seconds[stage] > 0.0)
+                rates.push_back({YAOP::timing_stage_name(stage), options.ncells / stage_seconds[stage],
+                                 stage_seconds[stage] / step_seconds});
+        }
+    }
+    return rates;
+}
+
+static void write_baseline(const std::string &filename, const t_gate_options &options,
+                           const std::vector<t_gate_rate> &rates) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "yaop_perf_gate: cannot write " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    out << std::setprecision(6);
+    out << "{" << std::endl
+        << "  \"ncells\": " << options.ncells << ", \"nlevs\": " << options.nlevs << ", \"nproma\": "
+        << options.nproma << ", \"threads\": " << options.threads << "," << std::endl
+        << "  \"cells_per_second\": {" << std::endl;
+    for (size_t i = 0; i < rates.size(); i++)
+        out << "    \"" << rates[i].name << "\": " << rates[i].cells_per_second
+            << (i + 1 < rates.size() ? "," : "") << std::endl;
+    out << "  }" << std::endl << "}" << std::endl;
+}
+
+// Number following "key": in text (from position start), false if the key is not found
+static bool json_number(const std::string &text, const std::string &key, size_t start, double *value) {
+    size_t position = text.find("\"" + key + "\":", start);
+    if (position == std::string::npos)
+        return false;
+    *value = std::strtod(text.c_str() + position + key.size() + 3, nullptr);
+    return true;
+}
+
+/*! \brief Compare the measured rates with the baseline.
+*
+*   A stage regresses when its rate is lower than the baseline by more than the tolerance.
+*   Stages below min_share of the step are reported but not gated, their times are too short
+*   to be stable. It returns the number of regressed stages.
+*/
+static int compare_baseline(const std::string &text, const t_gate_options &options,
+                            const std::vector<t_gate_rate> &rates) {
+    double ncells, nlevs, nproma, threads;
+    if (!json_number(text, "ncells", 0, &ncells) || !json_number(text, "nlevs", 0, &nlevs) ||
+        !json_number(text, "nproma", 0, &nproma) || !json_number(text, "threads", 0, &threads) ||
+        text.find("\"cells_per_second\":") == std::string::npos) {
+        std::cerr << "yaop_perf_gate: " << options.baseline << " is not a baseline" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (ncells != options.ncells || nlevs != options.nlevs || nproma != options.nproma ||
+        threads != options.threads) {
+        std::cerr << "yaop_perf_gate: " << options.baseline << " was recorded for a different problem, "
+                  << "run with --update to record it again" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    size_t stages = text.find("\"cells_per_second\":");
+    int nregressed = 0;
+    std::cout << std::left << std::setw(18) << "stage" << std::right << std::setw(14) << "baseline"
+              << std::setw(14) << "current" << std::setw(10) << "diff" << std::endl;
+    for (const t_gate_rate &rate : rates) {
+        double baseline;
+        if (!json_number(text, rate.name, stages, &baseline) || baseline <= 0.0)
+            continue;
+        double difference = rate.cells_per_second / baseline - 1.0;
+        bool is_gated = rate.share >= options.min_share;
+        bool is_regressed = is_gated && difference < -options.tolerance;
+        nregressed += is_regressed;
+        std::cout << std::left << std::setw(18) << rate.name << std::right << std::setprecision(4)
+                  << std::setw(14) << baseline << std::setw(14) << rate.cells_per_second
+                  << std::setw(9) << std::fixed << std::setprecision(1) << 100.0 * difference << "%"
+                  << std::defaultfloat << (is_regressed ? "  REGRESSED" : (is_gated ? "" : "  (not gated)"))
+                  << std::endl;
+    }
+    return nregressed;
+}
+
+int main(int argc, char **argv) {
+    t_gate_options options = parse_options(argc, argv);
+
+#ifndef _OPENMP
+    if (options.threads != 1) {
+        std::cerr << "yaop_perf_gate: library built without OpenMP, running with 1 thread only" << std::endl;
+        options.threads = 1;
+    }
+#endif
+
+    std::vector<t_gate_rate> rates = measure(options);
+
+    std::ifstream in(options.baseline);
+    if (options.update || !in) {
+        write_baseline(options.baseline, options, rates);
+        std::cout << "yaop_perf_gate: baseline recorded in " << options.baseline << std::endl;
+        return 0;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+
+    int nregressed = compare_baseline(text.str(), options, rates);
+    std::cout << "yaop_perf_gate: " << nregressed << " stages regressed by more than " << std::setprecision(3)
+              << 100.0 * options.tolerance << "% against " << options.baseline << std::endl;
+    return nregressed > 0 ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,234 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "src/YAOP.hpp"
+#include "src/shared/snapshot.hpp"
+
+/*! \brief Options of the replay driver.
+*
+*   By default the captured state is restored before every step, so each step recomputes
+*   exactly the captured one. With no_reset the state evolves as in a model run. The numerical
+*   settings of the tke scheme are not captured and are the defaults unless given here.
+*/
+struct t_replay_options {
+    std::string snapshot;
+    int threads = 0;
+    int warmup = 1;
+    int steps = 10;
+    bool reset = true;
+    std::string dump;
+    std::string compare;
+    double tolerance = 0.0;
+    double quiescent_threshold = 0.0;
+    bool fuse_edges = false;
+    int tridiag_solver = tridiag_thomas;
+    int tke_mxl_choice = 2;
+};
+
+static void usage() {
+    std::cerr << "Usage: yaop_replay snapshot [--threads 4] [--warmup 1] [--steps 10] [--no-reset]" << std::endl
+              << "                   [--dump file] [--compare file] [--tolerance 0]" << std::endl
+              << "                   [--quiescent-threshold 0] [--fuse-edges] [--pcr] [--mxl-choice 2]" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+static t_replay_options parse_options(int argc, char **argv) {
+    t_replay_options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--no-reset")
+            options.reset = false;
+        else if (arg == "--threads" && has_value)
+            options.threads = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && has_value)
+            options.warmup = std::atoi(argv[++i]);
+        else if (arg == "--steps" && has_value)
+            options.steps = std::atoi(argv[++i]);
+        else if (arg == "--dump" && has_value)
+            options.dump = argv[++i];
+        else if (arg == "--compare" && has_value)
+            options.compare = argv[++i];
+        else if (arg == "--tolerance" && has_value)
+            options.tolerance = std::atof(argv[++i]);
+        else if (arg == "--quiescent-threshold" && has_value)
+            options.quiescent_threshold = std::atof(argv[++i]);
+        else if (arg == "--fuse-edges")
+            options.fuse_edges = true;
+        else if (arg == "--pcr")
+            options.tridiag_solver = tridiag_pcr;
+        else if (arg == "--mxl-choice" && has_value)
+            options.tke_mxl_choice = std::atoi(argv[++i]);
+        else if (arg[0] != '-' && options.snapshot.empty())
+            options.snapshot = arg;
+        else
+            usage();
+    }
+    if (options.snapshot.empty() || options.steps < 1 || options.warmup < 0 || options.tolerance < 0.0)
+        usage();
+    return options;
+}
+
+static void restore_fields(const snapshot_reader &captured, const snapshot_reader &state) {
+    for (size_t i = 0; i < state.fields().size(); i++)
+        std::memcpy(state.fields()[i].data, captured.fields()[i].data, state.fields()[i].bytes);
+}
+
+template <class T>
+static double max_difference(const t_snapshot_field &lhs, const t_snapshot_field &rhs) {
+    const T *lhs_data = static_cast<const T *>(lhs.data);
+    const T *rhs_data = static_cast<const T *>(rhs.data);
+    double difference = 0.0;
+    for (size_t i = 0; i < lhs.bytes / sizeof(T); i++) {
+        double lhs_value = static_cast<double>(lhs_data[i]);
+        double rhs_value = static_cast<double>(rhs_data[i]);
+        if (std::isnan(lhs_value) || std::isnan(rhs_value)) {
+            // NaN in only one of the two fields is a difference
+            if (std::isnan(lhs_value) != std::isnan(rhs_value))
+                difference = INFINITY;
+            continue;
+        }
+        difference = std::max(difference, std::fabs(lhs_value - rhs_value));
+    }
+    return difference;
+}
+
+/*! \brief Compare the fields after the replay with the ones of a reference snapshot.
+*
+*   It returns the number of fields which differ by more than the tolerance.
+*/
+static int compare_fields(const snapshot_reader &state, const std::string &filename, double tolerance) {
+    snapshot_reader reference(filename, false);
+    int nfailed = 0;
+    for (const t_snapshot_field &field : reference.fields()) {
+        const t_snapshot_field *replayed = state.find(field.name);
+        if (replayed == nullptr || replayed->type != field.type || replayed->bytes != field.bytes) {
+            std::cout << "  " << std::left << std::setw(24) << field.name << " missing or different shape"
+                      << std::endl;
+            nfailed++;
+            continue;
+        }
+        double difference = field.type == snapshot_double ? max_difference<double>(*replayed, field)
+                                                          : max_difference<int>(*replayed, field);
+        if (difference > tolerance) {
+            std::cout << "  " << std::left << std::setw(24) << field.name << " max difference " << difference
+                      << std::endl;
+            nfailed++;
+        }
+    }
+    return nfailed;
+}
+
+int main(int argc, char **argv) {
+    t_replay_options options = parse_options(argc, argv);
+
+#ifdef _OPENMP
+    if (options.threads > 0)
+        omp_set_num_threads(options.threads);
+    int threads = omp_get_max_threads();
+#else
+    if (options.threads > 1)
+        std::cerr << "yaop_replay: library built without OpenMP, running with 1 thread only" << std::endl;
+    int threads = 1;
+#endif
+
+    // the captured fields are read from the page cache, the state is a private copy modified by the steps
+    snapshot_reader captured(options.snapshot, false);
+    snapshot_reader state(options.snapshot, true);
+    const t_snapshot_params &params = state.params();
+    size_t snapshot_bytes = 0;
+    for (const t_snapshot_field &field : state.fields())
+        snapshot_bytes += field.bytes;
+    std::cout << "yaop_replay: " << options.snapshot << " step " << state.call() << ", nproma " << params.nproma
+              << ", nlevs " << params.nlevs << ", nblocks " << params.nblocks << ", " << state.fields().size()
+              << " fields (" << snapshot_bytes << " bytes), threads " << threads << std::endl;
+
+    YAOP ocean_physics(params.nproma, params.nlevs, params.nblocks, params.vert_mix_type, params.vmix_idemix_tke,
+                       params.vert_cor_type, params.dtime, params.OceanReferenceDensity, params.grav, params.l_lc,
+                       params.clc, params.ReferencePressureIndbars, params.pi);
+    if (!ocean_physics.set_quiescence(options.quiescent_threshold) ||
+        !ocean_physics.set_tridiag_solver(options.tridiag_solver) ||
+        !ocean_physics.set_tke_mxl_choice(options.tke_mxl_choice))
+        usage();
+    ocean_physics.set_fuse_edges(options.fuse_edges);
+    for (const t_snapshot_field &field : state.fields()) {
+        int ndims = static_cast<int>(field.shape.size());
+        if (field.type == snapshot_double)
+            ocean_physics.register_field(field.name, static_cast<double *>(field.data), ndims, field.shape.data());
+        else
+            ocean_physics.register_field(field.name, static_cast<int *>(field.data), ndims, field.shape.data());
+    }
+
+    // the older snapshots do not record the substeps
+    int nsubsteps = std::max(1, static_cast<int>(params.nsubsteps));
+    for (int t = 0; t < options.warmup; t++) {
+        if (options.reset)
+            restore_fields(captured, state);
+        if (!ocean_physics.step(state.range(), nsubsteps, params.dtime))
+            return 1;
+    }
+    ocean_physics.reset_timing();
+
+    double time_total = 0.0;
+    double time_min = 0.0;
+    for (int t = 0; t < options.steps; t++) {
+        if (options.reset)
+            restore_fields(captured, state);
+        auto start = std::chrono::steady_clock::now();
+        if (!ocean_physics.step(state.range(), nsubsteps, params.dtime))
+            return 1;
+        auto end = std::chrono::steady_clock::now();
+        double time_step = std::chrono::duration<double>(end - start).count();
+        time_total += time_step;
+        time_min = t == 0 ? time_step : std::min(time_min, time_step);
+    }
+    std::cout << "yaop_replay: " << options.steps << " steps, time per step " << time_total / options.steps
+              << " s, min " << time_min << " s" << std::endl;
+
+    t_timing_report timing = ocean_physics.timing_report();
+    if (timing.enabled) {
+        for (int stage = 0; stage < timing_nstages; stage++)
+            std::cout << "  " << std::left << std::setw(24) << YAOP::timing_stage_name(stage)
+                      << timing.seconds[stage] / options.steps << " s" << std::endl;
+    }
+
+    if (!options.dump.empty()) {
+        snapshot_write(options.dump, params, state.range(), state.call(), state.fields());
+        std::cout << "yaop_replay: state after the last step written to " << options.dump << std::endl;
+    }
+
+    if (!options.compare.empty()) {
+        int nfailed = compare_fields(state, options.compare, options.tolerance);
+        std::cout << "yaop_replay: " << nfailed << " fields differ from " << options.compare << std::endl;
+        if (nfailed > 0)
+            return EXIT_FAILURE;
+    }
+
+    return 0;
+}
@@ -0,0 +1,423 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "src/YAOP.hpp"
+#include "src/shared/synthetic_input.hpp"
+#include "src/shared/utils.hpp"
+
+/*! \brief Options of the roofline report.
+*
+*/
+struct t_roofline_options {
+    int ncells = 81920;
+    int nlevs = 64;
+    int nproma = 128;
+    int warmup = 2;
+    int steps = 10;
+    size_t stream_size = 1 << 24;
+    std::string format = "text";
+    std::string output;
+};
+
+/*! \brief Floating point operations and bytes moved by one stage in one time step.
+*
+*   The operations are additions, multiplications, divisions and square roots (min and max are not
+*   counted). The bytes are the compulsory traffic of the stage: every array element read or
+*   written by the stage is counted once (8 bytes for doubles, 4 for integers), without write
+*   allocation and assuming that the neighbouring levels of the vertical stencils are reused from
+*   the cache.
+*/
+struct t_stage_model {
+    double flops = 0.0;
+    double bytes = 0.0;
+};
+
+// Measured and modelled performance of one stage
+struct t_stage_result {
+    std::string name;
+    t_stage_model model;
+    double seconds;
+    double gflops, gbytes, intensity, attainable, fraction;
+    bool memory_bound;
+};
+
+// Operations of calculate_density
+static const double density_flops = 126.0;
+
+static void usage() {
+    std::cerr << "Usage: yaop_roofline [--ncells 81920] [--nlevs 64] [--nproma 128] [--warmup 2] [--steps 10]"
+              << std::endl
+              << "                     [--stream-size 16777216] [--format text|csv|json] [--output file]"
+              << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+static t_roofline_options parse_options(int argc, char **argv) {
+    t_roofline_options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--ncells" && has_value)
+            options.ncells = std::atoi(argv[++i]);
+        else if (arg == "--nlevs" && has_value)
+            options.nlevs = std::atoi(argv[++i]);
+        else if (arg == "--nproma" && has_value)
+            options.nproma = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && has_value)
+            options.warmup = std::atoi(argv[++i]);
+        else if (arg == "--steps" && has_value)
+            options.steps = std::atoi(argv[++i]);
+        else if (arg == "--stream-size" && has_value)
+            options.stream_size = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--format" && has_value)
+            options.format = argv[++i];
+        else if (arg == "--output" && has_value)
+            options.output = argv[++i];
+        else
+            usage();
+    }
+    if (options.format != "text" && options.format != "csv" && options.format != "json")
+        usage();
+    if (options.ncells < 1 || options.nlevs < 2 || options.nproma < 1 || options.steps < 1 ||
+        options.warmup < 0 || options.stream_size < 1)
+        usage();
+    return options;
+}
+
+/*! \brief Add the operations and bytes of the stages of calc_impl_cells for one block of cells.
+*
+*   It follows the loops of cpu_kernels.cpp with the default configuration (only_tke, mixing length
+*   choice 2, Neumann boundary conditions) in the steady state, where the geometry cache is valid.
+*   The tridiagonal solve is the Thomas algorithm.
+*/
+static void model_cells_block(const int *dolic_c, int start_index, int end_index, int nlevs, bool l_lc,
+                              t_stage_model model[timing_nstages]) {
+    double n = end_index - start_index + 1;
+    double all = (nlevs + 1) * n;
+    // wet interfaces: all (levels 0..dolic), inner (1..dolic-1), cell levels (0..dolic-1)
+    // and inner levels above the bottom one (1..dolic-2)
+    double wet = 0.0, inner = 0.0, cell_levels = 0.0, inner_above = 0.0;
+    int max_levels = 0;
+    for (int jc = start_index; jc <= end_index; jc++) {
+        int dolic = dolic_c[jc];
+        wet += dolic + 1;
+        inner += std::max(0, dolic - 1);
+        cell_levels += dolic;
+        inner_above += std::max(0, dolic - 2);
+        max_levels = std::max(max_levels, dolic);
+    }
+    double block_levels = (max_levels + 1) * n;
+
+    // geometry cache check, initialization, copy of tke and surface forcing
+    model[timing_pre_integration].flops += 7.0 * n;
+    model[timing_pre_integration].bytes += 16.0 * n + 40.0 * all + 32.0 * n;
+
+    // two densities, vertical shear and stratification per inner interface
+    model[timing_nsqr_ssqr].flops += (2.0 * density_flops + 14.0) * inner;
+    model[timing_nsqr_ssqr].bytes += 64.0 * inner + 4.0 * n;
+
+    // initial mixing length on all the levels and the mxl_2 limiters
+    model[timing_mixing_length].flops += 4.0 * all + inner + n + inner_above;
+    model[timing_mixing_length].bytes += 40.0 * all + 40.0 * n + 24.0 * inner + 24.0 * inner_above + 16.0 * wet;
+
+    // Av, Pr and kv per wet interface
+    model[timing_diffusivity].flops += 5.0 * wet;
+    model[timing_diffusivity].bytes += 56.0 * wet;
+
+    // shear and buoyancy production
+    model[timing_forcing].flops += (l_lc ? 4.0 : 3.0) * wet;
+    model[timing_forcing].bytes += (l_lc ? 64.0 : 56.0) * wet;
+
+    // diffusion coefficients, copy of tke, boundary conditions and tridiagonal matrix
+    model[timing_tridiag_build].flops += 5.0 * cell_levels + 5.0 * inner + 2.0 * cell_levels + 9.0 * n +
+                                         4.0 * all + 4.0 * inner + 2.0 * wet;
+    model[timing_tridiag_build].bytes += 40.0 * cell_levels + 32.0 * inner + 32.0 * cell_levels + 16.0 * n +
+                                         16.0 * block_levels + 88.0 * n + 48.0 * all + 32.0 * inner +
+                                         24.0 * wet;
+
+    // forward elimination and back substitution
+    model[timing_solve].flops += 9.0 * wet;
+    model[timing_solve].bytes += 72.0 * wet;
+
+    // diffusion and dissipation tendencies, restriction of tke and diagnostics
+    model[timing_diagnostics].flops += 5.0 * inner + 8.0 * n + 3.0 * inner + 3.0 * wet + 2.0 * block_levels +
+                                       4.0 * n + 2.0 * all;
+    model[timing_diagnostics].bytes += 40.0 * inner + 80.0 * n + 8.0 * all + 32.0 * inner + 16.0 * all +
+                                       16.0 * wet + 40.0 * wet + 24.0 * block_levels + 32.0 * n + 24.0 * all +
+                                       16.0 * (all - wet) + 48.0 * all;
+}
+
+/*! \brief Add the operations and bytes of calc_impl_edges_gather for one block of edges.
+*
+*   The two offsets of the gather table and the fused block are read instead of the cell indices and blocks.
+*/
+static void model_edges_block(const int *dolic_e, int start_index, int end_index, int nlevs,
+                              t_stage_model *model) {
+    double n = end_index - start_index + 1;
+    double wet = 0.0;
+    for (int je = start_index; je <= end_index; je++)
+        wet += std::max(0, dolic_e[je] - 1);
+    model->flops += 2.0 * wet;
+    model->bytes += 4.0 * n + 12.0 * n + 8.0 * nlevs * n + 16.0 * wet;
+}
+
+/*! \brief Model of all the stages for one time step of the synthetic input.
+*
+*/
+static std::vector<t_stage_model> model_step(const synthetic_input &input, bool l_lc) {
+    std::vector<t_stage_model> model(timing_nstages);
+    const t_index_range &range = input.range;
+    for (int jb = range.cells_start_block; jb <= range.cells_end_block; jb++) {
+        int start_index, end_index;
+        get_index_range(range.cells_block_size, range.cells_start_block, range.cells_end_block,
+                        range.cells_start_index, range.cells_end_index, jb, &start_index, &end_index);
+        model_cells_block(&input.p_patch.dolic_c[jb * input.nproma], start_index, end_index, input.nlevs, l_lc,
+                          model.data());
+    }
+    for (int jb = range.edges_start_block; jb <= range.edges_end_block; jb++) {
+        int start_index, end_index;
+        get_index_range(range.edges_block_size, range.edges_start_block, range.edges_end_block,
+                        range.edges_start_index, range.edges_end_index, jb, &start_index, &end_index);
+        model_edges_block(&input.p_patch.dolic_e[jb * input.nproma], start_index, end_index, input.nlevs,
+                          &model[timing_edges]);
+    }
+    return model;
+}
+
+static int max_threads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/*! \brief Memory bandwidth (bytes/s) of all the threads measured with the STREAM triad.
+*
+*   The arrays are initialized by the same threads which use them. The best of 10 repetitions is taken.
+*/
+static double stream_bandwidth(size_t size) {
+    double *a = new double[size];
+    double *b = new double[size];
+    double *c = new double[size];
+    long long n = static_cast<long long>(size);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long long i = 0; i < n; i++) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+
+    double best = std::numeric_limits<double>::max();
+    for (int repetition = 0; repetition < 10; repetition++) {
+        auto start = std::chrono::steady_clock::now();
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static)
+#endif
+        for (long long i = 0; i < n; i++)
+            a[i] = b[i] + 3.0 * c[i];
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    // keep the stores alive
+    if (a[n / 2] != 7.0)
+        std::cerr << "yaop_roofline: unexpected STREAM triad result" << std::endl;
+
+    delete[] a;
+    delete[] b;
+    delete[] c;
+    return 24.0 * size / best;
+}
+
+/*! \brief Double precision peak (flop/s) of all the threads.
+*
+*   Each thread updates independent multiply-add chains which stay in registers or in L1, so the
+*   result is the peak reachable with the compiler flags of the benchmarks (FMA and vector width
+*   included only when enabled by them). The best of 5 repetitions is taken.
+*/
+static double peak_flops() {
+    const int chains = 64;
+    const long long iterations = 1 << 20;
+    int nthreads = max_threads();
+    double best = std::numeric_limits<double>::max();
+    double sink = 0.0;
+    for (int repetition = 0; repetition < 5; repetition++) {
+        auto start = std::chrono::steady_clock::now();
+#ifdef _OPENMP
+        #pragma omp parallel reduction(+:sink)
+#endif
+        {
+            double x[chains];
+            for (int j = 0; j < chains; j++)
+                x[j] = 1.0 + 1.0e-3 * j;
+            for (long long it = 0; it < iterations; it++)
+                for (int j = 0; j < chains; j++)
+                    x[j] = x[j] * 0.999999 + 1.0e-6;
+            for (int j = 0; j < chains; j++)
+                sink += x[j];
+        }
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    if (sink == 0.0)
+        std::cerr << "yaop_roofline: unexpected peak probe result" << std::endl;
+    return 2.0 * chains * iterations * nthreads / best;
+}
+
+static void write_text(std::ostream &out, const std::vector<t_stage_result> &results, double peak,
+                       double bandwidth, int nthreads) {
+    out << "ceilings per thread (" << nthreads << " threads): peak " << std::fixed << std::setprecision(2)
+        << peak * 1.0e-9 << " GFLOP/s, bandwidth " << bandwidth * 1.0e-9 << " GB/s, ridge point "
+        << peak / bandwidth << " flop/byte" << std::endl;
+    out << std::left << std::setw(16) << "stage" << std::right << std::setw(14) << "MFLOP/step"
+        << std::setw(12) << "MB/step" << std::setw(10) << "flop/B" << std::setw(12) << "ms/step"
+        << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s" << std::setw(12) << "attainable"
+        << std::setw(10) << "% roof" << "  bound" << std::endl;
+    for (const t_stage_result &result : results)
+        out << std::left << std::setw(16) << result.name << std::right << std::setprecision(3)
+            << std::setw(14) << result.model.flops * 1.0e-6 << std::setw(12) << result.model.bytes * 1.0e-6
+            << std::setw(10) << result.intensity << std::setw(12) << result.seconds * 1.0e3
+            << std::setw(10) << result.gflops << std::setw(10) << result.gbytes
+            << std::setw(12) << result.attainable << std::setprecision(1) << std::setw(10)
+            << 100.0 * result.fraction << "  " << (result.memory_bound ? "memory" : "compute") << std::endl;
+}
+
+static void write_csv(std::ostream &out, const std::vector<t_stage_result> &results, double peak,
+                      double bandwidth, int nthreads) {
+    out << "stage,flops_per_step,bytes_per_step,intensity,seconds_per_step,gflops,gbytes,attainable_gflops,"
+        << "fraction_of_roof,bound,threads,peak_gflops,bandwidth_gbytes" << std::endl;
+    for (const t_stage_result &result : results)
+        out << result.name << "," << result.model.flops << "," << result.model.bytes << ","
+            << result.intensity << "," << result.seconds << "," << result.gflops << "," << result.gbytes << ","
+            << result.attainable << "," << result.fraction << "," << (result.memory_bound ? "memory" : "compute")
+            << "," << nthreads << "," << peak * 1.0e-9 << "," << bandwidth * 1.0e-9 << std::endl;
+}
+
+static void write_json(std::ostream &out, const std::vector<t_stage_result> &results, double peak,
+                       double bandwidth, int nthreads) {
+    out << "{" << std::endl
+        << "  \"threads\": " << nthreads << "," << std::endl
+        << "  \"peak_gflops_per_thread\": " << peak * 1.0e-9 << "," << std::endl
+        << "  \"bandwidth_gbytes_per_thread\": " << bandwidth * 1.0e-9 << "," << std::endl
+        << "  \"stages\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const t_stage_result &result = results[i];
+        out << "    {\"stage\": \"" << result.name << "\", \"flops_per_step\": " << result.model.flops
+            << ", \"bytes_per_step\": " << result.model.bytes << ", \"intensity\": " << result.intensity
+            << ", \"seconds_per_step\": " << result.seconds << ", \"gflops\": " << result.gflops
+            << ", \"gbytes\": " << result.gbytes << ", \"attainable_gflops\": " << result.attainable
+            << ", \"fraction_of_roof\": " << result.fraction
+            << ", \"bound\": \"" << (result.memory_bound ? "memory" : "compute") << "\"}"
+            << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl << "}" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    t_roofline_options options = parse_options(argc, argv);
+    int nthreads = max_threads();
+
+    // ceilings of the node, shared evenly by the threads
+    std::cerr << "yaop_roofline: measuring the ceilings with " << nthreads << " threads" << std::endl;
+    double peak = peak_flops() / nthreads;
+    double bandwidth = stream_bandwidth(options.stream_size) / nthreads;
+
+    synthetic_input input(options.ncells, options.nlevs, options.nproma);
+    double OceanReferenceDensity = 1025.022;
+    double grav = 9.80665;
+    double ReferencePressureIndbars = 1035.0*grav*1.0e-4;
+    double pi = 3.14159265358979323846264338327950288;
+    int l_lc = 0;
+    YAOP ocean_physics(options.nproma, options.nlevs, input.nblocks, 2, 4, 0, 600.0, OceanReferenceDensity, grav,
+                       l_lc, 0.15, ReferencePressureIndbars, pi);
+    input.register_fields(&ocean_physics);
+
+    for (int t = 0; t < options.warmup; t++)
+        ocean_physics.step(input.range);
+    ocean_physics.reset_timing();
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < options.steps; t++)
+        ocean_physics.step(input.range);
+    auto end = std::chrono::steady_clock::now();
+    t_timing_report report = ocean_physics.timing_report();
+
+    std::vector<t_stage_model> model = model_step(input, l_lc != 0);
+    t_stage_model total;
+    for (int stage = timing_pre_integration; stage <= timing_edges; stage++) {
+        total.flops += model[stage].flops;
+        total.bytes += model[stage].bytes;
+    }
+
+    // the stage timers are summed over the threads, so the rates are per thread as the ceilings
+    std::vector<t_stage_result> results;
+    for (int stage = timing_pre_integration; stage <= timing_nstages; stage++) {
+        t_stage_result result;
+        if (stage < timing_nstages) {
+            // the stages which are not part of the tke step (e.g. idemix) are not modelled
+            if (!report.enabled || model[stage].bytes == 0.0)
+                continue;
+            result.name = YAOP::timing_stage_name(stage);
+            result.model = model[stage];
+            result.seconds = report.seconds[stage] / options.steps;
+        } else {
+            result.name = "step";
+            result.model = total;
+            result.seconds = std::chrono::duration<double>(end - start).count() * nthreads / options.steps;
+        }
+        result.intensity = result.model.flops / result.model.bytes;
+        result.gflops = result.model.flops / result.seconds * 1.0e-9;
+        result.gbytes = result.model.bytes / result.seconds * 1.0e-9;
+        result.memory_bound = result.intensity * bandwidth < peak;
+        result.attainable = std::min(peak, result.intensity * bandwidth) * 1.0e-9;
+        result.fraction = result.gflops / result.attainable;
+        results.push_back(result);
+    }
+    if (!report.enabled)
+        std::cerr << "yaop_roofline: library built without ENABLE_TIMING, only the whole step is reported"
+                  << std::endl;
+
+    std::ofstream ofile;
+    if (!options.output.empty()) {
+        ofile.open(options.output);
+        if (!ofile) {
+            std::cerr << "yaop_roofline: cannot open " << options.output << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream &out = options.output.empty() ? std::cout : ofile;
+    if (options.format == "json")
+        write_json(out, results, peak, bandwidth, nthreads);
+    else if (options.format == "csv")
+        write_csv(out, results, peak, bandwidth, nthreads);
+    else
+        write_text(out, results, peak, bandwidth, nthreads);
+
+    return 0;
+}
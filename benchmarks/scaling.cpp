@@ -0,0 +1,234 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "src/YAOP.hpp"
+#include "src/shared/synthetic_input.hpp"
+
+/*! \brief Options of the scaling driver.
+*
+*   Every combination of ncells, nproma and threads is a configuration. With weak scaling
+*   ncells is the number of cells per thread.
+*/
+struct t_scaling_options {
+    std::vector<int> threads = {1, 2, 4, 8};
+    std::vector<int> nproma = {32, 128, 512};
+    std::vector<int> ncells = {20480, 81920};
+    int nlevs = 64;
+    int warmup = 2;
+    int steps = 10;
+    bool weak = false;
+    std::string format = "csv";
+    std::string output;
+};
+
+// Measurements of one configuration
+struct t_scaling_result {
+    int ncells, nproma, nlevs, threads;
+    double time_per_step, time_per_step_min, cells_per_second, efficiency;
+    size_t input_bytes, max_rss_bytes;
+};
+
+static std::vector<int> parse_list(const char *arg) {
+    std::vector<int> values;
+    std::stringstream stream(arg);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        values.push_back(std::atoi(item.c_str()));
+    return values;
+}
+
+static void usage() {
+    std::cerr << "Usage: yaop_scaling [--threads 1,2,4] [--nproma 32,128] [--ncells 20480,81920]" << std::endl
+              << "                    [--nlevs 64] [--warmup 2] [--steps 10] [--weak]" << std::endl
+              << "                    [--format csv|json] [--output file]" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+static t_scaling_options parse_options(int argc, char **argv) {
+    t_scaling_options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--weak")
+            options.weak = true;
+        else if (arg == "--threads" && has_value)
+            options.threads = parse_list(argv[++i]);
+        else if (arg == "--nproma" && has_value)
+            options.nproma = parse_list(argv[++i]);
+        else if (arg == "--ncells" && has_value)
+            options.ncells = parse_list(argv[++i]);
+        else if (arg == "--nlevs" && has_value)
+            options.nlevs = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && has_value)
+            options.warmup = std::atoi(argv[++i]);
+        else if (arg == "--steps" && has_value)
+            options.steps = std::atoi(argv[++i]);
+        else if (arg == "--format" && has_value)
+            options.format = argv[++i];
+        else if (arg == "--output" && has_value)
+            options.output = argv[++i];
+        else
+            usage();
+    }
+    if (options.format != "csv" && options.format != "json")
+        usage();
+    if (options.output.empty())
+        options.output = "yaop_scaling." + options.format;
+    if (options.steps < 1 || options.warmup < 0 || options.nlevs < 1)
+        usage();
+    return options;
+}
+
+static size_t max_rss_bytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // kilobytes on Linux
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+/*! \brief Run one configuration: warm-up steps and then timed steps on synthetic input.
+*
+*/
+static t_scaling_result run_configuration(int ncells, int nproma, int nlevs, int threads,
+                                          int warmup, int steps) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    synthetic_input input(ncells, nlevs, nproma);
+
+    double OceanReferenceDensity = 1025.022;
+    double grav = 9.80665;
+    double ReferencePressureIndbars = 1035.0*grav*1.0e-4;
+    double pi = 3.14159265358979323846264338327950288;
+    YAOP ocean_physics(nproma, nlevs, input.nblocks, 2, 4, 0, 600.0, OceanReferenceDensity, grav,
+                       0, 0.15, ReferencePressureIndbars, pi);
+    input.register_fields(&ocean_physics);
+
+    for (int t = 0; t < warmup; t++)
+        ocean_physics.step(input.range);
+
+    double time_total = 0.0;
+    double time_min = 0.0;
+    for (int t = 0; t < steps; t++) {
+        auto start = std::chrono::steady_clock::now();
+        ocean_physics.step(input.range);
+        auto end = std::chrono::steady_clock::now();
+        double time_step = std::chrono::duration<double>(end - start).count();
+        time_total += time_step;
+        time_min = t == 0 ? time_step : std::min(time_min, time_step);
+    }
+
+    t_scaling_result result;
+    result.ncells = ncells;
+    result.nproma = nproma;
+    result.nlevs = nlevs;
+    result.threads = threads;
+    result.time_per_step = time_total / steps;
+    result.time_per_step_min = time_min;
+    result.cells_per_second = ncells / result.time_per_step;
+    result.efficiency = 1.0;
+    result.input_bytes = input.memory_size();
+    result.max_rss_bytes = max_rss_bytes();
+    return result;
+}
+
+static void write_csv(std::ostream &out, const std::vector<t_scaling_result> &results, bool weak) {
+    out << "scaling,ncells,nproma,nlevs,threads,time_per_step,time_per_step_min,cells_per_second,"
+        << "parallel_efficiency,input_bytes,max_rss_bytes" << std::endl;
+    for (const t_scaling_result &result : results)
+        out << (weak ? "weak" : "strong") << "," << result.ncells << "," << result.nproma << ","
+            << result.nlevs << "," << result.threads << "," << result.time_per_step << ","
+            << result.time_per_step_min << "," << result.cells_per_second << "," << result.efficiency << ","
+            << result.input_bytes << "," << result.max_rss_bytes << std::endl;
+}
+
+static void write_json(std::ostream &out, const std::vector<t_scaling_result> &results, bool weak) {
+    out << "{" << std::endl
+        << "  \"scaling\": \"" << (weak ? "weak" : "strong") << "\"," << std::endl
+        << "  \"configurations\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const t_scaling_result &result = results[i];
+        out << "    {\"ncells\": " << result.ncells << ", \"nproma\": " << result.nproma
+            << ", \"nlevs\": " << result.nlevs << ", \"threads\": " << result.threads
+            << ", \"time_per_step\": " << result.time_per_step
+            << ", \"time_per_step_min\": " << result.time_per_step_min
+            << ", \"cells_per_second\": " << result.cells_per_second
+            << ", \"parallel_efficiency\": " << result.efficiency
+            << ", \"input_bytes\": " << result.input_bytes
+            << ", \"max_rss_bytes\": " << result.max_rss_bytes << "}"
+            << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl << "}" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    t_scaling_options options = parse_options(argc, argv);
+
+#ifndef _OPENMP
+    if (std::any_of(options.threads.begin(), options.threads.end(), [](int threads) { return threads != 1; })) {
+        std::cerr << "yaop_scaling: library built without OpenMP, running with 1 thread only" << std::endl;
+        options.threads = {1};
+    }
+#endif
+
+    std::vector<t_scaling_result> results;
+    for (int ncells : options.ncells) {
+        for (int nproma : options.nproma) {
+            // the first thread count of the list is the reference for the parallel efficiency
+            size_t reference = results.size();
+            for (int threads : options.threads) {
+                int ncells_total = options.weak ? ncells * threads : ncells;
+                std::cerr << "yaop_scaling: ncells " << ncells_total << " nproma " << nproma
+                          << " threads " << threads << std::endl;
+                t_scaling_result result = run_configuration(ncells_total, nproma, options.nlevs, threads,
+                                                            options.warmup, options.steps);
+                const t_scaling_result &base = results.size() > reference ? results[reference] : result;
+                if (options.weak)
+                    result.efficiency = base.time_per_step / result.time_per_step;
+                else
+                    result.efficiency = (base.time_per_step * base.threads) /
+                                        (result.time_per_step * result.threads);
+                results.push_back(result);
+            }
+        }
+    }
+
+    std::ofstream out(options.output);
+    if (!out) {
+        std::cerr << "yaop_scaling: cannot open " << options.output << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (options.format == "json")
+        write_json(out, results, options.weak);
+    else
+        write_csv(out, results, options.weak);
+    std::cerr << "yaop_scaling: results written to " << options.output << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <benchmark/benchmark.h>
+#include "src/YAOP.hpp"
+#include "src/shared/synthetic_input.hpp"
+
+// Number of cells of the benchmark domain, large enough to not fit in the caches
+constexpr int ncells = 20480;
+
+/*! \brief Run a time step of the schemes on synthetic input and report the throughput.
+*
+*   The YAOP instance is created, configured and warmed up outside of the timed loop, prepare is called
+*   before each step without being timed. With is_idemix the tke scheme is forced by IDEMIX and its fields
+*   are registered. The number of threads is the OpenMP default one.
+*/
+template <class Step>
+void run_step(benchmark::State &state, Step step, void (*prepare)(YAOP *, const t_index_range &) = nullptr,
+              bool is_idemix = false, void (*configure)(YAOP *) = nullptr) {
+    int nproma = state.range(0);
+    int nlevs = state.range(1);
+    synthetic_input input(ncells, nlevs, nproma);
+
+    double OceanReferenceDensity = 1025.022;
+    double grav = 9.80665;
+    double ReferencePressureIndbars = 1035.0*grav*1.0e-4;
+    double pi = 3.14159265358979323846264338327950288;
+    int vmix_idemix_tke = 4;
+    YAOP ocean_physics(nproma, nlevs, input.nblocks, is_idemix ? vmix_idemix_tke : 2, vmix_idemix_tke, 0, 600.0,
+                       OceanReferenceDensity, grav, 0, 0.15, ReferencePressureIndbars, pi);
+    if (configure != nullptr)
+        configure(&ocean_physics);
+    input.register_fields(&ocean_physics);
+    if (is_idemix)
+        input.register_idemix_fields(&ocean_physics);
+    step(&ocean_physics, input.range);
+
+    for (auto _ : state) {
+        if (prepare != nullptr) {
+            state.PauseTiming();
+            prepare(&ocean_physics, input.range);
+            state.ResumeTiming();
+        }
+        step(&ocean_physics, input.range);
+        benchmark::ClobberMemory();
+    }
+
+    // reported as cells/s
+    state.counters["cells"] = benchmark::Counter(ncells, benchmark::Counter::kIsIterationInvariantRate,
+                                                 benchmark::Counter::kIs1000);
+}
+
+// tke scheme, computing the vertical stability
+static void BM_step_tke(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->step(range);
+    });
+}
+
+// PP scheme, computing the vertical stability
+static void BM_calc_pp(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->calc_pp(range);
+    });
+}
+
+// PP scheme on the vertical stability published by calc_vertical_stability, which is not timed
+static void BM_calc_pp_shared_stability(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->calc_pp(range);
+    }, [](YAOP *yaop, const t_index_range &range) {
+        yaop->calc_vertical_stability(range);
+    });
+}
+
+// both schemes in the same time step, sharing the vertical stability
+static void BM_step_tke_pp(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->calc_vertical_stability(range);
+        yaop->step(range);
+        yaop->calc_pp(range);
+    });
+}
+
+// IDEMIX and then tke, the dissipation is passed through iwe_Tdis
+static void BM_calc_idemix_then_step(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->calc_idemix(range);
+        yaop->step(range);
+    }, nullptr, true);
+}
+
+// IDEMIX and tke coupled block by block, the dissipation is passed through the block scratch
+static void BM_step_idemix_tke(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->step_idemix_tke(range);
+    }, nullptr, true);
+}
+
+// four tke steps, one call each
+static void BM_step_tke_x4(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        for (int substep = 0; substep < 4; substep++)
+            yaop->step(range);
+    });
+}
+
+// four tke substeps in one call, sharing the geometry and the vertical stability
+static void BM_step_tke_substeps_4(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->step(range, 4, 4 * 600.0);
+    });
+}
+
+// tke scheme skipping the quiescent blocks, with a full step every 10 steps
+static void BM_step_tke_quiescent(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->step(range);
+    }, nullptr, false, [](YAOP *yaop) { yaop->set_quiescence(1.0e-6); });
+}
+
+// tke scheme computing the edges with both neighbours in a cell block right after the block
+static void BM_step_tke_fused_edges(benchmark::State &state) {
+    run_step(state, [](YAOP *yaop, const t_index_range &range) {
+        yaop->step(range);
+    }, nullptr, false, [](YAOP *yaop) { yaop->set_fuse_edges(true); });
+}
+
+#define STEP_BENCHMARK(name)                                                  \
+    BENCHMARK(name)->ArgNames({"nproma", "nlevs"})                            \
+                   ->ArgsProduct({{32, 128, 512}, {40, 64, 128}})            \
+                   ->Unit(benchmark::kMillisecond)->UseRealTime()
+
+STEP_BENCHMARK(BM_step_tke);
+STEP_BENCHMARK(BM_calc_pp);
+STEP_BENCHMARK(BM_calc_pp_shared_stability);
+STEP_BENCHMARK(BM_step_tke_pp);
+STEP_BENCHMARK(BM_calc_idemix_then_step);
+STEP_BENCHMARK(BM_step_idemix_tke);
+STEP_BENCHMARK(BM_step_tke_x4);
+STEP_BENCHMARK(BM_step_tke_substeps_4);
+STEP_BENCHMARK(BM_step_tke_quiescent);
+STEP_BENCHMARK(BM_step_tke_fused_edges);
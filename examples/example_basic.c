@@ -46,9 +46,9 @@ int main(int argc, char ** argv) {
     double ReferencePressureIndbars = 1035.0*grav*1.0e-4;
     double pi = 3.14159265358979323846264338327950288;
 
-    YAOP_Init(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke,
-             vert_cor_type, dtime, OceanReferenceDensity, grav,
-             l_lc, clc, ReferencePressureIndbars, pi);
+    YAOP_Handle *yaop = YAOP_Init(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke,
+                                  vert_cor_type, dtime, OceanReferenceDensity, grav,
+                                  l_lc, clc, ReferencePressureIndbars, pi);
 
     double *depth_CellInterface = malloc(nproma * (nlevs+1) * nblocks * sizeof(double));
     double *prism_center_dist_c = malloc(nproma * (nlevs+1) * nblocks * sizeof(double));
@@ -146,7 +146,7 @@ int main(int argc, char ** argv) {
       #pragma acc host_data use_device(tke_Tiwf, tke_Tbck, tke_Ttot, tke_Lmix, tke_Pr, temp, salt)
       #pragma acc host_data use_device(stretch_c, eta_c, stress_xw, stress_yw, fu10, concsum)
       #pragma acc host_data use_device(p_vn_x1, p_vn_x2, p_vn_x3)
-      YAOP_Calc_tke(depth_CellInterface, prism_center_dist_c,
+      YAOP_Calc_tke(yaop, depth_CellInterface, prism_center_dist_c,
                     inv_prism_center_dist_c, prism_thick_c,
                     dolic_c, dolic_e, zlev_i, wet_c,
                     edges_cell_idx, edges_cell_blk,
@@ -168,7 +168,7 @@ int main(int argc, char ** argv) {
       #pragma acc wait
     }
 
-    YAOP_Finalize();
+    YAOP_Finalize(yaop);
 
     #pragma acc exit data delete(depth_CellInterface, prism_center_dist_c, inv_prism_center_dist_c)
     #pragma acc exit data delete(prism_thick_c, dolic_c, dolic_e, zlev_i, wet_c, edges_cell_idx, edges_cell_blk)
@@ -50,6 +50,8 @@ program main
 
     integer :: i, j, k, t
 
+    type(t_yaop) :: yaop
+
     real(dp), allocatable, dimension(:,:,:) :: tke
     integer, allocatable, dimension(:,:) :: dolic_c
 
@@ -166,7 +168,7 @@ program main
 
     allocate(concsum(nproma, nblocks))
 
-    CALL YAOP_Init_f(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, &
+    CALL YAOP_Init_f(yaop, nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, &
                     vert_cor_type, dtime, OceanReferenceDensity, grav, &
                     l_lc, clc, ReferencePressureIndbars, pi)
 
@@ -201,7 +203,7 @@ program main
         !$ACC                      stress_xw, stress_yw, &
         !$ACC                      fu10, &
         !$ACC                      concsum)
-        CALL YAOP_Calc_tke_f(depth_CellInterface, prism_center_dist_c, &
+        CALL YAOP_Calc_tke_f(yaop, depth_CellInterface, prism_center_dist_c, &
                         inv_prism_center_dist_c, prism_thick_c, &
                         dolic_c, dolic_e, zlev_i, wet_c, &
                         edges_cell_idx, edges_cell_blk, &
@@ -223,7 +225,7 @@ program main
         !$ACC WAIT
     end do
 
-    CALL YAOP_Finalize_f()
+    CALL YAOP_Finalize_f(yaop)
 
     !$ACC EXIT DATA DELETE(depth_CellInterface, prism_center_dist_c, inv_prism_center_dist_c, prism_thick_c, &
     !$ACC                  dolic_c, dolic_e, zlev_i, wet_c, edges_cell_idx, edges_cell_blk)
@@ -16,19 +16,157 @@
 
 #include "src/YAOP.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "src/backends/TKE_backend.hpp"
+#include "src/backends/PP_backend.hpp"
+#include "src/shared/snapshot.hpp"
 #ifdef CUDA
 #include "src/backends/GPU/TKE_gpu.hpp"
 #else
 #include "src/backends/CPU/TKE_cpu.hpp"
+#include "src/backends/CPU/PP_cpu.hpp"
 #endif
 
+struct t_buffer_set {
+  struct t_patch p_patch;
+  struct t_cvmix p_cvmix;
+  struct t_sea_ice p_sea_ice;
+  struct t_atmos_for_ocean p_as;
+  struct t_atmo_fluxes atmos_fluxes;
+  struct t_ocean_state ocean_state;
+  struct t_idemix p_idemix;
+  struct t_horizontal_grid p_horizontal_grid;
+};
+
+// Bound pointer location and expected (C order) shape of a field
+template <class T>
+struct t_field_slot {
+  T **data;
+  std::vector<int> shape;
+  // bytes of the registered shape, 0 if the field is bound without a shape
+  size_t registered_bytes = 0;
+};
+
 struct YAOP::Impl {
   TKE_backend::Ptr backend_tke;
+  // PP backend, created at the first calc_pp call
+  PP_backend::Ptr backend_pp;
+  // Generation of the vertical stability read by the last calc_pp call
+  int64_t pp_stability_generation = 0;
+  // Fields name to field slot
+  std::unordered_map<std::string, t_field_slot<double>> double_fields;
+  std::unordered_map<std::string, t_field_slot<int>> int_fields;
+  std::vector<t_buffer_set> buffer_sets;
+  // Constructor parameters and step calls, for the snapshot capture
+  t_snapshot_params params;
+  int64_t ncalls = 0;
+  int64_t capture_call = 0;
+  std::string capture_file;
+
+  // The bound pointers changed: the memory views of all the schemes have to be rebuilt
+  void invalidate_views() {
+      backend_tke->invalidate_views();
+      if (backend_pp)
+          backend_pp->invalidate_views();
+  }
 };
 
+// Check the layout of a registered field against the expected one.
+// Only contiguous layouts are supported because the memory views are built on top of
+// the memory with the default layout. The outermost dimension can be larger than expected.
+template <class T>
+static void check_field_layout(const std::string &name, const t_field_slot<T> &slot,
+                               int ndims, const int *shape, const int *strides) {
+    bool is_valid = (ndims == static_cast<int>(slot.shape.size()));
+    for (int d = 0; is_valid && d < ndims; d++) {
+        if (d == 0)
+            is_valid = (shape[d] >= slot.shape[d]);
+        else
+            is_valid = (shape[d] == slot.shape[d]);
+    }
+    if (!is_valid) {
+        std::cerr << "YAOP: field " << name << " registered with wrong shape (";
+        for (int d = 0; d < ndims; d++)
+            std::cerr << shape[d] << (d < ndims-1 ? ", " : "");
+        std::cerr << "), expected (";
+        for (size_t d = 0; d < slot.shape.size(); d++)
+            std::cerr << slot.shape[d] << (d < slot.shape.size()-1 ? ", " : "");
+        std::cerr << ")" << std::endl;
+        abort();
+    }
+
+    if (strides != nullptr) {
+        int contiguous_stride = 1;
+        for (int d = ndims-1; d >= 0; d--) {
+            if (strides[d] != contiguous_stride) {
+                std::cerr << "YAOP: field " << name << " is not contiguous, "
+                          << "only contiguous layouts are supported" << std::endl;
+                abort();
+            }
+            contiguous_stride *= shape[d];
+        }
+    }
+}
+
+// Add the bound fields to the memory report, with the registered shape or the expected one
+template <class T>
+static void add_registered_fields(const std::unordered_map<std::string, t_field_slot<T>> &fields,
+                                  t_memory_report *report) {
+    for (const auto &field : fields) {
+        if (*field.second.data == nullptr)
+            continue;
+        size_t bytes = field.second.registered_bytes;
+        if (bytes == 0) {
+            bytes = sizeof(T);
+            for (int dim : field.second.shape)
+                bytes *= static_cast<size_t>(dim);
+        }
+        report->registered_fields.push_back({field.first.c_str(), bytes});
+        report->registered_bytes += bytes;
+    }
+}
+
+// Add the bound fields to a snapshot, with the expected shape
+template <class T>
+static void add_snapshot_fields(const std::unordered_map<std::string, t_field_slot<T>> &fields,
+                                t_snapshot_type type, std::vector<t_snapshot_field> *snapshot_fields) {
+    for (const auto &field : fields) {
+        if (*field.second.data == nullptr)
+            continue;
+        size_t bytes = sizeof(T);
+        for (int dim : field.second.shape)
+            bytes *= static_cast<size_t>(dim);
+        snapshot_fields->push_back({field.first, type, field.second.shape, *field.second.data, bytes});
+    }
+}
+
+// Structures of pointers are compared bitwise (they contain only pointers)
+template <class T>
+static bool is_struct_changed(const T &lhs, const T &rhs) {
+    return std::memcmp(&lhs, &rhs, sizeof(T)) != 0;
+}
+
+// IDEMIX reads its own fields and the horizontal grid, which are not needed by the tke scheme
+static void check_idemix_fields(const t_idemix &p_idemix, const t_horizontal_grid &p_grid) {
+    bool is_bound = p_idemix.iwe != nullptr && p_idemix.forc_iw_surface != nullptr &&
+                    p_idemix.forc_iw_bottom != nullptr && p_grid.f_c != nullptr && p_grid.cells_area != nullptr &&
+                    p_grid.cells_edge_idx != nullptr && p_grid.cells_edge_blk != nullptr &&
+                    p_grid.cells_edge_orientation != nullptr && p_grid.edges_primal_edge_length != nullptr &&
+                    p_grid.edges_dual_edge_length != nullptr;
+    if (!is_bound) {
+        std::cerr << "YAOP: the IDEMIX fields and the horizontal grid have to be registered" << std::endl;
+        abort();
+    }
+}
+
 YAOP::YAOP(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemix_tke,
          int vert_cor_type, double dtime, double OceanReferenceDensity, double grav,
          int l_lc, double clc, double ReferencePressureIndbars, double pi)
@@ -45,11 +183,95 @@ YAOP::YAOP(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemi
                                        dtime, OceanReferenceDensity, grav, l_lc, clc,
                                        ReferencePressureIndbars, pi));
 #endif
-    m_is_struct_init = false;
+    m_impl->params = {nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, vert_cor_type, l_lc, 1,
+                      dtime, OceanReferenceDensity, grav, clc, ReferencePressureIndbars, pi};
+    const char *capture_step = std::getenv("YAOP_CAPTURE_STEP");
+    if (capture_step != nullptr) {
+        const char *capture_file = std::getenv("YAOP_CAPTURE_FILE");
+        capture(std::atoi(capture_step), capture_file ? capture_file : "yaop_capture.bin");
+    }
+
+    std::memset(&p_patch, 0, sizeof(p_patch));
+    std::memset(&p_cvmix, 0, sizeof(p_cvmix));
+    std::memset(&p_sea_ice, 0, sizeof(p_sea_ice));
+    std::memset(&p_as, 0, sizeof(p_as));
+    std::memset(&atmos_fluxes, 0, sizeof(atmos_fluxes));
+    std::memset(&ocean_state, 0, sizeof(ocean_state));
+    std::memset(&p_idemix, 0, sizeof(p_idemix));
+    std::memset(&p_horizontal_grid, 0, sizeof(p_horizontal_grid));
+
+    m_impl->double_fields = {
+        {"depth_CellInterface", {&p_patch.depth_CellInterface, {nblocks, nlevs+1, nproma}}},
+        {"prism_center_dist_c", {&p_patch.prism_center_dist_c, {nblocks, nlevs+1, nproma}}},
+        {"inv_prism_center_dist_c", {&p_patch.inv_prism_center_dist_c, {nblocks, nlevs+1, nproma}}},
+        {"prism_thick_c", {&p_patch.prism_thick_c, {nblocks, nlevs, nproma}}},
+        {"zlev_i", {&p_patch.zlev_i, {nlevs}}},
+        {"wet_c", {&p_patch.wet_c, {nblocks, nlevs, nproma}}},
+        {"tke", {&p_cvmix.tke, {nblocks, nlevs+1, nproma}}},
+        {"tke_plc", {&p_cvmix.tke_plc, {nblocks, nlevs+1, nproma}}},
+        {"hlc", {&p_cvmix.hlc, {nblocks, nproma}}},
+        {"wlc", {&p_cvmix.wlc, {nblocks, nlevs+1, nproma}}},
+        {"u_stokes", {&p_cvmix.u_stokes, {nblocks, nproma}}},
+        {"a_veloc_v", {&p_cvmix.a_veloc_v, {nblocks, nlevs+1, nproma}}},
+        {"a_temp_v", {&p_cvmix.a_temp_v, {nblocks, nlevs+1, nproma}}},
+        {"a_salt_v", {&p_cvmix.a_salt_v, {nblocks, nlevs+1, nproma}}},
+        {"iwe_Tdis", {&p_cvmix.iwe_Tdis, {nblocks, nlevs+1, nproma}}},
+        {"cvmix_dummy_1", {&p_cvmix.cvmix_dummy_1, {nblocks, nlevs+1, nproma}}},
+        {"cvmix_dummy_2", {&p_cvmix.cvmix_dummy_2, {nblocks, nlevs+1, nproma}}},
+        {"cvmix_dummy_3", {&p_cvmix.cvmix_dummy_3, {nblocks, nlevs+1, nproma}}},
+        {"tke_Tbpr", {&p_cvmix.tke_Tbpr, {nblocks, nlevs+1, nproma}}},
+        {"tke_Tspr", {&p_cvmix.tke_Tspr, {nblocks, nlevs+1, nproma}}},
+        {"tke_Tdif", {&p_cvmix.tke_Tdif, {nblocks, nlevs+1, nproma}}},
+        {"tke_Tdis", {&p_cvmix.tke_Tdis, {nblocks, nlevs+1, nproma}}},
+        {"tke_Twin", {&p_cvmix.tke_Twin, {nblocks, nlevs+1, nproma}}},
+        {"tke_Tiwf", {&p_cvmix.tke_Tiwf, {nblocks, nlevs+1, nproma}}},
+        {"tke_Tbck", {&p_cvmix.tke_Tbck, {nblocks, nlevs+1, nproma}}},
+        {"tke_Ttot", {&p_cvmix.tke_Ttot, {nblocks, nlevs+1, nproma}}},
+        {"tke_Lmix", {&p_cvmix.tke_Lmix, {nblocks, nlevs+1, nproma}}},
+        {"tke_Pr", {&p_cvmix.tke_Pr, {nblocks, nlevs+1, nproma}}},
+        {"temp", {&ocean_state.temp, {nblocks, nlevs, nproma}}},
+        {"salt", {&ocean_state.salt, {nblocks, nlevs, nproma}}},
+        {"stretch_c", {&ocean_state.stretch_c, {nblocks, nproma}}},
+        {"eta_c", {&ocean_state.eta_c, {nblocks, nproma}}},
+        {"p_vn_x1", {&ocean_state.p_vn_x1, {nblocks, nlevs, nproma}}},
+        {"p_vn_x2", {&ocean_state.p_vn_x2, {nblocks, nlevs, nproma}}},
+        {"p_vn_x3", {&ocean_state.p_vn_x3, {nblocks, nlevs, nproma}}},
+        {"stress_xw", {&atmos_fluxes.stress_xw, {nblocks, nproma}}},
+        {"stress_yw", {&atmos_fluxes.stress_yw, {nblocks, nproma}}},
+        {"fu10", {&p_as.fu10, {nblocks, nproma}}},
+        {"concsum", {&p_sea_ice.concsum, {nblocks, nproma}}},
+        {"iwe", {&p_idemix.iwe, {nblocks, nlevs+1, nproma}}},
+        {"forc_iw_surface", {&p_idemix.forc_iw_surface, {nblocks, nproma}}},
+        {"forc_iw_bottom", {&p_idemix.forc_iw_bottom, {nblocks, nproma}}},
+        {"f_c", {&p_horizontal_grid.f_c, {nblocks, nproma}}},
+        {"cells_area", {&p_horizontal_grid.cells_area, {nblocks, nproma}}},
+        {"cells_edge_orientation", {&p_horizontal_grid.cells_edge_orientation, {3, nblocks, nproma}}},
+        {"edges_primal_edge_length", {&p_horizontal_grid.edges_primal_edge_length, {nblocks, nproma}}},
+        {"edges_dual_edge_length", {&p_horizontal_grid.edges_dual_edge_length, {nblocks, nproma}}},
+    };
+    m_impl->int_fields = {
+        {"dolic_c", {&p_patch.dolic_c, {nblocks, nproma}}},
+        {"dolic_e", {&p_patch.dolic_e, {nblocks, nproma}}},
+        {"edges_cell_idx", {&p_patch.edges_cell_idx, {2, nblocks, nproma}}},
+        {"edges_cell_blk", {&p_patch.edges_cell_blk, {2, nblocks, nproma}}},
+        {"cells_edge_idx", {&p_horizontal_grid.cells_edge_idx, {3, nblocks, nproma}}},
+        {"cells_edge_blk", {&p_horizontal_grid.cells_edge_blk, {3, nblocks, nproma}}},
+    };
 }
 
 YAOP::~YAOP() {
     std::cout << "Finalizing Ocean Physics Library ... " << std::endl;
+#ifdef YAOP_TRACING
+    // only to YAOP_TRACE_FILE, with the instance number for the other instances
+    if (const char *trace_file = std::getenv("YAOP_TRACE_FILE")) {
+        static std::atomic<int> ninstances(0);
+        int instance = ninstances++;
+        std::string filename = trace_file;
+        if (instance > 0)
+            filename = filename.substr(0, filename.rfind(".json")) + "." + std::to_string(instance) + ".json";
+        dump_trace(filename);
+    }
+#endif
     delete m_impl;
 }
 
@@ -71,30 +293,270 @@ void YAOP::calc_tke(double *depth_CellInterface, double *prism_center_dist_c,
                     int edges_start_index, int edges_end_index, int cells_block_size,
                     int cells_start_block, int cells_end_block, int cells_start_index,
                     int cells_end_index) {
-    if (!m_is_struct_init) {
-        fill_struct(&p_patch, depth_CellInterface, prism_center_dist_c,
-                    inv_prism_center_dist_c, prism_thick_c, dolic_c, dolic_e,
-                    zlev_i, wet_c, edges_cell_idx, edges_cell_blk);
-        fill_struct(&p_cvmix, tke, tke_plc_in, hlc_in, wlc_in, u_stokes_in, a_veloc_v,
-                    a_temp_v, a_salt_v, iwe_Tdis, cvmix_dummy_1, cvmix_dummy_2,
-                    cvmix_dummy_3, tke_Tbpr, tke_Tspr, tke_Tdif, tke_Tdis, tke_Twin,
-                    tke_Tiwf, tke_Tbck, tke_Ttot, tke_Lmix, tke_Pr);
-        fill_struct(&ocean_state, temp, salt, stretch_c, eta_c, p_vn_x1, p_vn_x2, p_vn_x3);
-        fill_struct(&atmos_fluxes, stress_xw, stress_yw);
-        fill_struct(&p_as, fu10);
-        fill_struct(&p_sea_ice, concsum);
-        m_is_struct_init = true;
+    struct t_patch p_patch_new;
+    struct t_cvmix p_cvmix_new;
+    struct t_ocean_state ocean_state_new;
+    struct t_atmo_fluxes atmos_fluxes_new;
+    struct t_atmos_for_ocean p_as_new;
+    struct t_sea_ice p_sea_ice_new;
+    fill_struct(&p_patch_new, depth_CellInterface, prism_center_dist_c,
+                inv_prism_center_dist_c, prism_thick_c, dolic_c, dolic_e,
+                zlev_i, wet_c, edges_cell_idx, edges_cell_blk);
+    fill_struct(&p_cvmix_new, tke, tke_plc_in, hlc_in, wlc_in, u_stokes_in, a_veloc_v,
+                a_temp_v, a_salt_v, iwe_Tdis, cvmix_dummy_1, cvmix_dummy_2,
+                cvmix_dummy_3, tke_Tbpr, tke_Tspr, tke_Tdif, tke_Tdis, tke_Twin,
+                tke_Tiwf, tke_Tbck, tke_Ttot, tke_Lmix, tke_Pr);
+    fill_struct(&ocean_state_new, temp, salt, stretch_c, eta_c, p_vn_x1, p_vn_x2, p_vn_x3);
+    fill_struct(&atmos_fluxes_new, stress_xw, stress_yw);
+    fill_struct(&p_as_new, fu10);
+    fill_struct(&p_sea_ice_new, concsum);
+
+    // Memory views are rebuilt only if the model passed different pointers
+    if (is_struct_changed(p_patch, p_patch_new) || is_struct_changed(p_cvmix, p_cvmix_new) ||
+        is_struct_changed(ocean_state, ocean_state_new) || is_struct_changed(atmos_fluxes, atmos_fluxes_new) ||
+        is_struct_changed(p_as, p_as_new) || is_struct_changed(p_sea_ice, p_sea_ice_new)) {
+        p_patch = p_patch_new;
+        p_cvmix = p_cvmix_new;
+        ocean_state = ocean_state_new;
+        atmos_fluxes = atmos_fluxes_new;
+        p_as = p_as_new;
+        p_sea_ice = p_sea_ice_new;
+        m_impl->invalidate_views();
+    }
+
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    step(range);
+}
+
+void YAOP::register_field(const std::string &name, double *data, int ndims, const int *shape,
+                          const int *strides) {
+    auto field = m_impl->double_fields.find(name);
+    if (field == m_impl->double_fields.end()) {
+        std::cerr << "YAOP: unknown double field " << name << std::endl;
+        abort();
     }
+    check_field_layout(name, field->second, ndims, shape, strides);
+    *field->second.data = data;
+    field->second.registered_bytes = sizeof(double);
+    for (int d = 0; d < ndims; d++)
+        field->second.registered_bytes *= static_cast<size_t>(shape[d]);
+    m_impl->invalidate_views();
+}
 
-    m_impl->backend_tke->calc(p_patch, p_cvmix, ocean_state, atmos_fluxes, p_as, p_sea_ice,
-                          edges_block_size, edges_start_block, edges_end_block,
-                          edges_start_index, edges_end_index, cells_block_size,
-                          cells_start_block, cells_end_block, cells_start_index,
-                          cells_end_index);
+void YAOP::register_field(const std::string &name, int *data, int ndims, const int *shape,
+                          const int *strides) {
+    auto field = m_impl->int_fields.find(name);
+    if (field == m_impl->int_fields.end()) {
+        std::cerr << "YAOP: unknown int field " << name << std::endl;
+        abort();
+    }
+    check_field_layout(name, field->second, ndims, shape, strides);
+    *field->second.data = data;
+    field->second.registered_bytes = sizeof(int);
+    for (int d = 0; d < ndims; d++)
+        field->second.registered_bytes *= static_cast<size_t>(shape[d]);
+    m_impl->invalidate_views();
 }
 
-void YAOP::calc_vertical_stability() {}
+void YAOP::step(const t_index_range &range) {
+    step(range, 1, m_impl->params.dtime);
+}
 
-void YAOP::calc_pp() {}
+bool YAOP::step(const t_index_range &range, int nsubsteps, double dtime) {
+    m_impl->ncalls++;
+    if (m_impl->ncalls == m_impl->capture_call) {
+        std::vector<t_snapshot_field> fields;
+        add_snapshot_fields(m_impl->double_fields, snapshot_double, &fields);
+        add_snapshot_fields(m_impl->int_fields, snapshot_int, &fields);
+        std::sort(fields.begin(), fields.end(),
+                  [](const t_snapshot_field &a, const t_snapshot_field &b) { return a.name < b.name; });
+        t_snapshot_params params = m_impl->params;
+        params.nsubsteps = nsubsteps;
+        params.dtime = dtime;
+        snapshot_write(m_impl->capture_file, params, range, m_impl->ncalls, fields);
+        std::cout << "YAOP: step " << m_impl->ncalls << " captured to " << m_impl->capture_file << std::endl;
+    }
+    return m_impl->backend_tke->calc_substeps(p_patch, p_cvmix, ocean_state, atmos_fluxes, p_as, p_sea_ice,
+                                              range, nsubsteps, dtime);
+}
+
+void YAOP::rebind_field(const std::string &name, double *data) {
+    auto field = m_impl->double_fields.find(name);
+    if (field == m_impl->double_fields.end()) {
+        std::cerr << "YAOP: unknown double field " << name << std::endl;
+        abort();
+    }
+    if (*field->second.data != data) {
+        *field->second.data = data;
+        m_impl->invalidate_views();
+    }
+}
+
+void YAOP::rebind_field(const std::string &name, int *data) {
+    auto field = m_impl->int_fields.find(name);
+    if (field == m_impl->int_fields.end()) {
+        std::cerr << "YAOP: unknown int field " << name << std::endl;
+        abort();
+    }
+    if (*field->second.data != data) {
+        *field->second.data = data;
+        m_impl->invalidate_views();
+    }
+}
+
+int YAOP::save_buffer_set() {
+    m_impl->buffer_sets.push_back({p_patch, p_cvmix, p_sea_ice, p_as, atmos_fluxes, ocean_state,
+                                   p_idemix, p_horizontal_grid});
+    return static_cast<int>(m_impl->buffer_sets.size()) - 1;
+}
 
-void YAOP::calc_idemix() {}
+void YAOP::select_buffer_set(int id) {
+    if (id < 0 || id >= static_cast<int>(m_impl->buffer_sets.size())) {
+        std::cerr << "YAOP: buffer set " << id << " not found" << std::endl;
+        abort();
+    }
+    const t_buffer_set &set = m_impl->buffer_sets[id];
+    p_patch = set.p_patch;
+    p_cvmix = set.p_cvmix;
+    p_sea_ice = set.p_sea_ice;
+    p_as = set.p_as;
+    atmos_fluxes = set.atmos_fluxes;
+    ocean_state = set.ocean_state;
+    p_idemix = set.p_idemix;
+    p_horizontal_grid = set.p_horizontal_grid;
+    m_impl->invalidate_views();
+}
+
+void YAOP::step_ensemble(int nmembers, const int *set_ids, const t_index_range &range) {
+    if (nmembers <= 0)
+        return;
+    std::vector<t_ensemble_member> members(nmembers);
+    for (int m = 0; m < nmembers; m++) {
+        int id = set_ids[m];
+        if (id < 0 || id >= static_cast<int>(m_impl->buffer_sets.size())) {
+            std::cerr << "YAOP: buffer set " << id << " not found" << std::endl;
+            abort();
+        }
+        const t_buffer_set &set = m_impl->buffer_sets[id];
+        if (std::memcmp(&set.p_patch, &m_impl->buffer_sets[set_ids[0]].p_patch, sizeof(t_patch)) != 0) {
+            std::cerr << "YAOP: ensemble members must share the grid info" << std::endl;
+            abort();
+        }
+        members[m] = {set.p_cvmix, set.ocean_state, set.atmos_fluxes, set.p_as, set.p_sea_ice};
+    }
+    m_impl->backend_tke->calc_ensemble(m_impl->buffer_sets[set_ids[0]].p_patch, nmembers, members.data(), range);
+}
+
+t_timing_report YAOP::timing_report() const {
+    return m_impl->backend_tke->timing_report();
+}
+
+void YAOP::reset_timing() {
+    m_impl->backend_tke->reset_timing();
+}
+
+const char *YAOP::timing_stage_name(int stage) {
+    return ::timing_stage_name(stage);
+}
+
+const char *YAOP::perf_counter_name(int counter) {
+    return ::perf_counter_name(counter);
+}
+
+void YAOP::dump_trace(const std::string &filename) const {
+    m_impl->backend_tke->dump_trace(filename);
+}
+
+bool YAOP::set_quiescence(double threshold, int refresh) {
+    return m_impl->backend_tke->set_quiescence(threshold, refresh);
+}
+
+void YAOP::set_fuse_edges(bool fuse_edges) {
+    m_impl->backend_tke->set_fuse_edges(fuse_edges);
+}
+
+bool YAOP::set_tridiag_solver(int solver) {
+    return m_impl->backend_tke->set_tridiag_solver(solver);
+}
+
+bool YAOP::set_tke_mxl_choice(int choice) {
+    return m_impl->backend_tke->set_tke_mxl_choice(choice);
+}
+
+t_quiescence_report YAOP::quiescence_report() const {
+    return m_impl->backend_tke->quiescence_report();
+}
+
+t_memory_report YAOP::memory_report() const {
+    const memory_accounting &memory = m_impl->backend_tke->memory();
+    t_memory_report report;
+    report.internal_bytes = memory.current_bytes();
+    report.peak_bytes = memory.peak_bytes();
+    report.internal_fields = memory.fields();
+    if (m_impl->backend_pp) {
+        const memory_accounting &memory_pp = m_impl->backend_pp->memory();
+        report.internal_bytes += memory_pp.current_bytes();
+        report.peak_bytes += memory_pp.peak_bytes();
+        std::vector<t_memory_field> fields_pp = memory_pp.fields();
+        report.internal_fields.insert(report.internal_fields.end(), fields_pp.begin(), fields_pp.end());
+    }
+    report.registered_bytes = 0;
+    add_registered_fields(m_impl->double_fields, &report);
+    add_registered_fields(m_impl->int_fields, &report);
+    std::sort(report.registered_fields.begin(), report.registered_fields.end(),
+              [](const t_memory_field &a, const t_memory_field &b) { return std::strcmp(a.name, b.name) < 0; });
+    return report;
+}
+
+void YAOP::capture(int call, const std::string &filename) {
+    if (call < 1) {
+        std::cerr << "YAOP: capture call " << call << " has to be at least 1" << std::endl;
+        abort();
+    }
+    m_impl->capture_call = call;
+    m_impl->capture_file = filename;
+}
+
+void YAOP::calc_vertical_stability(const t_index_range &range) {
+    m_impl->backend_tke->calc_vertical_stability(p_patch, ocean_state, range);
+}
+
+void YAOP::calc_pp(const t_index_range &range) {
+#ifdef CUDA
+    std::cerr << "YAOP: the PP scheme is not available with the GPU backends" << std::endl;
+    abort();
+#else
+    if (!m_impl->backend_pp) {
+        m_impl->backend_pp = PP_backend::Ptr(new PP_cpu(m_impl->params.nproma, m_impl->params.nlevs,
+                                                        m_impl->params.nblocks));
+    }
+#endif
+    // the vertical stability published by calc_vertical_stability in this time step is reused
+    if (!m_impl->backend_tke->consume_stability(range, &m_impl->pp_stability_generation))
+        m_impl->backend_tke->calc_vertical_stability(p_patch, ocean_state, range, false);
+    m_impl->backend_pp->calc(p_patch, p_cvmix, m_impl->backend_tke->stability(), range);
+}
+
+void YAOP::calc_idemix(const t_index_range &range) {
+    check_idemix_fields(p_idemix, p_horizontal_grid);
+    if (!m_impl->backend_tke->calc_idemix(p_patch, p_cvmix, ocean_state, p_idemix, p_horizontal_grid, range)) {
+        std::cerr << "YAOP: the IDEMIX scheme is not available with the GPU backends" << std::endl;
+        abort();
+    }
+}
+
+void YAOP::step_idemix_tke(const t_index_range &range) {
+    if (m_impl->params.vert_mix_type != m_impl->params.vmix_idemix_tke) {
+        std::cerr << "YAOP: step_idemix_tke needs vert_mix_type equal to vmix_idemix_tke" << std::endl;
+        abort();
+    }
+    check_idemix_fields(p_idemix, p_horizontal_grid);
+    if (!m_impl->backend_tke->calc_idemix_tke(p_patch, p_cvmix, ocean_state, atmos_fluxes, p_as, p_sea_ice,
+                                              p_idemix, p_horizontal_grid, range)) {
+        std::cerr << "YAOP: the IDEMIX scheme is not available with the GPU backends" << std::endl;
+        abort();
+    }
+}
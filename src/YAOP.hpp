@@ -18,7 +18,9 @@
 #define SRC_YAOP_HPP_
 
 #include <iostream>
+#include <string>
 #include "src/shared/interface/data_struct.hpp"
+#include "src/shared/memory_accounting.hpp"
 
 /*! \brief YAOP main class, part of the library interface.
  *
@@ -43,11 +45,15 @@ class YAOP {
 
     /*! \brief YAOP main class time loop calculation of tke scheme.
      *
+     *  Convenience interface equivalent to register all the fields and call step.
      *  Internally it is calling the tke scheme implementation of the backend selected
      *  during the configuration.
-     *  During the first time step the internal data structures are filled and then the
-     *  passed arrays are not used, so the model has to make sure that the memory address
-     *  does not change during the time loop.
+     *  The passed pointers are compared with the ones bound during the previous call and,
+     *  only if any of them changed, the internal data structures and the backend memory views
+     *  are rebuilt. Double buffered fields can therefore be passed directly, without copies.
+     *  With l_lc the Langmuir fields hlc_in, u_stokes_in, wlc_in and tke_plc_in are outputs despite
+     *  their names: hlc and u_stokes are derived from fu10, concsum and the stratification, and the
+     *  values of the host are overwritten.
      */
     void calc_tke(double *depth_CellInterface, double *prism_center_dist_c,
               double *inv_prism_center_dist_c, double *prism_thick_c,
@@ -68,11 +74,197 @@ class YAOP {
               int cells_start_block, int cells_end_block, int cells_start_index,
               int cells_end_index);
 
-    void calc_vertical_stability();
+    /*! \brief Register a double precision field of the tke scheme.
+     *
+     *  The field is identified by its name in the t_patch, t_cvmix, t_ocean_state,
+     *  t_atmo_fluxes, t_atmos_for_ocean, t_sea_ice, t_idemix or t_horizontal_grid structures.
+     *  The shape (C order, e.g. nblocks, nlevs+1, nproma) and the optional strides (in elements)
+     *  are validated once here and not at every time step. Only contiguous layouts are supported.
+     */
+    void register_field(const std::string &name, double *data, int ndims, const int *shape,
+                        const int *strides = nullptr);
+
+    /*! \brief Register an integer field of the tke scheme.
+     *
+     */
+    void register_field(const std::string &name, int *data, int ndims, const int *shape,
+                        const int *strides = nullptr);
+
+    /*! \brief YAOP main class time loop calculation of tke scheme on the registered fields.
+     *
+     *  Only the index ranges are passed. The fields are the ones bound by register_field,
+     *  rebind_field, select_buffer_set or by a previous call to calc_tke. As in calc_tke, the
+     *  Langmuir fields hlc, u_stokes, wlc and tke_plc are outputs.
+     */
+    void step(const t_index_range &range);
+
+    /*! \brief YAOP main class time loop calculation of tke scheme with substeps on the registered fields.
+     *
+     *  nsubsteps tke time steps of length dtime / nsubsteps are taken in one call, and dtime replaces
+     *  the time step of the construction only for this call (e.g. tke called every N model steps with
+     *  N times the model time step). The geometry, the vertical stability and the surface forcing are
+     *  computed once per block and shared by the substeps, the diagnostics are the ones of the last substep.
+     *  It returns false and computes nothing if nsubsteps or dtime is not positive.
+     */
+    bool step(const t_index_range &range, int nsubsteps, double dtime);
+
+    /*! \brief Rebind a single double precision field to a new memory location.
+     *
+     *  The field is identified by its name in the t_patch, t_cvmix, t_ocean_state,
+     *  t_atmo_fluxes, t_atmos_for_ocean or t_sea_ice structures. The cost is independent
+     *  of the problem size: only the memory views are rebuilt at the next step.
+     *  The layout is not validated, the new memory has to match the registered one.
+     */
+    void rebind_field(const std::string &name, double *data);
+
+    /*! \brief Rebind a single integer field to a new memory location.
+     *
+     */
+    void rebind_field(const std::string &name, int *data);
+
+    /*! \brief Save the currently bound fields as a buffer set.
+     *
+     *  It returns the buffer set id to be used in select_buffer_set.
+     */
+    int save_buffer_set();
+
+    /*! \brief Bind all the fields of a previously saved buffer set.
+     *
+     */
+    void select_buffer_set(int id);
+
+    /*! \brief YAOP main class time loop calculation of tke scheme on an ensemble.
+     *
+     *  Each member is a previously saved buffer set. All the members must share the same grid
+     *  info fields and differ in the state, forcing and output fields. The members are computed
+     *  by a single backend call. The currently bound fields are not changed.
+     */
+    void step_ensemble(int nmembers, const int *set_ids, const t_index_range &range);
+
+    /*! \brief Stage timers of the tke scheme accumulated since the construction or the last reset.
+     *
+     *  The timers are compiled only when the library is configured with ENABLE_TIMING, otherwise
+     *  the report has enabled set to 0 and all the timers are zero. The stages are accumulated
+     *  over all the blocks (count is the number of timed blocks), total_seconds over the ncalls
+     *  time steps.
+     */
+    t_timing_report timing_report() const;
+
+    /*! \brief Reset the stage timers of the tke scheme.
+     *
+     */
+    void reset_timing();
+
+    /*! \brief Name of a stage of the timing report.
+     *
+     */
+    static const char *timing_stage_name(int stage);
+
+    /*! \brief Name of a hardware counter of the timing report.
+     *
+     */
+    static const char *perf_counter_name(int counter);
+
+    /*! \brief Write the execution timeline of the tke scheme as Chrome trace JSON.
+     *
+     *  The begin and end of each stage and block are recorded per thread only when the library
+     *  is configured with ENABLE_TRACING, and the timeline is also written at destruction when
+     *  YAOP_TRACE_FILE is set (to that file). The file can be opened in Perfetto.
+     */
+    void dump_trace(const std::string &filename) const;
+
+    /*! \brief Quiescent columns mode of the tke scheme, off by default (threshold 0).
+     *
+     *  A block of columns keeps the tke and the diffusivities of its last full step while the bound of
+     *  the tke tendency (m2/s3) of all its wet columns is below threshold, and a full step is forced every
+     *  refresh skipped steps (default 10). The next step is a full one, and so is the step after a field
+     *  is registered or rebound or a buffer set is selected. It returns false and keeps the
+     *  previous setting for invalid values or a positive threshold with IDEMIX. Only the CPU backend
+     *  implements it.
+     */
+    bool set_quiescence(double threshold, int refresh = 10);
+
+    /*! \brief Compute the edges with both neighbours in the same cell block right after that block.
+     *
+     *  Off by default, the result is the same. Only the CPU backend implements it.
+     */
+    void set_fuse_edges(bool fuse_edges);
+
+    /*! \brief Solver of the tridiagonal system of tke: tridiag_thomas (default) or tridiag_pcr.
+     *
+     *  It returns false and keeps the previous solver for an unknown one. The GPU backends always
+     *  use the Thomas algorithm.
+     */
+    bool set_tridiag_solver(int solver);
+
+    /*! \brief Bound of the mixing length (tke_mxl_choice): 2 (default) or 3.
+     *
+     *  2 limits its vertical gradient, 3 limits it by the distance to the surface and to the bottom.
+     *  It returns false and keeps the previous choice for any other value.
+     */
+    bool set_tke_mxl_choice(int choice);
+
+    /*! \brief Columns skipped by the tke scheme in the last call, with the quiescent columns mode.
+     *
+     *  The report has enabled set to 0 when the mode is off or the backend does not implement it.
+     */
+    t_quiescence_report quiescence_report() const;
+
+    /*! \brief Memory allocated by YAOP and memory of the fields bound by the model.
+     *
+     *  The internal fields are listed with their current bytes (the per thread scratch and the
+     *  ensemble arrays grow with the number of threads and members), together with the total and
+     *  the peak. The bound fields are listed with the bytes of their registered shape, or of the
+     *  expected shape when they are passed with calc_tke.
+     */
+    t_memory_report memory_report() const;
+
+    /*! \brief Capture the inputs of a time step to a binary snapshot.
+     *
+     *  The call is counted from 1 over all the steps (also the ones of calc_tke) since the
+     *  construction. Before that step runs, all the bound fields and the index ranges are written
+     *  to filename, together with the constructor parameters, so the step can be re-run offline
+     *  with yaop_replay. It can be also requested with YAOP_CAPTURE_STEP and YAOP_CAPTURE_FILE.
+     */
+    void capture(int call, const std::string &filename);
+
+    /*! \brief Vertical stability (Nsqr and Ssqr) of the cells range on the bound fields.
+     *
+     *  The squared buoyancy and shear frequencies are computed once and kept per block, so that
+     *  the mixing schemes called afterwards in the same time step (step, calc_tke) read them instead of
+     *  evaluating the densities again. They are read once by each scheme and only over the same cells
+     *  range: a second call of a scheme belongs to the next time step and discards them. They are also
+     *  discarded when any field is rebound, so the state fields must not be modified in place between
+     *  this call and the schemes. Without this call each scheme computes the stability by itself.
+     */
+    void calc_vertical_stability(const t_index_range &range);
 
-    void calc_pp();
+    /*! \brief YAOP main class time loop calculation of the Pacanowski-Philander scheme on the bound fields.
+     *
+     *  The vertical viscosity and diffusivities (a_veloc_v, a_temp_v and a_salt_v) are computed from the
+     *  Richardson number of the vertical stability published in the time step by calc_vertical_stability
+     *  over the same cells range, which is computed only if it is missing. The PP
+     *  backend and its memory are created at the first call. Only the CPU backend implements it.
+     */
+    void calc_pp(const t_index_range &range);
 
-    void calc_idemix();
+    /*! \brief YAOP main class time loop calculation of the IDEMIX scheme on the bound fields.
+     *
+     *  The internal wave energy iwe is propagated vertically (implicitly, column by column) and
+     *  horizontally, forced by forc_iw_surface and forc_iw_bottom and dissipated. The dissipation is
+     *  written to iwe_Tdis, which forces a tke step called afterwards with vmix_idemix_tke. The vertical
+     *  stability published in the time step by calc_vertical_stability over the same cells range is
+     *  reused. Only the CPU backend implements it.
+     */
+    void calc_idemix(const t_index_range &range);
+
+    /*! \brief YAOP main class time loop calculation of IDEMIX coupled with the tke scheme.
+     *
+     *  Equivalent to calc_idemix followed by step, but IDEMIX and tke are computed one after the other
+     *  on each block and the dissipation is passed to tke in a block scratch array instead of iwe_Tdis,
+     *  which is not written. It needs vert_mix_type equal to vmix_idemix_tke.
+     */
+    void step_idemix_tke(const t_index_range &range);
 
  private:
     struct Impl;
@@ -83,7 +275,8 @@ class YAOP {
     struct t_atmos_for_ocean p_as;
     struct t_atmo_fluxes atmos_fluxes;
     struct t_ocean_state ocean_state;
-    bool m_is_struct_init;
+    struct t_idemix p_idemix;
+    struct t_horizontal_grid p_horizontal_grid;
 };
 
 #endif  // SRC_YAOP_HPP_
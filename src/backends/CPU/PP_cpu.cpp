@@ -0,0 +1,93 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <iostream>
+#include "src/backends/CPU/PP_cpu.hpp"
+#include "src/backends/CPU/cpu_kernels.hpp"
+#include "src/backends/memview_fill.hpp"
+#include "src/shared/utils.hpp"
+
+// Structures with memory views of this instance
+struct PP_cpu::Impl {
+    struct t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch_view;
+    struct t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix_view;
+    struct t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability_view;
+    // viscosity of the cells, averaged to the edges
+    mdspan_3d_double pp_Av;
+    // allocations are recorded in the memory accounting of the instance
+    counting_memview_policy<cpu_memview_policy> policy;
+
+    explicit Impl(memory_accounting *memory) : policy(memory) {}
+};
+
+PP_cpu::PP_cpu(int nproma, int nlevs, int nblocks)
+    : PP_backend(nproma, nlevs, nblocks), m_impl(new Impl(&m_memory)) {
+    std::cout << "Initializing PP cpu... " << std::endl;
+
+    m_impl->pp_Av = m_impl->policy.memview_malloc("pp.Av", static_cast<double *>(nullptr),
+                                                  nblocks, nlevs+1, nproma);
+}
+
+PP_cpu::~PP_cpu() {
+    std::cout << "Finalizing PP cpu... " << std::endl;
+
+    m_impl->policy.memview_free(m_impl->pp_Av.data_handle());
+    delete m_impl;
+}
+
+void PP_cpu::calc_impl(t_patch p_patch, t_cvmix p_cvmix, t_vertical_stability stability,
+                       const t_index_range &range) {
+    // structs view are filled at the first time step and every time the bound pointers change
+    if (!m_is_view_init) {
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&m_impl->p_patch_view, &p_patch, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&m_impl->p_cvmix_view, &p_cvmix, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&m_impl->p_stability_view, &stability, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        m_is_view_init = true;
+    }
+
+    // over cells
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int jb = range.cells_start_block; jb <= range.cells_end_block; jb++) {
+        int start_index, end_index;
+        get_index_range(range.cells_block_size, range.cells_start_block, range.cells_end_block,
+                        range.cells_start_index, range.cells_end_index, jb, &start_index, &end_index);
+        calc_pp_cells(jb, start_index, end_index, m_impl->p_patch_view, m_impl->p_cvmix_view,
+                      m_impl->p_stability_view, m_impl->pp_Av, p_constant, p_constant_pp);
+    }
+
+    // over edges: the viscosity of all the cell blocks is needed, averaged as the one of tke
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int jb = range.edges_start_block; jb <= range.edges_end_block; jb++) {
+        int start_index, end_index;
+        get_index_range(range.edges_block_size, range.edges_start_block, range.edges_end_block,
+                        range.edges_start_index, range.edges_end_index, jb, &start_index, &end_index);
+        struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal;
+        p_internal.tke_Av = m_impl->pp_Av;
+        calc_impl_edges(jb, start_index, end_index, m_impl->p_patch_view, m_impl->p_cvmix_view,
+                        p_internal, p_constant);
+    }
+}
@@ -0,0 +1,54 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_BACKENDS_CPU_PP_CPU_HPP_
+#define SRC_BACKENDS_CPU_PP_CPU_HPP_
+
+#include "src/backends/PP_backend.hpp"
+
+/*! \brief PP CPU backend class, derived from PP_backend.
+ *
+ */
+class PP_cpu : public PP_backend {
+ public:
+    /*! \brief PP_cpu class constructor.
+    *
+    *   It calls the PP_backend constructor and allocates the cell viscosity.
+    */
+    PP_cpu(int nproma, int nlevs, int nblocks);
+
+    /*! \brief PP_cpu class destructor.
+    *
+    */
+    ~PP_cpu();
+
+ protected:
+    /*! \brief CPU implementation of PP.
+    *
+    *   It fills the memory view structures when the bound pointers change and then computes the
+    *   Richardson number dependent viscosity and diffusivities of the cells, vectorised over the columns
+    *   of a block, and the viscosity of the edges. With OpenMP the blocks are distributed among the threads.
+    */
+    void calc_impl(struct t_patch p_patch, struct t_cvmix p_cvmix, struct t_vertical_stability stability,
+                   const struct t_index_range &range);
+
+ private:
+    struct Impl;
+    Impl *m_impl;
+};
+
+#endif  // SRC_BACKENDS_CPU_PP_CPU_HPP_
@@ -14,31 +14,221 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "src/backends/CPU/TKE_cpu.hpp"
 #include "src/backends/CPU/cpu_kernels.hpp"
 #include "src/shared/utils.hpp"
 
-// Structures with memory views
-static struct t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix_view;
-static struct t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch_view;
-static struct t_ocean_state_view<cpu_memview::mdspan, cpu_memview::dextents> ocean_state_view;
-static struct t_atmo_fluxes_view<cpu_memview::mdspan, cpu_memview::dextents> atmos_fluxes_view;
-static struct t_atmos_for_ocean_view<cpu_memview::mdspan, cpu_memview::dextents> p_as_view;
-static struct t_sea_ice_view<cpu_memview::mdspan, cpu_memview::dextents> p_sea_ice_view;
-static struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal_view;
+// Memory views of one ensemble member, the grid info is shared among the members
+struct t_ensemble_member_view {
+    struct t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix_view;
+    struct t_ocean_state_view<cpu_memview::mdspan, cpu_memview::dextents> ocean_state_view;
+    struct t_atmo_fluxes_view<cpu_memview::mdspan, cpu_memview::dextents> atmos_fluxes_view;
+    struct t_atmos_for_ocean_view<cpu_memview::mdspan, cpu_memview::dextents> p_as_view;
+    struct t_sea_ice_view<cpu_memview::mdspan, cpu_memview::dextents> p_sea_ice_view;
+    struct t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry_view;
+    struct t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability_view;
+    mdspan_3d_double tke_Av;
+};
+
+// Structures with memory views of this instance
+struct TKE_cpu::Impl {
+    struct t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix_view;
+    struct t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch_view;
+    struct t_ocean_state_view<cpu_memview::mdspan, cpu_memview::dextents> ocean_state_view;
+    struct t_atmo_fluxes_view<cpu_memview::mdspan, cpu_memview::dextents> atmos_fluxes_view;
+    struct t_atmos_for_ocean_view<cpu_memview::mdspan, cpu_memview::dextents> p_as_view;
+    struct t_sea_ice_view<cpu_memview::mdspan, cpu_memview::dextents> p_sea_ice_view;
+    struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal_view;
+    struct t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry_view;
+    struct t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability_view;
+    struct t_idemix_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix_view;
+    struct t_horizontal_grid_view<cpu_memview::mdspan, cpu_memview::dextents> p_grid_view;
+
+    // IDEMIX, allocated at the first call: v0 and the edge fluxes are read across the blocks,
+    // the other fields are block scratch arrays of each OpenMP thread
+    mdspan_3d_double idemix_v0;
+    mdspan_3d_double idemix_flux_h;
+    std::vector<struct t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents>> idemix_scratch;
+
+    // Ensemble mode, allocated at the first call
+    struct t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> ens_patch_view;
+    struct t_patch ens_patch_bound;
+    std::vector<struct t_ensemble_member> ens_bound;
+    std::vector<t_ensemble_member_view> ens_views;
+
+    // Edge gather tables of the instance and of the ensemble
+    struct t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> gather_view;
+    struct t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> ens_gather_view;
+
+    // Quiescent columns mode, allocated at the first call with a positive quiescent_threshold
+    struct t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> quiescence_view;
+    struct t_index_range quiescence_range = {0, 0, -1, 0, 0, 0, 0, -1, 0, 0};
+
+    // Block scratch arrays of each OpenMP thread, allocated at the first threaded call
+    std::vector<struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents>> thread_scratch;
+    std::vector<double *> ens_memory;
+    std::vector<int *> ens_memory_int;
+    // allocations are recorded in the memory accounting of the instance
+    counting_memview_policy<cpu_memview_policy> policy;
+
+    explicit Impl(memory_accounting *memory) : policy(memory) {}
+
+    ~Impl() {
+        for (double *field : ens_memory)
+            policy.memview_free(field);
+        for (int *field : ens_memory_int)
+            policy.memview_free(field);
+    }
+
+    // allocate ensemble arrays, released in the destructor
+    mdspan_1d_double ens_malloc(const char *name, int dim1) {
+        mdspan_1d_double view = policy.memview_malloc(name, static_cast<double *>(nullptr), dim1);
+        ens_memory.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_2d_double ens_malloc(const char *name, int dim1, int dim2) {
+        mdspan_2d_double view = policy.memview_malloc(name, static_cast<double *>(nullptr), dim1, dim2);
+        ens_memory.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_3d_double ens_malloc(const char *name, int dim1, int dim2, int dim3) {
+        mdspan_3d_double view = policy.memview_malloc(name, static_cast<double *>(nullptr), dim1, dim2, dim3);
+        ens_memory.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_1d_int ens_malloc_int(const char *name, int dim1) {
+        mdspan_1d_int view = policy.memview_malloc(name, static_cast<int *>(nullptr), dim1);
+        ens_memory_int.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_2d_int ens_malloc_int(const char *name, int dim1, int dim2) {
+        mdspan_2d_int view = policy.memview_malloc(name, static_cast<int *>(nullptr), dim1, dim2);
+        ens_memory_int.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_3d_int ens_malloc_int(const char *name, int dim1, int dim2, int dim3) {
+        mdspan_3d_int view = policy.memview_malloc(name, static_cast<int *>(nullptr), dim1, dim2, dim3);
+        ens_memory_int.push_back(view.data_handle());
+        return view;
+    }
+
+    // gather table of the edges, allocated at the first use and built again when the grid info changes
+    void build_edge_gather(bool is_ensemble, const t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> &patch,
+                           t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> *gather,
+                           const t_constant &p_constant) {
+        int nblocks = p_constant.nblocks;
+        int nproma = p_constant.nproma;
+        if (static_cast<long long>(nblocks) * (p_constant.nlevs+1) * nproma > std::numeric_limits<int>::max()) {
+            std::cerr << "YAOP: the cell fields are too large for the edge gather table" << std::endl;
+            abort();
+        }
+        // the names are kept by the memory accounting, so they are literals
+        if (!gather->cell_offset.data_handle()) {
+            gather->cell_offset = ens_malloc_int(is_ensemble ? "ensemble.edge_gather.cell_offset" :
+                                                 "edge_gather.cell_offset", 2, nblocks, nproma);
+            gather->fused_block = ens_malloc_int(is_ensemble ? "ensemble.edge_gather.fused_block" :
+                                                 "edge_gather.fused_block", nblocks, nproma);
+            gather->fused_start = ens_malloc_int(is_ensemble ? "ensemble.edge_gather.fused_start" :
+                                                 "edge_gather.fused_start", nblocks+1);
+            gather->fused_edges = ens_malloc_int(is_ensemble ? "ensemble.edge_gather.fused_edges" :
+                                                 "edge_gather.fused_edges", nblocks * nproma);
+        }
+        init_edge_gather(patch, *gather, p_constant);
+    }
+
+    // block scratch arrays of one thread, tke_Av is taken from the instance or from the member,
+    // Nsqr and Ssqr from the block slice of the vertical stability
+    void add_thread_scratch(const t_constant &p_constant) {
+        int nlevs = p_constant.nlevs;
+        int nproma = p_constant.nproma;
+        struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> scratch;
+        scratch.forc_tke_surf_2D = ens_malloc("thread_scratch.forc_tke_surf_2D", nproma);
+        scratch.pot_energy_lc_2D = ens_malloc("thread_scratch.pot_energy_lc_2D", nproma);
+        scratch.tke_old = ens_malloc("thread_scratch.tke_old", nlevs+1, nproma);
+        scratch.tke_kv = ens_malloc("thread_scratch.tke_kv", nlevs+1, nproma);
+        scratch.a_dif = ens_malloc("thread_scratch.a_dif", nlevs+1, nproma);
+        scratch.b_dif = ens_malloc("thread_scratch.b_dif", nlevs+1, nproma);
+        scratch.c_dif = ens_malloc("thread_scratch.c_dif", nlevs+1, nproma);
+        scratch.a_tri = ens_malloc("thread_scratch.a_tri", nlevs+1, nproma);
+        scratch.b_tri = ens_malloc("thread_scratch.b_tri", nlevs+1, nproma);
+        scratch.c_tri = ens_malloc("thread_scratch.c_tri", nlevs+1, nproma);
+        scratch.d_tri = ens_malloc("thread_scratch.d_tri", nlevs+1, nproma);
+        scratch.sqrttke = ens_malloc("thread_scratch.sqrttke", nlevs+1, nproma);
+        scratch.forc = ens_malloc("thread_scratch.forc", nlevs+1, nproma);
+        scratch.ke = ens_malloc("thread_scratch.ke", nlevs+1, nproma);
+        scratch.cp = ens_malloc("thread_scratch.cp", nlevs+1, nproma);
+        scratch.dp = ens_malloc("thread_scratch.dp", nlevs+1, nproma);
+        scratch.tke_upd = ens_malloc("thread_scratch.tke_upd", nlevs+1, nproma);
+        scratch.tke_unrest = ens_malloc("thread_scratch.tke_unrest", nlevs+1, nproma);
+        thread_scratch.push_back(scratch);
+    }
+
+    // IDEMIX block scratch arrays of one thread, with the fields shared by the blocks
+    void add_idemix_scratch(const t_constant &p_constant) {
+        int nblocks = p_constant.nblocks;
+        int nlevs = p_constant.nlevs;
+        int nproma = p_constant.nproma;
+        if (idemix_v0.data_handle() == nullptr) {
+            // the edges of the range may read the cells outside of it
+            idemix_v0 = ens_malloc("idemix.v0", nblocks, nlevs+1, nproma);
+            idemix_flux_h = ens_malloc("idemix.flux_h", nblocks, nlevs+1, nproma);
+            std::memset(idemix_v0.data_handle(), 0, sizeof(double) * nblocks * (nlevs+1) * nproma);
+            std::memset(idemix_flux_h.data_handle(), 0, sizeof(double) * nblocks * (nlevs+1) * nproma);
+        }
+        struct t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> scratch;
+        scratch.bN0 = ens_malloc("idemix_scratch.bN0", nproma);
+        scratch.c0 = ens_malloc("idemix_scratch.c0", nlevs+1, nproma);
+        scratch.alpha_c = ens_malloc("idemix_scratch.alpha_c", nlevs+1, nproma);
+        scratch.iwe_old = ens_malloc("idemix_scratch.iwe_old", nlevs+1, nproma);
+        scratch.iwe_Tdis = ens_malloc("idemix_scratch.iwe_Tdis", nlevs+1, nproma);
+        scratch.v0 = idemix_v0;
+        scratch.flux_h = idemix_flux_h;
+        idemix_scratch.push_back(scratch);
+    }
+
+    // per member arrays: the geometry cache depends on stretch_c, which is a member field
+    void add_ensemble_member(const t_constant &p_constant) {
+        int nblocks = p_constant.nblocks;
+        int nlevs = p_constant.nlevs;
+        int nproma = p_constant.nproma;
+        t_ensemble_member_view member;
+        member.p_geometry_view.dzw_stretched = ens_malloc("ensemble.geometry.dzw_stretched", nblocks, nlevs, nproma);
+        member.p_geometry_view.dzt_stretched = ens_malloc("ensemble.geometry.dzt_stretched", nblocks, nlevs+1, nproma);
+        member.p_geometry_view.inv_dzt_stretched = ens_malloc("ensemble.geometry.inv_dzt_stretched",
+                                                              nblocks, nlevs+1, nproma);
+        member.p_geometry_view.stretch_c = ens_malloc("ensemble.geometry.stretch_c", nblocks, nproma);
+        member.p_geometry_view.pressure = ens_malloc("ensemble.geometry.pressure", nlevs);
+        member.p_geometry_view.max_levels = ens_malloc_int("ensemble.geometry.max_levels", nblocks);
+        member.p_stability_view.Nsqr = ens_malloc("ensemble.stability.Nsqr", nblocks, nlevs+1, nproma);
+        member.p_stability_view.Ssqr = ens_malloc("ensemble.stability.Ssqr", nblocks, nlevs+1, nproma);
+        member.tke_Av = ens_malloc("ensemble.tke_Av", nblocks, nlevs+1, nproma);
+        ens_views.push_back(member);
+    }
+};
 
 TKE_cpu::TKE_cpu(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemix_tke,
                    int vert_cor_type, double dtime, double OceanReferenceDensity, double grav,
                    int l_lc, double clc, double ReferencePressureIndbars, double pi)
     : TKE_backend(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke,
                   vert_cor_type, dtime, OceanReferenceDensity, grav,
-                  l_lc, clc, ReferencePressureIndbars, pi) {
+                  l_lc, clc, ReferencePressureIndbars, pi), m_impl(new Impl(&m_memory)) {
     // Allocate internal arrays memory and create memory views
     std::cout << "Initializing TKE cpu... " << std::endl;
 
     this->internal_fields_malloc<cpu_memview::mdspan, cpu_memview::dextents, cpu_mdspan_impl>
-                                (&p_internal_view);
+                                (&m_impl->p_internal_view);
+    this->geometry_fields_malloc<cpu_memview::mdspan, cpu_memview::dextents, cpu_mdspan_impl>
+                                (&m_impl->p_geometry_view);
+    this->stability_fields_malloc<cpu_memview::mdspan, cpu_memview::dextents, cpu_mdspan_impl>
+                                 (&m_impl->p_stability_view);
 }
 
 TKE_cpu::~TKE_cpu() {
@@ -46,6 +236,9 @@ TKE_cpu::~TKE_cpu() {
     std::cout << "Finalizing TKE cpu... " << std::endl;
 
     this->internal_fields_free<cpu_mdspan_impl>();
+    this->geometry_fields_free<cpu_mdspan_impl>();
+    this->stability_fields_free<cpu_mdspan_impl>();
+    delete m_impl;
 }
 
 void TKE_cpu::calc_impl(t_patch p_patch, t_cvmix p_cvmix,
@@ -55,45 +248,481 @@ void TKE_cpu::calc_impl(t_patch p_patch, t_cvmix p_cvmix,
                          int edges_start_index, int edges_end_index, int cells_block_size,
                          int cells_start_block, int cells_end_block, int cells_start_index,
                          int cells_end_index) {
-    // The pointer to the data should not change inside the time loop
-    // structs view are filled only at the first time step
-    if (!m_is_view_init) {
-        this->fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
-                                 (&p_cvmix_view, &p_cvmix, p_constant.nblocks, p_constant.nlevs, p_constant.nproma);
-        this->fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
-                                 (&p_patch_view, &p_patch, p_constant.nblocks, p_constant.nlevs, p_constant.nproma);
-        this->fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
-                                 (&ocean_state_view, &ocean_state, p_constant.nblocks, p_constant.nlevs,
-                                  p_constant.nproma);
-        this->fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
-                                 (&atmos_fluxes_view, &atmos_fluxes, p_constant.nblocks, p_constant.nproma);
-        this->fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
-                                 (&p_as_view, &p_as, p_constant.nblocks, p_constant.nproma);
-        this->fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
-                                 (&p_sea_ice_view, &p_sea_ice, p_constant.nblocks, p_constant.nproma);
-        m_is_view_init = true;
+    // structs view are filled at the first time step and every time the bound pointers change
+    YAOP_TIMER_START(timer_view_init, &m_thread_timers[0]);
+    if (!m_is_view_init)
+        bind_tke_fields(p_patch, p_cvmix, ocean_state, atmos_fluxes, p_as, p_sea_ice);
+    YAOP_TIMER_STOP(timer_view_init, &m_thread_timers[0], timing_view_init);
+
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    calc_cells_and_edges(range, false);
+}
+
+bool TKE_cpu::calc_idemix_tke_impl(t_patch p_patch, t_cvmix p_cvmix, t_ocean_state ocean_state,
+                                   t_atmo_fluxes atmos_fluxes, t_atmos_for_ocean p_as, t_sea_ice p_sea_ice,
+                                   t_idemix p_idemix, t_horizontal_grid p_grid, const t_index_range &range) {
+    YAOP_TIMER_START(timer_view_init, &m_thread_timers[0]);
+    if (!m_is_view_init)
+        bind_tke_fields(p_patch, p_cvmix, ocean_state, atmos_fluxes, p_as, p_sea_ice);
+    if (!m_is_idemix_view_init)
+        bind_idemix_fields(p_idemix, p_grid);
+    YAOP_TIMER_STOP(timer_view_init, &m_thread_timers[0], timing_view_init);
+
+    calc_cells_and_edges(range, true);
+    return true;
+}
+
+void TKE_cpu::calc_cells_and_edges(const t_index_range &range, bool is_idemix_coupled) {
+    // the vertical stability published by calc_vertical_stability for this cells range is consumed once
+    bool is_stability_cached = consume_stability(range, &m_tke_stability_generation);
+
+    // the first thread uses the block scratch arrays of the instance, no nested threading
+    int nthreads = 1;
+#ifdef _OPENMP
+    if (!omp_in_parallel())
+        nthreads = omp_get_max_threads();
+#endif
+    while (static_cast<int>(m_impl->thread_scratch.size()) < nthreads - 1)
+        m_impl->add_thread_scratch(p_constant);
+    while (is_idemix_coupled && static_cast<int>(m_impl->idemix_scratch.size()) < nthreads)
+        m_impl->add_idemix_scratch(p_constant);
+    reserve_thread_timers(nthreads);
+
+    // the first step of each block is a full step, also after a new setting, with IDEMIX coupled all the
+    // blocks are computed
+    bool is_quiescence_alloc = m_impl->quiescence_view.skipped_steps.data_handle() != nullptr;
+    if (p_constant_tke.quiescent_threshold > 0.0 && (!is_quiescence_alloc || m_is_quiescence_reset)) {
+        int nblocks = p_constant.nblocks;
+        int nproma = p_constant.nproma;
+        if (!is_quiescence_alloc) {
+            m_impl->quiescence_view.activity = m_impl->ens_malloc("quiescence.activity", nblocks, nproma);
+            m_impl->quiescence_view.error_bound = m_impl->ens_malloc("quiescence.error_bound", nblocks, nproma);
+            m_impl->quiescence_view.skipped_steps = m_impl->ens_malloc_int("quiescence.skipped_steps", nblocks);
+        }
+        m_is_quiescence_reset = false;
+        for (int jb = 0; jb < nblocks; jb++) {
+            for (int jc = 0; jc < nproma; jc++) {
+                m_impl->quiescence_view.activity(jb, jc) = std::numeric_limits<double>::max();
+                m_impl->quiescence_view.error_bound(jb, jc) = 0.0;
+            }
+            m_impl->quiescence_view.skipped_steps(jb) = 0;
+        }
+    }
+    struct t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence;
+    if (!is_idemix_coupled && p_constant_tke.quiescent_threshold > 0.0) {
+        p_quiescence = m_impl->quiescence_view;
+        m_impl->quiescence_range = range;
     }
 
     // over cells
-    for (int jb = cells_start_block; jb <= cells_end_block; jb++) {
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int jb = range.cells_start_block; jb <= range.cells_end_block; jb++) {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal =
+            thread == 0 ? m_impl->p_internal_view : m_impl->thread_scratch[thread - 1];
+        p_internal.tke_Av = m_impl->p_internal_view.tke_Av;
         int start_index, end_index;
-        get_index_range(cells_block_size, cells_start_block, cells_end_block,
-                        cells_start_index, cells_end_index, jb, &start_index, &end_index);
+        get_index_range(range.cells_block_size, range.cells_start_block, range.cells_end_block,
+                        range.cells_start_index, range.cells_end_index, jb, &start_index, &end_index);
+        t_thread_timers *timers = &m_thread_timers[thread];
+        timers->block = jb;
+        YAOP_TRACE_START(timer_block);
+        bool is_block_stability_cached = is_stability_cached;
+        if (is_idemix_coupled) {
+            // IDEMIX of the block runs first, its dissipation stays in the thread scratch for tke
+            YAOP_TIMER_START(timer_idemix, timers);
+            update_geometry_cache(jb, start_index, end_index, m_impl->p_patch_view, m_impl->ocean_state_view,
+                                  m_impl->p_geometry_view, p_constant);
+            if (!is_stability_cached)
+                ::calc_vertical_stability(jb, start_index, end_index, m_impl->p_patch_view,
+                                          m_impl->ocean_state_view, m_impl->p_geometry_view,
+                                          m_impl->p_stability_view, p_constant);
+            calc_idemix_vertical(jb, start_index, end_index, m_impl->p_patch_view, m_impl->p_idemix_view,
+                                 m_impl->p_grid_view, m_impl->p_geometry_view, m_impl->p_stability_view,
+                                 m_impl->idemix_scratch[thread], p_internal, p_constant, p_constant_idemix);
+            p_internal.iwe_Tdis = m_impl->idemix_scratch[thread].iwe_Tdis;
+            is_block_stability_cached = true;
+            YAOP_TIMER_STOP(timer_idemix, timers, timing_idemix);
+        }
         calc_impl_cells(jb, start_index, end_index,
-                        p_patch_view, p_cvmix_view,
-                        ocean_state_view, atmos_fluxes_view,
-                        p_as_view, p_sea_ice_view,
-                        p_internal_view, p_constant,
-                        p_constant_tke);
+                        m_impl->p_patch_view, m_impl->p_cvmix_view,
+                        m_impl->ocean_state_view, m_impl->atmos_fluxes_view,
+                        m_impl->p_as_view, m_impl->p_sea_ice_view,
+                        p_internal, m_impl->p_geometry_view,
+                        m_impl->p_stability_view, p_quiescence, is_block_stability_cached,
+                        p_constant, p_constant_tke, timers);
+        if (p_constant_tke.fuse_edges)
+            calc_fused_edges(jb, range, m_impl->p_patch_view, m_impl->p_cvmix_view, p_internal,
+                             m_impl->gather_view, p_constant, timers);
+        YAOP_TRACE_STOP(timer_block, timers, trace_cells_block);
+    }
+    // otherwise it has been computed by the blocks for this call only
+    if (is_idemix_coupled)
+        m_idemix_stability_generation = m_tke_stability_generation;
+
+    // over edges: tke_Av of all the cell blocks is needed, the fused edges have been computed with the cells
+    int fused_start_block = p_constant_tke.fuse_edges ? range.cells_start_block : 0;
+    int fused_end_block = p_constant_tke.fuse_edges ? range.cells_end_block : -1;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int jb = range.edges_start_block; jb <= range.edges_end_block; jb++) {
+        int start_index, end_index;
+        get_index_range(range.edges_block_size, range.edges_start_block, range.edges_end_block,
+                        range.edges_start_index, range.edges_end_index, jb, &start_index, &end_index);
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        t_thread_timers *timers = &m_thread_timers[thread];
+        timers->block = jb;
+        calc_impl_edges_gather(jb, start_index, end_index, fused_start_block, fused_end_block,
+                               m_impl->p_patch_view, m_impl->p_cvmix_view,
+                               m_impl->p_internal_view, m_impl->gather_view, p_constant, timers);
     }
 
-    // over edges
-    for (int jb = edges_start_block; jb <= edges_end_block; jb++) {
+    // horizontal propagation of the internal wave energy, after the vertical one of all the blocks
+    if (is_idemix_coupled)
+        calc_idemix_horizontal_impl(range);
+}
+
+t_quiescence_report TKE_cpu::quiescence_report() const {
+    t_quiescence_report report = {0, 0, 0, 0, 0.0};
+    if (!(p_constant_tke.quiescent_threshold > 0.0) || !m_impl->quiescence_view.skipped_steps.data_handle())
+        return report;
+
+    // the skipped blocks of the last call are the ones with skipped_steps still counting
+    const t_index_range &range = m_impl->quiescence_range;
+    report.enabled = 1;
+    for (int jb = range.cells_start_block; jb <= range.cells_end_block; jb++) {
         int start_index, end_index;
-        get_index_range(edges_block_size, edges_start_block, edges_end_block,
-                        edges_start_index, edges_end_index, jb, &start_index, &end_index);
-        calc_impl_edges(jb, start_index, end_index,
-                        p_patch_view, p_cvmix_view,
-                        p_internal_view, p_constant);
+        get_index_range(range.cells_block_size, range.cells_start_block, range.cells_end_block,
+                        range.cells_start_index, range.cells_end_index, jb, &start_index, &end_index);
+        bool is_skipped = m_impl->quiescence_view.skipped_steps(jb) > 0;
+        if (is_skipped)
+            report.nblocks_skipped++;
+        for (int jc = start_index; jc <= end_index; jc++) {
+            if (m_impl->p_patch_view.dolic_c(jb, jc) <= 0)
+                continue;
+            report.ncolumns++;
+            if (is_skipped)
+                report.nquiescent++;
+            report.max_error_bound = std::max(report.max_error_bound, m_impl->quiescence_view.error_bound(jb, jc));
+        }
+    }
+    return report;
+}
+
+void TKE_cpu::calc_ensemble_impl(t_patch p_patch, int nmembers, const t_ensemble_member *members,
+                                 const t_index_range &range) {
+    // no nested threading when the ensemble is computed by a thread of the host
+    int nthreads = 1;
+#ifdef _OPENMP
+    if (!omp_in_parallel())
+        nthreads = omp_get_max_threads();
+#endif
+    while (static_cast<int>(m_impl->thread_scratch.size()) < nthreads)
+        m_impl->add_thread_scratch(p_constant);
+    reserve_thread_timers(nthreads);
+
+    YAOP_TIMER_START(timer_view_init, &m_thread_timers[0]);
+
+    // the member views are rebuilt only for the members whose bound pointers changed
+    bool is_patch_changed = m_impl->ens_views.empty() ||
+                            std::memcmp(&m_impl->ens_patch_bound, &p_patch, sizeof(t_patch)) != 0;
+    if (is_patch_changed) {
+        m_impl->ens_patch_bound = p_patch;
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&m_impl->ens_patch_view, &p_patch, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        m_impl->build_edge_gather(true, m_impl->ens_patch_view, &m_impl->ens_gather_view,
+                                  p_constant);
+        // also the members which are not in this call, they can come back with unchanged pointers
+        for (t_ensemble_member_view &view : m_impl->ens_views)
+            init_geometry_cache(m_impl->ens_patch_view, view.p_geometry_view, p_constant);
+    }
+    for (int m = 0; m < nmembers; m++) {
+        bool is_new_member = m >= static_cast<int>(m_impl->ens_views.size());
+        if (is_new_member) {
+            m_impl->add_ensemble_member(p_constant);
+            m_impl->ens_bound.push_back(members[m]);
+        } else if (!is_patch_changed &&
+                   std::memcmp(&m_impl->ens_bound[m], &members[m], sizeof(t_ensemble_member)) == 0) {
+            continue;
+        }
+        m_impl->ens_bound[m] = members[m];
+        t_ensemble_member member = members[m];
+        t_ensemble_member_view &view = m_impl->ens_views[m];
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&view.p_cvmix_view, &member.p_cvmix, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&view.ocean_state_view, &member.ocean_state, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&view.atmos_fluxes_view, &member.atmos_fluxes, p_constant.nblocks,
+                            p_constant.nproma);
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&view.p_as_view, &member.p_as, p_constant.nblocks, p_constant.nproma);
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&view.p_sea_ice_view, &member.p_sea_ice, p_constant.nblocks, p_constant.nproma);
+        if (is_new_member)
+            init_geometry_cache(m_impl->ens_patch_view, view.p_geometry_view, p_constant);
+    }
+    YAOP_TIMER_STOP(timer_view_init, &m_thread_timers[0], timing_view_init);
+
+    // over cells: one loop over all the (member, block) pairs
+    int cells_nblocks = range.cells_end_block - range.cells_start_block + 1;
+    int cells_ntasks = nmembers * cells_nblocks;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int task = 0; task < cells_ntasks; task++) {
+        int m = task / cells_nblocks;
+        int jb = range.cells_start_block + task % cells_nblocks;
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        const t_ensemble_member_view &view = m_impl->ens_views[m];
+        struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal =
+            m_impl->thread_scratch[thread];
+        p_internal.tke_Av = view.tke_Av;
+        int start_index, end_index;
+        get_index_range(range.cells_block_size, range.cells_start_block, range.cells_end_block,
+                        range.cells_start_index, range.cells_end_index, jb, &start_index, &end_index);
+        t_thread_timers *timers = &m_thread_timers[thread];
+        timers->block = jb;
+        YAOP_TRACE_START(timer_block);
+        calc_impl_cells(jb, start_index, end_index,
+                        m_impl->ens_patch_view, view.p_cvmix_view,
+                        view.ocean_state_view, view.atmos_fluxes_view,
+                        view.p_as_view, view.p_sea_ice_view,
+                        p_internal, view.p_geometry_view,
+                        view.p_stability_view,
+                        t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents>(), false,
+                        p_constant, p_constant_tke, timers);
+        if (p_constant_tke.fuse_edges)
+            calc_fused_edges(jb, range, m_impl->ens_patch_view, view.p_cvmix_view, p_internal,
+                             m_impl->ens_gather_view, p_constant, timers);
+        YAOP_TRACE_STOP(timer_block, timers, trace_cells_block);
+    }
+
+    // over edges: tke_Av of all the cell blocks of the member is needed
+    int fused_start_block = p_constant_tke.fuse_edges ? range.cells_start_block : 0;
+    int fused_end_block = p_constant_tke.fuse_edges ? range.cells_end_block : -1;
+    int edges_nblocks = range.edges_end_block - range.edges_start_block + 1;
+    int edges_ntasks = nmembers * edges_nblocks;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int task = 0; task < edges_ntasks; task++) {
+        int m = task / edges_nblocks;
+        int jb = range.edges_start_block + task % edges_nblocks;
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        const t_ensemble_member_view &view = m_impl->ens_views[m];
+        struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal;
+        p_internal.tke_Av = view.tke_Av;
+        int start_index, end_index;
+        get_index_range(range.edges_block_size, range.edges_start_block, range.edges_end_block,
+                        range.edges_start_index, range.edges_end_index, jb, &start_index, &end_index);
+        t_thread_timers *timers = &m_thread_timers[thread];
+        timers->block = jb;
+        calc_impl_edges_gather(jb, start_index, end_index, fused_start_block, fused_end_block,
+                               m_impl->ens_patch_view, view.p_cvmix_view,
+                               p_internal, m_impl->ens_gather_view, p_constant, timers);
+    }
+}
+
+bool TKE_cpu::calc_vertical_stability_impl(t_patch p_patch, t_ocean_state ocean_state, const t_index_range &range) {
+    YAOP_TIMER_START(timer_view_init, &m_thread_timers[0]);
+    if (!m_is_view_init)
+        bind_patch_and_state(p_patch, ocean_state);
+    YAOP_TIMER_STOP(timer_view_init, &m_thread_timers[0], timing_view_init);
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    if (!omp_in_parallel())
+        nthreads = omp_get_max_threads();
+#endif
+    reserve_thread_timers(nthreads);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int jb = range.cells_start_block; jb <= range.cells_end_block; jb++) {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        int start_index, end_index;
+        get_index_range(range.cells_block_size, range.cells_start_block, range.cells_end_block,
+                        range.cells_start_index, range.cells_end_index, jb, &start_index, &end_index);
+        t_thread_timers *timers = &m_thread_timers[thread];
+        timers->block = jb;
+        YAOP_TIMER_START(timer_nsqr_ssqr, timers);
+        update_geometry_cache(jb, start_index, end_index, m_impl->p_patch_view, m_impl->ocean_state_view,
+                              m_impl->p_geometry_view, p_constant);
+        ::calc_vertical_stability(jb, start_index, end_index, m_impl->p_patch_view, m_impl->ocean_state_view,
+                                  m_impl->p_geometry_view, m_impl->p_stability_view, p_constant);
+        YAOP_TIMER_STOP(timer_nsqr_ssqr, timers, timing_nsqr_ssqr);
+    }
+    return true;
+}
+
+bool TKE_cpu::calc_idemix_impl(t_patch p_patch, t_cvmix p_cvmix, t_ocean_state ocean_state, t_idemix p_idemix,
+                               t_horizontal_grid p_grid, const t_index_range &range) {
+    YAOP_TIMER_START(timer_view_init, &m_thread_timers[0]);
+    if (!m_is_view_init) {
+        bind_patch_and_state(p_patch, ocean_state);
+        fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                           (&m_impl->p_cvmix_view, &p_cvmix, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+    }
+    if (!m_is_idemix_view_init)
+        bind_idemix_fields(p_idemix, p_grid);
+    YAOP_TIMER_STOP(timer_view_init, &m_thread_timers[0], timing_view_init);
+
+    // the vertical stability published by calc_vertical_stability for this cells range is consumed once
+    bool is_stability_cached = consume_stability(range, &m_idemix_stability_generation);
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    if (!omp_in_parallel())
+        nthreads = omp_get_max_threads();
+#endif
+    while (static_cast<int>(m_impl->thread_scratch.size()) < nthreads - 1)
+        m_impl->add_thread_scratch(p_constant);
+    while (static_cast<int>(m_impl->idemix_scratch.size()) < nthreads)
+        m_impl->add_idemix_scratch(p_constant);
+    reserve_thread_timers(nthreads);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int jb = range.cells_start_block; jb <= range.cells_end_block; jb++) {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        struct t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal =
+            thread == 0 ? m_impl->p_internal_view : m_impl->thread_scratch[thread - 1];
+        int start_index, end_index;
+        get_index_range(range.cells_block_size, range.cells_start_block, range.cells_end_block,
+                        range.cells_start_index, range.cells_end_index, jb, &start_index, &end_index);
+        t_thread_timers *timers = &m_thread_timers[thread];
+        timers->block = jb;
+        YAOP_TIMER_START(timer_idemix, timers);
+        update_geometry_cache(jb, start_index, end_index, m_impl->p_patch_view, m_impl->ocean_state_view,
+                              m_impl->p_geometry_view, p_constant);
+        if (!is_stability_cached)
+            ::calc_vertical_stability(jb, start_index, end_index, m_impl->p_patch_view, m_impl->ocean_state_view,
+                                      m_impl->p_geometry_view, m_impl->p_stability_view, p_constant);
+        const struct t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> &p_idemix_internal =
+            m_impl->idemix_scratch[thread];
+        calc_idemix_vertical(jb, start_index, end_index, m_impl->p_patch_view, m_impl->p_idemix_view,
+                             m_impl->p_grid_view, m_impl->p_geometry_view, m_impl->p_stability_view,
+                             p_idemix_internal, p_internal, p_constant, p_constant_idemix);
+        // the dissipation is written to the bound field for a tke step called afterwards
+        for (int level = 0; level < p_constant.nlevs+1; level++)
+            for (int jc = start_index; jc <= end_index; jc++)
+                m_impl->p_cvmix_view.iwe_Tdis(jb, level, jc) = p_idemix_internal.iwe_Tdis(level, jc);
+        YAOP_TIMER_STOP(timer_idemix, timers, timing_idemix);
+    }
+
+    calc_idemix_horizontal_impl(range);
+    return true;
+}
+
+void TKE_cpu::calc_idemix_horizontal_impl(const t_index_range &range) {
+    // over edges: v0 and iwe of all the cell blocks are needed
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int jb = range.edges_start_block; jb <= range.edges_end_block; jb++) {
+        int start_index, end_index;
+        get_index_range(range.edges_block_size, range.edges_start_block, range.edges_end_block,
+                        range.edges_start_index, range.edges_end_index, jb, &start_index, &end_index);
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        t_thread_timers *timers = &m_thread_timers[thread];
+        timers->block = jb;
+        YAOP_TIMER_START(timer_idemix, timers);
+        calc_idemix_edges(jb, start_index, end_index, m_impl->p_patch_view, m_impl->p_idemix_view,
+                          m_impl->p_grid_view, m_impl->idemix_scratch[thread], p_constant, p_constant_idemix);
+        YAOP_TIMER_STOP(timer_idemix, timers, timing_idemix);
+    }
+
+    // over cells: divergence of the edge fluxes
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int jb = range.cells_start_block; jb <= range.cells_end_block; jb++) {
+        int start_index, end_index;
+        get_index_range(range.cells_block_size, range.cells_start_block, range.cells_end_block,
+                        range.cells_start_index, range.cells_end_index, jb, &start_index, &end_index);
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        t_thread_timers *timers = &m_thread_timers[thread];
+        timers->block = jb;
+        YAOP_TIMER_START(timer_idemix, timers);
+        calc_idemix_horizontal(jb, start_index, end_index, m_impl->p_patch_view, m_impl->p_idemix_view,
+                               m_impl->p_grid_view, m_impl->idemix_scratch[thread], p_constant);
+        YAOP_TIMER_STOP(timer_idemix, timers, timing_idemix);
+    }
+}
+
+void TKE_cpu::bind_tke_fields(t_patch p_patch, t_cvmix p_cvmix, t_ocean_state ocean_state,
+                              t_atmo_fluxes atmos_fluxes, t_atmos_for_ocean p_as, t_sea_ice p_sea_ice) {
+    bind_patch_and_state(p_patch, ocean_state);
+    fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                       (&m_impl->p_cvmix_view, &p_cvmix, p_constant.nblocks, p_constant.nlevs,
+                        p_constant.nproma);
+    fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                       (&m_impl->atmos_fluxes_view, &atmos_fluxes, p_constant.nblocks, p_constant.nproma);
+    fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                       (&m_impl->p_as_view, &p_as, p_constant.nblocks, p_constant.nproma);
+    fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                       (&m_impl->p_sea_ice_view, &p_sea_ice, p_constant.nblocks, p_constant.nproma);
+    m_is_view_init = true;
+}
+
+void TKE_cpu::bind_idemix_fields(t_idemix p_idemix, t_horizontal_grid p_grid) {
+    fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                       (&m_impl->p_idemix_view, &p_idemix, p_constant.nblocks, p_constant.nlevs,
+                        p_constant.nproma);
+    fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                       (&m_impl->p_grid_view, &p_grid, p_constant.nblocks, p_constant.nproma);
+    m_is_idemix_view_init = true;
+}
+
+void TKE_cpu::bind_patch_and_state(t_patch p_patch, t_ocean_state ocean_state) {
+    bool is_patch_changed = std::memcmp(&m_patch_bound, &p_patch, sizeof(t_patch)) != 0;
+    m_patch_bound = p_patch;
+    fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                       (&m_impl->p_patch_view, &p_patch, p_constant.nblocks, p_constant.nlevs,
+                        p_constant.nproma);
+    fill_struct_memview<cpu_memview::mdspan, cpu_memview::dextents, cpu_memview_policy>
+                       (&m_impl->ocean_state_view, &ocean_state, p_constant.nblocks, p_constant.nlevs,
+                        p_constant.nproma);
+    // the vertical grid cache and the edge gather table are kept when only the state fields are rebound
+    if (is_patch_changed) {
+        init_geometry_cache(m_impl->p_patch_view, m_impl->p_geometry_view, p_constant);
+        m_impl->build_edge_gather(false, m_impl->p_patch_view, &m_impl->gather_view, p_constant);
     }
 }
@@ -39,11 +39,19 @@ class TKE_cpu : public TKE_backend {
     */
     ~TKE_cpu();
 
+    /*! \brief Columns skipped in the last call by the quiescent columns mode.
+    *
+    *   The wet columns of the last cells range are counted, a block is skipped only when all of them are
+    *   quiescent.
+    */
+    t_quiescence_report quiescence_report() const override;
+
  protected:
     /*! \brief CPU implementation of TKE.
     *
-    *   It fills the memory view structures during the first call and then compute the
-    *   turbulent kinetic energy vertical scheme.
+    *   It fills the memory view structures when the bound pointers change and then compute the
+    *   turbulent kinetic energy vertical scheme. With OpenMP the blocks are distributed among the
+    *   threads, each one with its own block scratch arrays.
     */
     void calc_impl(struct t_patch p_patch, struct t_cvmix p_cvmix,
                    struct t_ocean_state ocean_state, struct t_atmo_fluxes atmos_fluxes,
@@ -52,6 +60,74 @@ class TKE_cpu : public TKE_backend {
                    int edges_start_index, int edges_end_index, int cells_block_size,
                    int cells_start_block, int cells_end_block, int cells_start_index,
                    int cells_end_index);
+
+    /*! \brief CPU implementation of the ensemble mode.
+    *
+    *   Each member has its own memory views, geometry cache and tke_Av, while the block scratch
+    *   arrays are per thread. All the (member, block) pairs are computed in one loop.
+    */
+    void calc_ensemble_impl(struct t_patch p_patch, int nmembers, const struct t_ensemble_member *members,
+                            const struct t_index_range &range);
+
+    /*! \brief CPU implementation of the vertical stability stage.
+    *
+    *   Nsqr and Ssqr of the blocks are computed into the persistent fields, which are then read by
+    *   calc_impl instead of evaluating the densities again.
+    */
+    bool calc_vertical_stability_impl(struct t_patch p_patch, struct t_ocean_state ocean_state,
+                                      const struct t_index_range &range);
+
+    /*! \brief CPU implementation of IDEMIX.
+    *
+    *   The vertical propagation, forcing and dissipation of the internal wave energy are computed by
+    *   blocks, with an implicit solve per column, then the horizontal propagation by an edges pass
+    *   and a cells pass. The dissipation is written to iwe_Tdis.
+    */
+    bool calc_idemix_impl(struct t_patch p_patch, struct t_cvmix p_cvmix, struct t_ocean_state ocean_state,
+                          struct t_idemix p_idemix, struct t_horizontal_grid p_grid,
+                          const struct t_index_range &range);
+
+    /*! \brief CPU implementation of the coupled IDEMIX and TKE step.
+    *
+    *   The vertical part of IDEMIX and tke are computed one after the other on the same block, so the
+    *   geometry, the vertical stability and the dissipation of the block are still in cache.
+    */
+    bool calc_idemix_tke_impl(struct t_patch p_patch, struct t_cvmix p_cvmix, struct t_ocean_state ocean_state,
+                              struct t_atmo_fluxes atmos_fluxes, struct t_atmos_for_ocean p_as,
+                              struct t_sea_ice p_sea_ice, struct t_idemix p_idemix,
+                              struct t_horizontal_grid p_grid, const struct t_index_range &range);
+
+ private:
+    /*! \brief Cells and edges loops of the tke step, optionally preceded by IDEMIX on each block.
+    *
+    */
+    void calc_cells_and_edges(const struct t_index_range &range, bool is_idemix_coupled);
+
+    /*! \brief Horizontal propagation of the internal wave energy, edges and then cells.
+    *
+    */
+    void calc_idemix_horizontal_impl(const struct t_index_range &range);
+
+    /*! \brief Fill the memory views of all the fields of the tke scheme.
+    *
+    */
+    void bind_tke_fields(struct t_patch p_patch, struct t_cvmix p_cvmix, struct t_ocean_state ocean_state,
+                         struct t_atmo_fluxes atmos_fluxes, struct t_atmos_for_ocean p_as,
+                         struct t_sea_ice p_sea_ice);
+
+    /*! \brief Fill the memory views of the IDEMIX fields and of the horizontal grid.
+    *
+    */
+    void bind_idemix_fields(struct t_idemix p_idemix, struct t_horizontal_grid p_grid);
+
+    /*! \brief Fill the memory views of the grid info and of the ocean state.
+    *
+    *   The geometry cache is initialized again only if the grid info pointers changed.
+    */
+    void bind_patch_and_state(struct t_patch p_patch, struct t_ocean_state ocean_state);
+
+    struct Impl;
+    Impl *m_impl;
 };
 
 #endif  // SRC_BACKENDS_CPU_TKE_CPU_HPP_
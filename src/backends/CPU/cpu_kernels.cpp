@@ -14,9 +14,13 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <limits>
+#include <utility>
+#include <vector>
 #include "src/backends/CPU/cpu_kernels.hpp"
 #include "src/backends/kernels.hpp"
 #include "src/shared/constants/constants_thermodyn.hpp"
+#include "src/shared/utils.hpp"
 
 void calc_impl_cells(int blockNo, int start_index, int end_index,
                      t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
@@ -26,47 +30,188 @@ void calc_impl_cells(int blockNo, int start_index, int end_index,
                      t_atmos_for_ocean_view<cpu_memview::mdspan, cpu_memview::dextents> p_as,
                      t_sea_ice_view<cpu_memview::mdspan, cpu_memview::dextents> p_sea_ice,
                      t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                     t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                     t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability,
+                     t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence,
+                     bool is_stability_cached,
                      t_constant p_constant,
-                     t_constant_tke p_constant_tke) {
-    // initialization
+                     t_constant_tke p_constant_tke,
+                     t_thread_timers *timers) {
+    YAOP_TIMER_START(timer_pre_integration, timers);
+    // refresh the geometry terms of this block only if stretch_c changed
+    update_geometry_cache(blockNo, start_index, end_index, p_patch, ocean_state, p_geometry, p_constant);
+    int max_levels = p_geometry.max_levels(blockNo);
+
+    // the stretched thicknesses are read from the block slice of the geometry cache
+    p_internal.dzw_stretched = cpu_memview_policy::memview(&p_geometry.dzw_stretched(blockNo, 0, 0),
+                                                           p_constant.nlevs, p_constant.nproma);
+    p_internal.dzt_stretched = cpu_memview_policy::memview(&p_geometry.dzt_stretched(blockNo, 0, 0),
+                                                           p_constant.nlevs+1, p_constant.nproma);
+
+    // pre-integration
+    for (int jc = start_index; jc <= end_index; jc++) {
+        double tau_abs = (1.0 - p_sea_ice.concsum(blockNo, jc))
+                          * sqrt((atmos_fluxes.stress_xw(blockNo, jc) *
+                                  atmos_fluxes.stress_xw(blockNo, jc))
+                               + (atmos_fluxes.stress_yw(blockNo, jc) *
+                                  atmos_fluxes.stress_yw(blockNo, jc)));
+        p_internal.forc_tke_surf_2D(jc) = tau_abs / p_constant.OceanReferenceDensity;
+    }
+    YAOP_TIMER_STOP(timer_pre_integration, timers, timing_pre_integration);
+
+    // the vertical stability published by calc_vertical_stability is not evaluated again
+    YAOP_TIMER_START(timer_nsqr_ssqr, timers);
+    if (!is_stability_cached)
+        calc_vertical_stability(blockNo, start_index, end_index, p_patch, ocean_state, p_geometry, p_stability,
+                                p_constant);
+    p_internal.Nsqr = cpu_memview_policy::memview(&p_stability.Nsqr(blockNo, 0, 0),
+                                                  p_constant.nlevs+1, p_constant.nproma);
+    p_internal.Ssqr = cpu_memview_policy::memview(&p_stability.Ssqr(blockNo, 0, 0),
+                                                  p_constant.nlevs+1, p_constant.nproma);
+    YAOP_TIMER_STOP(timer_nsqr_ssqr, timers, timing_nsqr_ssqr);
+
+    // the Stokes drift and the depth of the Langmuir cells are part of the forcing stage
+    if (p_constant.l_lc) {
+        YAOP_TIMER_START(timer_langmuir, timers);
+        calc_langmuir_depth(blockNo, start_index, end_index, max_levels, p_constant_tke.c_stokes,
+                            p_patch.dolic_c, p_patch.depth_CellInterface, p_internal.dzt_stretched,
+                            p_internal.Nsqr, p_as.fu10, p_sea_ice.concsum, p_cvmix.u_stokes, p_cvmix.hlc,
+                            p_internal.pot_energy_lc_2D);
+        YAOP_TIMER_STOP(timer_langmuir, timers, timing_forcing);
+    }
+
+    // the skipped blocks keep tke, the diffusivities and the diagnostics of their last full step
+    if (p_quiescence.skipped_steps.data_handle() != nullptr) {
+        YAOP_TIMER_START(timer_quiescence, timers);
+        bool is_quiescent = update_quiescence(blockNo, start_index, end_index, p_patch, p_internal,
+                                              p_quiescence, p_constant, p_constant_tke);
+        YAOP_TIMER_STOP(timer_quiescence, timers, timing_pre_integration);
+        if (is_quiescent)
+            return;
+    }
+
+    YAOP_TIMER_START(timer_initialization, timers);
+    // initialization, in the coupled IDEMIX step the internal wave dissipation is in the block scratch
+    bool is_iwe_Tdis_scratch = p_internal.iwe_Tdis.data_handle() != nullptr;
     for (int level = 0; level < p_constant.nlevs+1; level++) {
         for (int jc = start_index; jc <= end_index; jc++) {
             p_internal.tke_kv(level, jc) = 0.0;
             p_internal.tke_Av(blockNo, level, jc) = 0.0;
-            if (p_constant.vert_mix_type == p_constant.vmix_idemix_tke) {
+            if (is_iwe_Tdis_scratch) {
+                p_cvmix.tke_Tiwf(blockNo, level, jc) = -1.0 * p_internal.iwe_Tdis(level, jc);
+            } else if (p_constant.vert_mix_type == p_constant.vmix_idemix_tke) {
                 p_cvmix.tke_Tiwf(blockNo, level, jc) = -1.0 * p_cvmix.iwe_Tdis(blockNo, level, jc);
             } else {
                 p_cvmix.tke_Tiwf(blockNo, level, jc) = 0.0;
             }
-            p_internal.dzt_stretched(level, jc) = p_patch.prism_center_dist_c(blockNo, level, jc) *
-                                                  ocean_state.stretch_c(blockNo, jc);
         }
     }
 
-    for (int level = 0; level < p_constant.nlevs; level++)
-        for (int jc = start_index; jc <= end_index; jc++)
-            p_internal.dzw_stretched(level, jc) = p_patch.prism_thick_c(blockNo, level, jc) *
-                                                  ocean_state.stretch_c(blockNo, jc);
-
-    // pre-integration
     for (int level = 0; level < p_constant.nlevs+1; level++)
         for (int jc = start_index; jc <= end_index; jc++)
             p_internal.tke_old(level, jc) = p_cvmix.tke(blockNo, level, jc);
+    YAOP_TIMER_STOP(timer_initialization, timers, timing_pre_integration);
+
+    // integration, the substeps share the geometry, the vertical stability and the surface forcing
+    for (int substep = 0; substep < p_constant_tke.nsubsteps; substep++) {
+        if (substep > 0) {
+            for (int level = 0; level < p_constant.nlevs+1; level++)
+                for (int jc = start_index; jc <= end_index; jc++)
+                    p_internal.tke_old(level, jc) = p_cvmix.tke(blockNo, level, jc);
+        }
+        integrate(blockNo, start_index, end_index, max_levels, p_patch, p_cvmix, p_internal, p_constant,
+                  p_constant_tke, substep == p_constant_tke.nsubsteps-1, timers);
+    }
+
+    //  write tke vert. diffusivity to vert tracer diffusivities
+    for (int level = 0; level < p_constant.nlevs+1; level++) {
+        for (int jc = start_index; jc <= end_index; jc++) {
+            p_cvmix.a_temp_v(blockNo, level, jc) = p_internal.tke_kv(level, jc);
+            p_cvmix.a_salt_v(blockNo, level, jc) = p_internal.tke_kv(level, jc);
+        }
+    }
+
+    if (p_quiescence.skipped_steps.data_handle() != nullptr)
+        record_activity(blockNo, start_index, end_index, p_patch, p_cvmix, p_quiescence);
+}
+
+bool update_quiescence(int blockNo, int start_index, int end_index,
+                       t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                       t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                       t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence,
+                       t_constant p_constant,
+                       t_constant_tke p_constant_tke) {
+    // a full step is forced after quiescent_refresh skipped steps
+    if (p_quiescence.skipped_steps(blockNo) >= p_constant_tke.quiescent_refresh) {
+        p_quiescence.skipped_steps(blockNo) = 0;
+        return false;
+    }
 
     for (int jc = start_index; jc <= end_index; jc++) {
-        double tau_abs = (1.0 - p_sea_ice.concsum(blockNo, jc))
-                          * sqrt((atmos_fluxes.stress_xw(blockNo, jc) *
-                                  atmos_fluxes.stress_xw(blockNo, jc))
-                               + (atmos_fluxes.stress_yw(blockNo, jc) *
-                                  atmos_fluxes.stress_yw(blockNo, jc)));
-        p_internal.forc_tke_surf_2D(jc) = tau_abs / p_constant.OceanReferenceDensity;
+        if (p_patch.dolic_c(blockNo, jc) > 0 &&
+            tke_tendency_bound(blockNo, jc, p_patch, p_internal, p_quiescence, p_constant_tke) >=
+            p_constant_tke.quiescent_threshold) {
+            p_quiescence.skipped_steps(blockNo) = 0;
+            return false;
+        }
     }
 
-    // compute max level on block (maxval fortran function)
-    int max_levels = 0;
+    // all the columns are quiescent, the error bound accumulates over the skipped steps
+    double dtime = p_constant.dtime * p_constant_tke.nsubsteps;
     for (int jc = start_index; jc <= end_index; jc++)
-        if (p_patch.dolic_c(blockNo, jc) > max_levels)
-            max_levels = p_patch.dolic_c(blockNo, jc);
+        if (p_patch.dolic_c(blockNo, jc) > 0)
+            p_quiescence.error_bound(blockNo, jc) += dtime * tke_tendency_bound(blockNo, jc, p_patch, p_internal,
+                                                                                p_quiescence, p_constant_tke);
+    p_quiescence.skipped_steps(blockNo)++;
+    return true;
+}
+
+double tke_tendency_bound(int blockNo, int jc,
+                          t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                          t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                          t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence,
+                          t_constant_tke p_constant_tke) {
+    // the tendency of the last full step, the wind forcing and the shear production with the
+    // diffusivity of the last full step
+    double bound = max(p_quiescence.activity(blockNo, jc),
+                       p_constant_tke.cd * pow(p_internal.forc_tke_surf_2D(jc), 1.5) / p_internal.dzt_stretched(0, jc));
+    for (int level = 1; level < p_patch.dolic_c(blockNo, jc); level++)
+        bound = max(bound, p_internal.Ssqr(level, jc) * p_internal.tke_Av(blockNo, level, jc));
+    return bound;
+}
+
+void record_activity(int blockNo, int start_index, int end_index,
+                     t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                     t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+                     t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence) {
+    for (int jc = start_index; jc <= end_index; jc++) {
+        double activity = 0.0;
+        for (int level = 0; level < p_patch.dolic_c(blockNo, jc)+1; level++)
+            activity = max(activity, fabs(p_cvmix.tke_Ttot(blockNo, level, jc)));
+        p_quiescence.activity(blockNo, jc) = activity;
+        p_quiescence.error_bound(blockNo, jc) = 0.0;
+    }
+}
+
+void calc_vertical_stability(int blockNo, int start_index, int end_index,
+                             t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                             t_ocean_state_view<cpu_memview::mdspan, cpu_memview::dextents> ocean_state,
+                             t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                             t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability,
+                             t_constant p_constant) {
+    int max_levels = p_geometry.max_levels(blockNo);
+
+    // surface and levels below the deepest wet interface of the block are zero
+    for (int jc = start_index; jc <= end_index; jc++) {
+        p_stability.Nsqr(blockNo, 0, jc) = 0.0;
+        p_stability.Ssqr(blockNo, 0, jc) = 0.0;
+    }
+    for (int level = max(max_levels, 1); level < p_constant.nlevs+1; level++) {
+        for (int jc = start_index; jc <= end_index; jc++) {
+            p_stability.Nsqr(blockNo, level, jc) = 0.0;
+            p_stability.Ssqr(blockNo, level, jc) = 0.0;
+        }
+    }
 
     // Loop over internal interfaces, surface (jk=1) and bottom (jk=kbot+1) excluded
     for (int level = 1; level < max_levels; level++) {
@@ -74,69 +219,245 @@ void calc_impl_cells(int blockNo, int start_index, int end_index,
             if (level < p_patch.dolic_c(blockNo, jc)) {
                 double rho_up = calculate_density(ocean_state.temp(blockNo, level-1, jc),
                                                   ocean_state.salt(blockNo, level-1, jc),
-                                                  p_patch.zlev_i(level) *
-                                                  p_constant.ReferencePressureIndbars);
+                                                  p_geometry.pressure(level));
                 double rho_down = calculate_density(ocean_state.temp(blockNo, level, jc),
                                                     ocean_state.salt(blockNo, level, jc),
-                                                    p_patch.zlev_i(level) *
-                                                    p_constant.ReferencePressureIndbars);
-                p_internal.Nsqr(level, jc) = p_constant.grav / p_constant.OceanReferenceDensity *
-                                             (rho_down - rho_up) *
-                                             p_patch.inv_prism_center_dist_c(blockNo, level, jc) /
-                                             ocean_state.stretch_c(blockNo, jc);
-                p_internal.Ssqr(level, jc) = pow((ocean_state.p_vn_x1(blockNo, level-1, jc) -
-                                             ocean_state.p_vn_x1(blockNo, level, jc) ) *
-                                             p_patch.inv_prism_center_dist_c(blockNo, level, jc) /
-                                             ocean_state.stretch_c(blockNo, jc) , 2.0) +
-                                             pow((ocean_state.p_vn_x2(blockNo, level-1, jc) -
-                                             ocean_state.p_vn_x2(blockNo, level, jc) ) *
-                                             p_patch.inv_prism_center_dist_c(blockNo, level, jc) /
-                                             ocean_state.stretch_c(blockNo, jc) , 2.0) +
-                                             pow((ocean_state.p_vn_x3(blockNo, level-1, jc) -
-                                             ocean_state.p_vn_x3(blockNo, level, jc) ) *
-                                             p_patch.inv_prism_center_dist_c(blockNo, level, jc) /
-                                             ocean_state.stretch_c(blockNo, jc) , 2.0);
+                                                    p_geometry.pressure(level));
+                double inv_dzt = p_geometry.inv_dzt_stretched(blockNo, level, jc);
+                double du1 = (ocean_state.p_vn_x1(blockNo, level-1, jc) -
+                              ocean_state.p_vn_x1(blockNo, level, jc)) * inv_dzt;
+                double du2 = (ocean_state.p_vn_x2(blockNo, level-1, jc) -
+                              ocean_state.p_vn_x2(blockNo, level, jc)) * inv_dzt;
+                double du3 = (ocean_state.p_vn_x3(blockNo, level-1, jc) -
+                              ocean_state.p_vn_x3(blockNo, level, jc)) * inv_dzt;
+                p_stability.Nsqr(blockNo, level, jc) = p_constant.grav / p_constant.OceanReferenceDensity *
+                                                       (rho_down - rho_up) * inv_dzt;
+                p_stability.Ssqr(blockNo, level, jc) = du1 * du1 + du2 * du2 + du3 * du3;
+            } else {
+                p_stability.Nsqr(blockNo, level, jc) = 0.0;
+                p_stability.Ssqr(blockNo, level, jc) = 0.0;
             }
         }
     }
+}
 
-    for (int level = 0; level < max_levels; level++)
+void calc_pp_cells(int blockNo, int start_index, int end_index,
+                   t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                   t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+                   t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability,
+                   mdspan_3d_double pp_Av,
+                   t_constant p_constant,
+                   t_constant_pp p_constant_pp) {
+    // branch free over the columns: the interfaces outside of the wet ones are zero
+    for (int level = 0; level < p_constant.nlevs+1; level++) {
+        for (int jc = start_index; jc <= end_index; jc++) {
+            double Ri = p_stability.Nsqr(blockNo, level, jc) / max(p_stability.Ssqr(blockNo, level, jc), 1.0e-12);
+            double f = 1.0 / (1.0 + p_constant_pp.c1_pp * max(Ri, 0.0));
+            double A_v = p_constant_pp.velocity_background + p_constant_pp.richardson_factor_veloc * f * f;
+            double A_t = p_constant_pp.tracer_background + p_constant_pp.richardson_factor_tracer * f * f * f;
+            // statically unstable interfaces are mixed by convection
+            bool is_convective = Ri < p_constant_pp.convection_threshold;
+            A_v = is_convective ? p_constant_pp.max_vert_diff_veloc : A_v;
+            A_t = is_convective ? p_constant_pp.max_vert_diff_tracer : A_t;
+            bool is_wet = level > 0 && level < p_patch.dolic_c(blockNo, jc);
+            pp_Av(blockNo, level, jc) = is_wet ? A_v : 0.0;
+            p_cvmix.a_temp_v(blockNo, level, jc) = is_wet ? A_t : 0.0;
+            p_cvmix.a_salt_v(blockNo, level, jc) = is_wet ? A_t : 0.0;
+        }
+    }
+}
+
+void calc_idemix_vertical(int blockNo, int start_index, int end_index,
+                          t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                          t_idemix_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix,
+                          t_horizontal_grid_view<cpu_memview::mdspan, cpu_memview::dextents> p_grid,
+                          t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                          t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability,
+                          t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix_internal,
+                          t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                          t_constant p_constant,
+                          t_constant_idemix p_constant_idemix) {
+    int max_levels = p_geometry.max_levels(blockNo);
+    double dtime = p_constant.dtime;
+
+    // vertically integrated buoyancy frequency of the column
+    for (int jc = start_index; jc <= end_index; jc++)
+        p_idemix_internal.bN0(jc) = 0.0;
+    for (int level = 1; level < max_levels; level++)
         for (int jc = start_index; jc <= end_index; jc++)
-            p_internal.dzw_stretched(level, jc) = p_patch.prism_thick_c(blockNo, level, jc) *
-                                                  ocean_state.stretch_c(blockNo, jc);
-    for (int level = 0; level < max_levels+1; level++)
+            if (level < p_patch.dolic_c(blockNo, jc))
+                p_idemix_internal.bN0(jc) += sqrt(max(0.0, p_stability.Nsqr(blockNo, level, jc))) *
+                                             p_geometry.dzt_stretched(blockNo, level, jc);
+
+    // group velocities of the internal waves and dissipation coefficient, zero outside of the wet interfaces
+    for (int level = 0; level < p_constant.nlevs+1; level++) {
+        for (int jc = start_index; jc <= end_index; jc++) {
+            double fc = fabs(p_grid.f_c(blockNo, jc));
+            double fxa = sqrt(max(0.0, p_stability.Nsqr(blockNo, level, jc))) / (1.0e-22 + fc);
+            double cstar = max(1.0e-2, p_idemix_internal.bN0(jc) / (p_constant.pi * p_constant_idemix.jstar));
+            bool is_wet = p_patch.dolic_c(blockNo, jc) > 0 && level <= p_patch.dolic_c(blockNo, jc);
+            p_idemix_internal.c0(level, jc) = is_wet ?
+                max(0.0, p_constant_idemix.gamma * cstar * idemix_gofx2(fxa, p_constant.pi)) : 0.0;
+            p_idemix_internal.v0(blockNo, level, jc) = is_wet ?
+                max(0.0, p_constant_idemix.gamma * cstar * idemix_hofx1(fxa, p_constant.pi)) : 0.0;
+            p_idemix_internal.alpha_c(level, jc) = is_wet ?
+                max(1.0e-4, p_constant_idemix.mu0 * acosh(max(1.0, fxa)) * fc / (cstar * cstar)) : 0.0;
+            p_idemix_internal.iwe_old(level, jc) = p_idemix.iwe(blockNo, level, jc);
+        }
+    }
+
+    // implicit vertical propagation (no flux through the surface and the bottom), forcing and
+    // dissipation linearised with the old energy. The rows of the dry columns are the identity.
+    for (int level = 0; level < max_levels+1; level++) {
+        for (int jc = start_index; jc <= end_index; jc++) {
+            int dolic = p_patch.dolic_c(blockNo, jc);
+            if (level <= dolic) {
+                int up = max(level-1, 0);
+                int down = min(level+1, dolic);
+                double dzt = p_geometry.dzt_stretched(blockNo, level, jc);
+                double delta_up = level > 0 ? dtime * p_constant_idemix.tau_v * 0.5 *
+                                  (p_idemix_internal.c0(up, jc) + p_idemix_internal.c0(level, jc)) /
+                                  p_geometry.dzw_stretched(blockNo, up, jc) : 0.0;
+                double delta_down = level < dolic ? dtime * p_constant_idemix.tau_v * 0.5 *
+                                    (p_idemix_internal.c0(level, jc) + p_idemix_internal.c0(down, jc)) /
+                                    p_geometry.dzw_stretched(blockNo, level, jc) : 0.0;
+                double forcing = (level == 0 ? p_idemix.forc_iw_surface(blockNo, jc) : 0.0) +
+                                 (level == dolic ? p_idemix.forc_iw_bottom(blockNo, jc) : 0.0);
+                p_internal.a_tri(level, jc) = - delta_up * p_idemix_internal.c0(up, jc) / dzt;
+                p_internal.b_tri(level, jc) = 1.0 + (delta_up + delta_down) * p_idemix_internal.c0(level, jc) / dzt +
+                                              dtime * p_idemix_internal.alpha_c(level, jc) *
+                                              p_idemix_internal.iwe_old(level, jc);
+                p_internal.c_tri(level, jc) = - delta_down * p_idemix_internal.c0(down, jc) / dzt;
+                p_internal.d_tri(level, jc) = p_idemix_internal.iwe_old(level, jc) +
+                                              (dolic > 0 ? dtime * forcing / dzt : 0.0);
+            }
+        }
+    }
+
+    solve_tridiag(blockNo, start_index, end_index, max_levels, p_patch.dolic_c,
+                  p_internal.a_tri, p_internal.b_tri, p_internal.c_tri, p_internal.d_tri,
+                  p_idemix.iwe, p_internal.cp, p_internal.dp);
+
+    // dissipation, the forcing of tke
+    for (int level = 0; level < p_constant.nlevs+1; level++)
         for (int jc = start_index; jc <= end_index; jc++)
-            p_internal.dzt_stretched(level, jc) = p_patch.prism_center_dist_c(blockNo, level, jc) *
-                                                  ocean_state.stretch_c(blockNo, jc);
+            p_idemix_internal.iwe_Tdis(level, jc) = level <= p_patch.dolic_c(blockNo, jc) ?
+                - p_idemix_internal.alpha_c(level, jc) * p_idemix_internal.iwe_old(level, jc) *
+                p_idemix.iwe(blockNo, level, jc) : 0.0;
+}
 
-    // integration
-    integrate(blockNo, start_index, end_index, p_patch, p_cvmix, p_internal, p_constant,
-              p_constant_tke);
+void calc_idemix_edges(int blockNo, int start_index, int end_index,
+                       t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                       t_idemix_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix,
+                       t_horizontal_grid_view<cpu_memview::mdspan, cpu_memview::dextents> p_grid,
+                       t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix_internal,
+                       t_constant p_constant,
+                       t_constant_idemix p_constant_idemix) {
+    // down-gradient flux of v0 * iwe from the first to the second cell, only between wet interfaces
+    for (int level = 0; level < p_constant.nlevs+1; level++) {
+        for (int je = start_index; je <= end_index; je++) {
+            int cell_1_idx = p_patch.edges_cell_idx(0, blockNo, je);
+            int cell_1_block = p_patch.edges_cell_blk(0, blockNo, je);
+            int cell_2_idx = p_patch.edges_cell_idx(1, blockNo, je);
+            int cell_2_block = p_patch.edges_cell_blk(1, blockNo, je);
+            double v0_1 = p_idemix_internal.v0(cell_1_block, level, cell_1_idx);
+            double v0_2 = p_idemix_internal.v0(cell_2_block, level, cell_2_idx);
+            double flux = p_constant_idemix.tau_h * 0.5 * (v0_1 + v0_2) *
+                          (v0_2 * p_idemix.iwe(cell_2_block, level, cell_2_idx) -
+                           v0_1 * p_idemix.iwe(cell_1_block, level, cell_1_idx)) /
+                          p_grid.edges_dual_edge_length(blockNo, je);
+            int dolic_e = p_patch.dolic_e(blockNo, je);
+            p_idemix_internal.flux_h(blockNo, level, je) = dolic_e > 0 && level <= dolic_e ? flux : 0.0;
+        }
+    }
+}
 
-    //  write tke vert. diffusivity to vert tracer diffusivities
+void calc_idemix_horizontal(int blockNo, int start_index, int end_index,
+                            t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                            t_idemix_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix,
+                            t_horizontal_grid_view<cpu_memview::mdspan, cpu_memview::dextents> p_grid,
+                            t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix_internal,
+                            t_constant p_constant) {
+    // explicit update with the divergence of the edge fluxes, gathered by each cell (no write conflicts)
     for (int level = 0; level < p_constant.nlevs+1; level++) {
         for (int jc = start_index; jc <= end_index; jc++) {
-            p_cvmix.a_temp_v(blockNo, level, jc) = p_internal.tke_kv(level, jc);
-            p_cvmix.a_salt_v(blockNo, level, jc) = p_internal.tke_kv(level, jc);
+            double div = 0.0;
+            for (int i = 0; i < 3; i++) {
+                int edge_idx = p_grid.cells_edge_idx(i, blockNo, jc);
+                int edge_block = p_grid.cells_edge_blk(i, blockNo, jc);
+                div += p_grid.cells_edge_orientation(i, blockNo, jc) *
+                       p_idemix_internal.flux_h(edge_block, level, edge_idx) *
+                       p_grid.edges_primal_edge_length(edge_block, edge_idx);
+            }
+            int dolic = p_patch.dolic_c(blockNo, jc);
+            if (dolic > 0 && level <= dolic)
+                p_idemix.iwe(blockNo, level, jc) += p_constant.dtime * div / p_grid.cells_area(blockNo, jc);
         }
     }
 }
 
-void integrate(int blockNo, int start_index, int end_index,
-               t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
-               t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
-               t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
-               t_constant p_constant,
-               t_constant_tke p_constant_tke) {
-    double tke_surf, diff_surf_forc, tke_bott, diff_bott_forc;
+void init_geometry_cache(t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                         t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                         t_constant p_constant) {
+    // the reference pressure only depends on the vertical grid
+    for (int level = 0; level < p_constant.nlevs; level++)
+        p_geometry.pressure(level) = p_patch.zlev_i(level) * p_constant.ReferencePressureIndbars;
+
+    // NaN never compares equal, so every block is refreshed at its first use
+    for (int jb = 0; jb < p_constant.nblocks; jb++)
+        for (int jc = 0; jc < p_constant.nproma; jc++)
+            p_geometry.stretch_c(jb, jc) = std::numeric_limits<double>::quiet_NaN();
+}
+
+void update_geometry_cache(int blockNo, int start_index, int end_index,
+                           t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                           t_ocean_state_view<cpu_memview::mdspan, cpu_memview::dextents> ocean_state,
+                           t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                           t_constant p_constant) {
+    // cheap change check: stretch_c is the only time dependent input of the geometry terms
+    bool is_changed = false;
+    for (int jc = start_index; jc <= end_index; jc++)
+        is_changed |= (p_geometry.stretch_c(blockNo, jc) != ocean_state.stretch_c(blockNo, jc));
+    if (!is_changed)
+        return;
 
-    // compute max level on block (maxval fortran function)
-    int max_levels = 0;
     for (int jc = start_index; jc <= end_index; jc++)
+        p_geometry.stretch_c(blockNo, jc) = ocean_state.stretch_c(blockNo, jc);
+
+    for (int level = 0; level < p_constant.nlevs; level++)
+        for (int jc = start_index; jc <= end_index; jc++)
+            p_geometry.dzw_stretched(blockNo, level, jc) = p_patch.prism_thick_c(blockNo, level, jc) *
+                                                           ocean_state.stretch_c(blockNo, jc);
+
+    for (int level = 0; level < p_constant.nlevs+1; level++) {
+        for (int jc = start_index; jc <= end_index; jc++) {
+            p_geometry.dzt_stretched(blockNo, level, jc) = p_patch.prism_center_dist_c(blockNo, level, jc) *
+                                                           ocean_state.stretch_c(blockNo, jc);
+            p_geometry.inv_dzt_stretched(blockNo, level, jc) = p_patch.inv_prism_center_dist_c(blockNo, level, jc) /
+                                                               ocean_state.stretch_c(blockNo, jc);
+        }
+    }
+
+    // compute max level on the whole block (maxval fortran function), later calls can use other index ranges
+    int max_levels = 0;
+    for (int jc = 0; jc < p_constant.nproma; jc++)
         if (p_patch.dolic_c(blockNo, jc) > max_levels)
             max_levels = p_patch.dolic_c(blockNo, jc);
+    p_geometry.max_levels(blockNo) = max_levels;
+}
+
+void integrate(int blockNo, int start_index, int end_index, int max_levels,
+               t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+               t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+               t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+               t_constant p_constant,
+               t_constant_tke p_constant_tke,
+               bool is_diagnostics,
+               [[maybe_unused]] t_thread_timers *timers) {
+    double tke_surf = 0.0, diff_surf_forc = 0.0, tke_bott = 0.0, diff_bott_forc = 0.0;
 
     // Initialize diagnostics and calculate mixing length scale
+    YAOP_TIMER_START(timer_mixing_length, timers);
     for (int level = 0; level < p_constant.nlevs+1; level++) {
         for (int jc = start_index; jc <= end_index; jc++) {
             p_cvmix.tke_Twin(blockNo, level, jc) = 0.0;
@@ -146,28 +467,36 @@ void integrate(int blockNo, int start_index, int end_index,
         }
     }
 
+    // the choice is validated in the backend constructor
     if (p_constant_tke.tke_mxl_choice == 2) {
         calc_mxl_2(blockNo, start_index, end_index, max_levels, p_constant_tke.mxl_min,
                    p_patch.dolic_c, p_cvmix.tke_Lmix, p_internal.dzw_stretched);
     } else if (p_constant_tke.tke_mxl_choice == 3) {
-        // TODO(EnricoDeg): not default
-    } else {
-        // Error
+        calc_mxl_3(blockNo, start_index, end_index, max_levels, p_constant_tke.mxl_min,
+                   p_patch.dolic_c, p_cvmix.tke_Lmix, p_patch.depth_CellInterface);
     }
+    YAOP_TIMER_STOP(timer_mixing_length, timers, timing_mixing_length);
 
     // calculate diffusivities
+    YAOP_TIMER_START(timer_diffusivity, timers);
     calc_diffusivity(blockNo, start_index, end_index, max_levels, &p_constant_tke,
                      p_patch.dolic_c, p_cvmix.tke_Lmix, p_internal.sqrttke,
                      p_internal.Nsqr, p_internal.Ssqr,
                      p_internal.tke_Av, p_internal.tke_kv, p_cvmix.tke_Pr);
+    YAOP_TIMER_STOP(timer_diffusivity, timers, timing_diffusivity);
 
     // tke forcing
+    YAOP_TIMER_START(timer_forcing, timers);
     calc_forcing(blockNo, start_index, end_index, max_levels, p_constant.l_lc, p_constant_tke.only_tke,
+                 p_constant.clc, p_constant.pi,
                  p_patch.dolic_c, p_internal.Ssqr, p_internal.Nsqr, p_internal.tke_Av,
                  p_internal.tke_kv, p_cvmix.tke_Tspr, p_cvmix.tke_Tbpr,
+                 p_patch.depth_CellInterface, p_cvmix.hlc, p_cvmix.u_stokes, p_cvmix.wlc,
                  p_cvmix.tke_plc, p_cvmix.tke_Tiwf, p_internal.forc);
+    YAOP_TIMER_STOP(timer_forcing, timers, timing_forcing);
 
     // vertical dissipation and diffusion solved implicitly
+    YAOP_TIMER_START(timer_tridiag_build, timers);
     build_diffusion_dissipation_tridiag(blockNo, start_index, end_index, max_levels,
                                         p_patch.dolic_c, p_constant_tke.alpha_tke,
                                         p_internal.tke_Av, p_internal.dzt_stretched,
@@ -234,13 +563,35 @@ void integrate(int blockNo, int start_index, int end_index,
                   p_internal.a_dif, p_internal.b_dif, p_internal.c_dif,
                   p_internal.sqrttke, p_cvmix.tke_Lmix, p_internal.tke_upd, p_internal.forc,
                   p_internal.a_tri, p_internal.b_tri, p_internal.c_tri, p_internal.d_tri);
+    YAOP_TIMER_STOP(timer_tridiag_build, timers, timing_tridiag_build);
 
     // solve the tri-diag matrix
-    solve_tridiag(blockNo, start_index, end_index, max_levels, p_patch.dolic_c,
-                  p_internal.a_tri, p_internal.b_tri, p_internal.c_tri,
-                  p_internal.d_tri, p_cvmix.tke, p_internal.cp, p_internal.dp);
+    YAOP_TIMER_START(timer_solve, timers);
+    if (p_constant_tke.tridiag_solver == tridiag_pcr)
+        solve_tridiag_pcr(blockNo, start_index, end_index, p_patch.dolic_c,
+                          p_internal.a_tri, p_internal.b_tri, p_internal.c_tri,
+                          p_internal.d_tri, p_cvmix.tke);
+    else
+        solve_tridiag(blockNo, start_index, end_index, max_levels, p_patch.dolic_c,
+                      p_internal.a_tri, p_internal.b_tri, p_internal.c_tri,
+                      p_internal.d_tri, p_cvmix.tke, p_internal.cp, p_internal.dp);
+    YAOP_TIMER_STOP(timer_solve, timers, timing_solve);
 
     // diagnose implicite tendencies (only for diagnostics)
+    YAOP_TIMER_START(timer_diagnostics, timers);
+    // the intermediate substeps only restrict tke
+    if (!is_diagnostics) {
+        if (p_constant_tke.only_tke) {
+            for (int level = 0; level < max_levels+1; level++)
+                for (int jc = start_index; jc <= end_index; jc++)
+                    if (level < p_patch.dolic_c(blockNo, jc) + 1)
+                        p_cvmix.tke(blockNo, level, jc) = max(p_cvmix.tke(blockNo, level, jc),
+                                                              p_constant_tke.tke_min);
+        }
+        YAOP_TIMER_STOP(timer_diagnostics, timers, timing_diagnostics);
+        return;
+    }
+
     // vertical diffusion of TKE
     tke_vertical_diffusion(blockNo, start_index, end_index, max_levels, p_patch.dolic_c,
                            diff_surf_forc, diff_bott_forc,
@@ -348,9 +699,9 @@ void integrate(int blockNo, int start_index, int end_index,
             p_cvmix.cvmix_dummy_3(blockNo, level, jc) = p_internal.Nsqr(level, jc);
         }
     }
+    YAOP_TIMER_STOP(timer_diagnostics, timers, timing_diagnostics);
 }
 
-inline
 void calc_mxl_2(int blockNo, int start_index, int end_index, int max_levels, double mxl_min,
                 mdspan_2d_int dolic_c, mdspan_3d_double tke_Lmix, mdspan_2d_double dzw_stretched) {
     for (int jc = start_index; jc <= end_index; jc++) {
@@ -385,7 +736,26 @@ void calc_mxl_2(int blockNo, int start_index, int end_index, int max_levels, dou
                 tke_Lmix(blockNo, level, jc) = max(tke_Lmix(blockNo, level, jc), mxl_min);
 }
 
-inline
+void calc_mxl_3(int blockNo, int start_index, int end_index, int max_levels, double mxl_min,
+                mdspan_2d_int dolic_c, mdspan_3d_double tke_Lmix, mdspan_3d_double depth_CellInterface) {
+    // tke_mxl_choice == 3 of cvmix_tke (CVMix-src, src/shared/cvmix_tke.F90): the inner interfaces are
+    // bounded by the distance to the surface and to the bottom, then all of them by mxl_min, level by level
+    // over all the columns: the depth of the bottom interface is the only gather
+    for (int level = 0; level < max_levels+1; level++) {
+        for (int jc = start_index; jc <= end_index; jc++) {
+            int dolic = dolic_c(blockNo, jc);
+            if (level < dolic + 1) {
+                double Lmix = tke_Lmix(blockNo, level, jc);
+                if (level > 0 && level < dolic) {
+                    double depth = depth_CellInterface(blockNo, level, jc);
+                    Lmix = min(Lmix, min(fabs(depth), fabs(depth - depth_CellInterface(blockNo, dolic, jc))));
+                }
+                tke_Lmix(blockNo, level, jc) = max(Lmix, mxl_min);
+            }
+        }
+    }
+}
+
 void calc_diffusivity(int blockNo, int start_index, int end_index, int max_levels,
                       t_constant_tke *p_constant_tke,
                       mdspan_2d_int dolic_c, mdspan_3d_double tke_Lmix, mdspan_2d_double sqrttke,
@@ -412,11 +782,38 @@ void calc_diffusivity(int blockNo, int start_index, int end_index, int max_level
     }
 }
 
-inline
+void calc_langmuir_depth(int blockNo, int start_index, int end_index, int max_levels, double c_stokes,
+                         mdspan_2d_int dolic_c, mdspan_3d_double depth_CellInterface, mdspan_2d_double dzt_stretched,
+                         mdspan_2d_double Nsqr, mdspan_2d_double fu10, mdspan_2d_double concsum,
+                         mdspan_2d_double u_stokes, mdspan_2d_double hlc, mdspan_1d_double pot_energy) {
+    // Stokes drift of the wind waves, the cells reach at most the bottom
+    for (int jc = start_index; jc <= end_index; jc++) {
+        u_stokes(blockNo, jc) = c_stokes * fu10(blockNo, jc) * (1.0 - concsum(blockNo, jc));
+        hlc(blockNo, jc) = depth_CellInterface(blockNo, dolic_c(blockNo, jc), jc);
+        pot_energy(jc) = 0.0;
+    }
+
+    // first interface where the potential energy of the stratification above exceeds
+    // the kinetic energy of the Stokes drift (Axell 2002), the energy is not decreasing with depth
+    for (int level = 1; level < max_levels+1; level++) {
+        for (int jc = start_index; jc <= end_index; jc++) {
+            if (level <= dolic_c(blockNo, jc)) {
+                pot_energy(jc) += max(0.0, Nsqr(level, jc)) * depth_CellInterface(blockNo, level, jc) *
+                                  dzt_stretched(level, jc);
+                if (pot_energy(jc) >= 0.5 * u_stokes(blockNo, jc) * u_stokes(blockNo, jc))
+                    hlc(blockNo, jc) = min(hlc(blockNo, jc), depth_CellInterface(blockNo, level, jc));
+            }
+        }
+    }
+}
+
 void calc_forcing(int blockNo, int start_index, int end_index, int max_levels, bool l_lc, bool only_tke,
+                  double clc, double pi,
                   mdspan_2d_int dolic_c, mdspan_2d_double Ssqr, mdspan_2d_double Nsqr, mdspan_3d_double tke_Av,
                   mdspan_2d_double tke_kv, mdspan_3d_double tke_Tspr, mdspan_3d_double tke_Tbpr,
-                  mdspan_3d_double tke_plc, mdspan_3d_double tke_Tiwf, mdspan_2d_double forc) {
+                  mdspan_3d_double depth_CellInterface, mdspan_2d_double hlc, mdspan_2d_double u_stokes,
+                  mdspan_3d_double wlc, mdspan_3d_double tke_plc, mdspan_3d_double tke_Tiwf,
+                  mdspan_2d_double forc) {
     for (int level = 0; level < max_levels+1; level++) {
         for (int jc = start_index; jc <= end_index; jc++) {
             if (level < dolic_c(blockNo, jc) + 1) {
@@ -426,9 +823,19 @@ void calc_forcing(int blockNo, int start_index, int end_index, int max_levels, b
                 if (level == 0) tke_Tbpr(blockNo, 0, jc) = 0.0;
 
                 forc(level, jc) = tke_Tspr(blockNo, level, jc) - tke_Tbpr(blockNo, level, jc);
-                // additional langmuir turbulence term
-                if (l_lc)
-                    forc(level, jc) += tke_plc(blockNo, level, jc);
+                // additional langmuir turbulence term, from the vertical velocity of the cells above hlc
+                if (l_lc) {
+                    double depth = depth_CellInterface(blockNo, level, jc);
+                    double wlc_level = 0.0;
+                    double plc_level = 0.0;
+                    if (depth < hlc(blockNo, jc)) {
+                        wlc_level = clc * u_stokes(blockNo, jc) * sin(pi * depth / hlc(blockNo, jc));
+                        plc_level = wlc_level * wlc_level * wlc_level / hlc(blockNo, jc);
+                    }
+                    wlc(blockNo, level, jc) = wlc_level;
+                    tke_plc(blockNo, level, jc) = plc_level;
+                    forc(level, jc) += plc_level;
+                }
                 // forcing by internal wave dissipation
                 if (!only_tke)
                     forc(level, jc) += tke_Tiwf(blockNo, level, jc);
@@ -437,7 +844,6 @@ void calc_forcing(int blockNo, int start_index, int end_index, int max_levels, b
     }
 }
 
-inline
 void build_diffusion_dissipation_tridiag(int blockNo, int start_index, int end_index, int max_levels,
                                          mdspan_2d_int dolic_c, double alpha_tke,
                                          mdspan_3d_double tke_Av, mdspan_2d_double dzt_stretched,
@@ -480,7 +886,6 @@ void build_diffusion_dissipation_tridiag(int blockNo, int start_index, int end_i
             a_dif(0, jc) = 0.0;
 }
 
-inline
 void build_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
                    double dtime, double c_eps, int nlevs,
                    mdspan_2d_double a_dif, mdspan_2d_double b_dif, mdspan_2d_double c_dif,
@@ -508,41 +913,132 @@ void build_tridiag(int blockNo, int start_index, int end_index, int max_levels,
                 d_tri(level, jc) = tke_upd(level, jc) + dtime * forc(level, jc);
 }
 
-inline
-void solve_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
-                   mdspan_2d_double a, mdspan_2d_double b, mdspan_2d_double c, mdspan_2d_double d,
-                   mdspan_3d_double x, mdspan_2d_double cp, mdspan_2d_double dp) {
-    // initialize a-prime (cp) and d-prime
+void factor_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
+                    mdspan_2d_double a, mdspan_2d_double b, mdspan_2d_double c,
+                    mdspan_2d_double cp, mdspan_2d_double inv_pivot) {
+    // first row
     for (int jc = start_index; jc <= end_index; jc++) {
-        if (dolic_c(blockNo, jc)+1 > 0) {
-            int dolic = dolic_c(blockNo, jc);
-            cp(dolic, jc) = c(dolic, jc) / b(dolic, jc);
-            dp(dolic, jc) = d(dolic, jc) / b(dolic, jc);
+        if (dolic_c(blockNo, jc) >= 0) {
+            inv_pivot(0, jc) = 1.0 / b(0, jc);
+            cp(0, jc) = c(0, jc) * inv_pivot(0, jc);
         }
     }
 
-    // solve for vectors a-prime and d-prime
-    for (int level = max_levels-1; level >= 0; level--) {
+    // forward elimination of the lower diagonal, level by level over all the columns
+    for (int level = 1; level < max_levels+1; level++) {
         for (int jc = start_index; jc <= end_index; jc++) {
             if (level <= dolic_c(blockNo, jc)) {
-                double fxa = 1.0 / (b(level, jc) - cp(level+1, jc) * c(level, jc));
+                double fxa = 1.0 / (b(level, jc) - cp(level-1, jc) * a(level, jc));
+                inv_pivot(level, jc) = fxa;
+                cp(level, jc) = c(level, jc) * fxa;
             }
         }
     }
+}
 
-    // initialize x
+void sweep_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
+                   mdspan_2d_double a, mdspan_2d_double d, mdspan_2d_double cp, mdspan_2d_double inv_pivot,
+                   mdspan_3d_double x) {
+    // forward sweep of the right-hand side (d-prime), stored in x
     for (int jc = start_index; jc <= end_index; jc++)
-        if (dolic_c(blockNo, jc)+1 > 0)
-            x(blockNo, 0, jc) = dp(0, jc);
+        if (dolic_c(blockNo, jc) >= 0)
+            x(blockNo, 0, jc) = d(0, jc) * inv_pivot(0, jc);
 
-    // solve for x from the vectors a-prime and d-prime
     for (int level = 1; level < max_levels+1; level++)
         for (int jc = start_index; jc <= end_index; jc++)
             if (level <= dolic_c(blockNo, jc))
-                x(blockNo, level, jc) = dp(level, jc) - cp(level, jc) * x(blockNo, level-1, jc);
+                x(blockNo, level, jc) = (d(level, jc) - x(blockNo, level-1, jc) * a(level, jc)) *
+                                        inv_pivot(level, jc);
+
+    // back substitution from the bottom level of each column
+    for (int level = max_levels-1; level >= 0; level--)
+        for (int jc = start_index; jc <= end_index; jc++)
+            if (level < dolic_c(blockNo, jc))
+                x(blockNo, level, jc) = x(blockNo, level, jc) - cp(level, jc) * x(blockNo, level+1, jc);
+}
+
+void solve_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
+                   mdspan_2d_double a, mdspan_2d_double b, mdspan_2d_double c, mdspan_2d_double d,
+                   mdspan_3d_double x, mdspan_2d_double cp, mdspan_2d_double dp) {
+    // dp holds the reciprocal pivots, the right-hand side is swept directly in x
+    factor_tridiag(blockNo, start_index, end_index, max_levels, dolic_c, a, b, c, cp, dp);
+    sweep_tridiag(blockNo, start_index, end_index, max_levels, dolic_c, a, d, cp, dp, x);
+}
+
+void solve_tridiag_pcr(int blockNo, int start_index, int end_index, mdspan_2d_int dolic_c,
+                       mdspan_2d_double a, mdspan_2d_double b, mdspan_2d_double c, mdspan_2d_double d,
+                       mdspan_3d_double x) {
+    // The reduction steps with stride 1, 2 and 4 split each column in 8 independent interleaved
+    // systems (rows coupled with stride 8), which are then solved together by a Thomas recurrence
+    // with stride 8: the dependency chain is 8 times shorter and the loops along the vertical are
+    // vectorised. The columns are copied to contiguous buffers with 8 identity rows (a = c = d = 0,
+    // b = 1) on both sides, so that the loops have no branches.
+    constexpr int width = 8;
+    int nrows = static_cast<int>(a.extent(0));
+    int size = nrows + 2 * width;
+    thread_local std::vector<double> buffer;
+    buffer.resize(8 * static_cast<size_t>(size));
+    double *diagonals[8];
+    for (int k = 0; k < 8; k++) {
+        diagonals[k] = buffer.data() + k * size + width;
+        double identity = (k % 4 == 1) ? 1.0 : 0.0;
+        for (int i = -width; i < 0; i++)
+            diagonals[k][i] = identity;
+    }
+
+    for (int jc = start_index; jc <= end_index; jc++) {
+        int n = dolic_c(blockNo, jc) + 1;
+        if (n <= 0)
+            continue;
+        for (int k = 0; k < 8; k++) {
+            double identity = (k % 4 == 1) ? 1.0 : 0.0;
+            for (int i = n; i < n + width; i++)
+                diagonals[k][i] = identity;
+        }
+        double *a1 = diagonals[0], *b1 = diagonals[1], *c1 = diagonals[2], *d1 = diagonals[3];
+        double *a2 = diagonals[4], *b2 = diagonals[5], *c2 = diagonals[6], *d2 = diagonals[7];
+        for (int i = 0; i < n; i++) {
+            a1[i] = a(i, jc);
+            b1[i] = b(i, jc);
+            c1[i] = c(i, jc);
+            d1[i] = d(i, jc);
+        }
+        // the coupling of the first and of the bottom level to the outside of the column
+        a1[0] = 0.0;
+        c1[n-1] = 0.0;
+
+        // cyclic reduction steps, b2 holds the reciprocal of the main diagonal
+        for (int stride = 1; stride < width && stride < n; stride *= 2) {
+            for (int i = 0; i < n; i++)
+                b2[i] = 1.0 / b1[i];
+            for (int i = 0; i < n; i++) {
+                double alpha = -a1[i] * b2[i-stride];
+                double gamma = -c1[i] * b2[i+stride];
+                a2[i] = alpha * a1[i-stride];
+                c2[i] = gamma * c1[i+stride];
+                d2[i] = d1[i] + alpha * d1[i-stride] + gamma * d1[i+stride];
+                b1[i] = b1[i] + alpha * c1[i-stride] + gamma * a1[i+stride];
+            }
+            std::swap(a1, a2);
+            std::swap(c1, c2);
+            std::swap(d1, d2);
+        }
+
+        // Thomas recurrence of the interleaved systems, c-prime in c2 and d-prime in d2
+        // (their padding rows are zero)
+        for (int i = 0; i < n; i++) {
+            double fxa = 1.0 / (b1[i] - c2[i-width] * a1[i]);
+            c2[i] = c1[i] * fxa;
+            d2[i] = (d1[i] - d2[i-width] * a1[i]) * fxa;
+        }
+        for (int i = n-1; i >= 0; i--)
+            d2[i] = d2[i] - c2[i] * d2[i+width];
+
+        for (int i = 0; i < n; i++)
+            x(blockNo, i, jc) = d2[i];
+    }
 }
 
-inline
 void tke_vertical_diffusion(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
                             double diff_surf_forc, double diff_bott_forc,
                             mdspan_2d_double a_dif, mdspan_2d_double b_dif, mdspan_2d_double c_dif,
@@ -567,7 +1063,6 @@ void tke_vertical_diffusion(int blockNo, int start_index, int end_index, int max
     }
 }
 
-inline
 void tke_vertical_diffusion_ub_dirichlet(int blockNo, int start_index, int end_index, mdspan_2d_int dolic_c,
                                          double tke_surf, mdspan_2d_double ke, mdspan_2d_double dzw_stretched,
                                          mdspan_2d_double dzt_stretched, mdspan_3d_double tke,
@@ -578,7 +1073,6 @@ void tke_vertical_diffusion_ub_dirichlet(int blockNo, int start_index, int end_i
                                        (tke_surf - tke(blockNo, 1, jc));
 }
 
-inline
 void tke_vertical_diffusion_lb_dirichlet(int blockNo, int start_index, int end_index, mdspan_2d_int dolic_c,
                                          double tke_bott, mdspan_2d_double ke, mdspan_2d_double dzw_stretched,
                                          mdspan_2d_double dzt_stretched, mdspan_3d_double tke,
@@ -592,7 +1086,6 @@ void tke_vertical_diffusion_lb_dirichlet(int blockNo, int start_index, int end_i
     }
 }
 
-inline
 void tke_vertical_dissipation(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
                               int nlevs, double c_eps, mdspan_3d_double tke_Lmix, mdspan_2d_double sqrttke,
                               mdspan_3d_double tke, mdspan_3d_double tke_Tdis) {
@@ -611,7 +1104,9 @@ void calc_impl_edges(int blockNo, int start_index, int end_index,
                      t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
                      t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
                      t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
-                     t_constant p_constant) {
+                     t_constant p_constant,
+                     [[maybe_unused]] t_thread_timers *timers) {
+    YAOP_TIMER_START(timer_edges, timers);
     // compute max level on block (maxval fortran function)
     int max_levels = 0;
     for (int je = start_index; je <= end_index; je++)
@@ -632,4 +1127,113 @@ void calc_impl_edges(int blockNo, int start_index, int end_index,
                 p_cvmix.a_veloc_v(blockNo, level, je) = 0.0;
         }
     }
+    YAOP_TIMER_STOP(timer_edges, timers, timing_edges);
+}
+
+void init_edge_gather(t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                      t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> p_gather,
+                      t_constant p_constant) {
+    int nblocks = p_constant.nblocks;
+    int nproma = p_constant.nproma;
+    int block_size = (p_constant.nlevs+1) * nproma;
+
+    // offset of the surface interface of the neighbour columns in the cell fields, the neighbours of the
+    // edges outside of the domain can be undefined and they are never read
+    for (int i = 0; i <= nblocks; i++)
+        p_gather.fused_start(i) = 0;
+    for (int jb = 0; jb < nblocks; jb++) {
+        for (int je = 0; je < nproma; je++) {
+            bool is_valid = true;
+            for (int side = 0; side < 2; side++) {
+                int cell_idx = p_patch.edges_cell_idx(side, jb, je);
+                int cell_blk = p_patch.edges_cell_blk(side, jb, je);
+                bool is_valid_side = cell_idx >= 0 && cell_idx < nproma && cell_blk >= 0 && cell_blk < nblocks;
+                p_gather.cell_offset(side, jb, je) = is_valid_side ? cell_blk * block_size + cell_idx : 0;
+                is_valid = is_valid && is_valid_side;
+            }
+            int cell_blk = p_patch.edges_cell_blk(0, jb, je);
+            if (is_valid && cell_blk == p_patch.edges_cell_blk(1, jb, je)) {
+                p_gather.fused_block(jb, je) = cell_blk;
+                p_gather.fused_start(cell_blk+1)++;
+            } else {
+                p_gather.fused_block(jb, je) = -1;
+            }
+        }
+    }
+
+    // the fused edges sorted by cell block, fused_start is used as insertion point and then shifted back
+    for (int i = 0; i < nblocks; i++)
+        p_gather.fused_start(i+1) += p_gather.fused_start(i);
+    for (int jb = 0; jb < nblocks; jb++)
+        for (int je = 0; je < nproma; je++)
+            if (p_gather.fused_block(jb, je) >= 0)
+                p_gather.fused_edges(p_gather.fused_start(p_gather.fused_block(jb, je))++) = jb * nproma + je;
+    for (int i = nblocks; i > 0; i--)
+        p_gather.fused_start(i) = p_gather.fused_start(i-1);
+    p_gather.fused_start(0) = 0;
+}
+
+void calc_impl_edges_gather(int blockNo, int start_index, int end_index,
+                            int fused_start_block, int fused_end_block,
+                            t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                            t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+                            t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                            t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> p_gather,
+                            t_constant p_constant,
+                            [[maybe_unused]] t_thread_timers *timers) {
+    YAOP_TIMER_START(timer_edges, timers);
+    const double *tke_Av = p_internal.tke_Av.data_handle();
+    int nproma = p_constant.nproma;
+
+    // level by level, the offsets of the neighbour columns are read from the gather table instead of the
+    // cell indices and blocks. The edges of the cell blocks from fused_start_block to fused_end_block have
+    // been computed with the cells
+    for (int level = 1; level < p_constant.nlevs+1; level++) {
+        int level_offset = level * nproma;
+        for (int je = start_index; je <= end_index; je++) {
+            int fused_block = p_gather.fused_block(blockNo, je);
+            if (fused_block >= fused_start_block && fused_block <= fused_end_block)
+                continue;
+            int offset_1 = p_gather.cell_offset(0, blockNo, je) + level_offset;
+            int offset_2 = p_gather.cell_offset(1, blockNo, je) + level_offset;
+            if (level < p_patch.dolic_e(blockNo, je))
+                p_cvmix.a_veloc_v(blockNo, level, je) = 0.5 * (tke_Av[offset_1] + tke_Av[offset_2]);
+            else
+                p_cvmix.a_veloc_v(blockNo, level, je) = 0.0;
+        }
+    }
+    YAOP_TIMER_STOP(timer_edges, timers, timing_edges);
+}
+
+void calc_fused_edges(int cellBlockNo, const t_index_range &edges_range,
+                      t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                      t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+                      t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                      t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> p_gather,
+                      t_constant p_constant,
+                      [[maybe_unused]] t_thread_timers *timers) {
+    YAOP_TIMER_START(timer_edges, timers);
+    const double *tke_Av = p_internal.tke_Av.data_handle();
+    int nproma = p_constant.nproma;
+    int first_edge = edges_range.edges_start_block * nproma + edges_range.edges_start_index;
+    int last_edge = edges_range.edges_end_block * nproma + edges_range.edges_end_index;
+
+    // only the edges of the edges range are written, up to edges_block_size in the blocks before the
+    // last one as in get_index_range. The columns of the cell block are still in cache, so each edge
+    // reads its two neighbour columns level by level
+    for (int i = p_gather.fused_start(cellBlockNo); i < p_gather.fused_start(cellBlockNo+1); i++) {
+        int edge = p_gather.fused_edges(i);
+        int edge_blk = edge / nproma;
+        int je = edge % nproma;
+        if (edge < first_edge || edge > last_edge ||
+            (je >= edges_range.edges_block_size && edge_blk != edges_range.edges_end_block))
+            continue;
+        const double *tke_Av_1 = tke_Av + p_gather.cell_offset(0, edge_blk, je);
+        const double *tke_Av_2 = tke_Av + p_gather.cell_offset(1, edge_blk, je);
+        int dolic_e = p_patch.dolic_e(edge_blk, je);
+        for (int level = 1; level < p_constant.nlevs+1; level++)
+            p_cvmix.a_veloc_v(edge_blk, level, je) = level < dolic_e ?
+                0.5 * (tke_Av_1[level * nproma] + tke_Av_2[level * nproma]) : 0.0;
+    }
+    YAOP_TIMER_STOP(timer_edges, timers, timing_edges);
 }
@@ -21,6 +21,7 @@
 #include <cmath>
 #include "src/backends/CPU/cpu_memory.hpp"
 #include "src/shared/interface/memview_struct.hpp"
+#include "src/shared/timing.hpp"
 
 using std::max;
 using std::min;
@@ -33,40 +34,145 @@ void calc_impl_cells(int blockNo, int start_index, int end_index,
                      t_atmos_for_ocean_view<cpu_memview::mdspan, cpu_memview::dextents> p_as,
                      t_sea_ice_view<cpu_memview::mdspan, cpu_memview::dextents> p_sea_ice,
                      t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                     t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                     t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability,
+                     t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence,
+                     bool is_stability_cached,
                      t_constant p_constant,
-                     t_constant_tke p_constant_tke);
+                     t_constant_tke p_constant_tke,
+                     t_thread_timers *timers = nullptr);
+
+bool update_quiescence(int blockNo, int start_index, int end_index,
+                       t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                       t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                       t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence,
+                       t_constant p_constant,
+                       t_constant_tke p_constant_tke);
+
+double tke_tendency_bound(int blockNo, int jc,
+                          t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                          t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                          t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence,
+                          t_constant_tke p_constant_tke);
+
+void record_activity(int blockNo, int start_index, int end_index,
+                     t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                     t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+                     t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence);
+
+void calc_vertical_stability(int blockNo, int start_index, int end_index,
+                             t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                             t_ocean_state_view<cpu_memview::mdspan, cpu_memview::dextents> ocean_state,
+                             t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                             t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability,
+                             t_constant p_constant);
+
+void calc_pp_cells(int blockNo, int start_index, int end_index,
+                   t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                   t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+                   t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability,
+                   mdspan_3d_double pp_Av,
+                   t_constant p_constant,
+                   t_constant_pp p_constant_pp);
+
+void calc_idemix_vertical(int blockNo, int start_index, int end_index,
+                          t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                          t_idemix_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix,
+                          t_horizontal_grid_view<cpu_memview::mdspan, cpu_memview::dextents> p_grid,
+                          t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                          t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability,
+                          t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix_internal,
+                          t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                          t_constant p_constant,
+                          t_constant_idemix p_constant_idemix);
+
+void calc_idemix_edges(int blockNo, int start_index, int end_index,
+                       t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                       t_idemix_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix,
+                       t_horizontal_grid_view<cpu_memview::mdspan, cpu_memview::dextents> p_grid,
+                       t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix_internal,
+                       t_constant p_constant,
+                       t_constant_idemix p_constant_idemix);
+
+void calc_idemix_horizontal(int blockNo, int start_index, int end_index,
+                            t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                            t_idemix_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix,
+                            t_horizontal_grid_view<cpu_memview::mdspan, cpu_memview::dextents> p_grid,
+                            t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix_internal,
+                            t_constant p_constant);
+
+void init_geometry_cache(t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                         t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                         t_constant p_constant);
+
+void update_geometry_cache(int blockNo, int start_index, int end_index,
+                           t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                           t_ocean_state_view<cpu_memview::mdspan, cpu_memview::dextents> ocean_state,
+                           t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry,
+                           t_constant p_constant);
 
 void calc_impl_edges(int blockNo, int start_index, int end_index,
                      t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
                      t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
                      t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
-                     t_constant p_constant);
-
-void integrate(int blockNo, int start_index, int end_index,
+                     t_constant p_constant,
+                     t_thread_timers *timers = nullptr);
+
+void init_edge_gather(t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                      t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> p_gather,
+                      t_constant p_constant);
+
+void calc_impl_edges_gather(int blockNo, int start_index, int end_index,
+                            int fused_start_block, int fused_end_block,
+                            t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                            t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+                            t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                            t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> p_gather,
+                            t_constant p_constant,
+                            t_thread_timers *timers = nullptr);
+
+void calc_fused_edges(int cellBlockNo, const t_index_range &edges_range,
+                      t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
+                      t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
+                      t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
+                      t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> p_gather,
+                      t_constant p_constant,
+                      t_thread_timers *timers = nullptr);
+
+void integrate(int blockNo, int start_index, int end_index, int max_levels,
                t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch,
                t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix,
                t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal,
                t_constant p_constant,
-               t_constant_tke p_constant_tke);
+               t_constant_tke p_constant_tke,
+               bool is_diagnostics,
+               t_thread_timers *timers = nullptr);
 
-inline
 void calc_mxl_2(int blockNo, int start_index, int end_index, int max_levels, double mxl_min,
                 mdspan_2d_int dolic_c, mdspan_3d_double tke_Lmix, mdspan_2d_double dzw_stretched);
 
-inline
+void calc_mxl_3(int blockNo, int start_index, int end_index, int max_levels, double mxl_min,
+                mdspan_2d_int dolic_c, mdspan_3d_double tke_Lmix, mdspan_3d_double depth_CellInterface);
+
 void calc_diffusivity(int blockNo, int start_index, int end_index, int max_levels,
                       t_constant_tke *p_constant_tke,
                       mdspan_2d_int dolic_c, mdspan_3d_double tke_Lmix, mdspan_2d_double sqrttke,
                       mdspan_2d_double Nsqr, mdspan_2d_double Ssqr,
                       mdspan_3d_double tke_Av, mdspan_2d_double tke_kv, mdspan_3d_double tke_Pr);
 
-inline
+void calc_langmuir_depth(int blockNo, int start_index, int end_index, int max_levels, double c_stokes,
+                         mdspan_2d_int dolic_c, mdspan_3d_double depth_CellInterface, mdspan_2d_double dzt_stretched,
+                         mdspan_2d_double Nsqr, mdspan_2d_double fu10, mdspan_2d_double concsum,
+                         mdspan_2d_double u_stokes, mdspan_2d_double hlc, mdspan_1d_double pot_energy);
+
 void calc_forcing(int blockNo, int start_index, int end_index, int max_levels, bool l_lc, bool only_tke,
+                  double clc, double pi,
                   mdspan_2d_int dolic_c, mdspan_2d_double Ssqr, mdspan_2d_double Nsqr, mdspan_3d_double tke_Av,
                   mdspan_2d_double tke_kv, mdspan_3d_double tke_Tspr, mdspan_3d_double tke_Tbpr,
-                  mdspan_3d_double tke_plc, mdspan_3d_double tke_Tiwf, mdspan_2d_double forc);
+                  mdspan_3d_double depth_CellInterface, mdspan_2d_double hlc, mdspan_2d_double u_stokes,
+                  mdspan_3d_double wlc, mdspan_3d_double tke_plc, mdspan_3d_double tke_Tiwf,
+                  mdspan_2d_double forc);
 
-inline
 void build_diffusion_dissipation_tridiag(int blockNo, int start_index, int end_index, int max_levels,
                                          mdspan_2d_int dolic_c, double alpha_tke,
                                          mdspan_3d_double tke_Av, mdspan_2d_double dzt_stretched,
@@ -74,7 +180,6 @@ void build_diffusion_dissipation_tridiag(int blockNo, int start_index, int end_i
                                          mdspan_2d_double ke, mdspan_2d_double a_dif, mdspan_2d_double b_dif,
                                          mdspan_2d_double c_dif);
 
-inline
 void build_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
                    double dtime, double c_eps, int nlevs,
                    mdspan_2d_double a_dif, mdspan_2d_double b_dif, mdspan_2d_double c_dif,
@@ -83,30 +188,40 @@ void build_tridiag(int blockNo, int start_index, int end_index, int max_levels,
                    mdspan_2d_double a_tri, mdspan_2d_double b_tri, mdspan_2d_double c_tri,
                    mdspan_2d_double d_tri);
 
-inline
+// Thomas algorithm split in factorisation and sweep: when the matrix of a block does not change,
+// its factors (cp and inv_pivot) can be kept and only sweep_tridiag called for a new right-hand side
+void factor_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
+                    mdspan_2d_double a, mdspan_2d_double b, mdspan_2d_double c,
+                    mdspan_2d_double cp, mdspan_2d_double inv_pivot);
+
+void sweep_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
+                   mdspan_2d_double a, mdspan_2d_double d, mdspan_2d_double cp, mdspan_2d_double inv_pivot,
+                   mdspan_3d_double x);
+
 void solve_tridiag(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
                    mdspan_2d_double a, mdspan_2d_double b, mdspan_2d_double c, mdspan_2d_double d,
                    mdspan_3d_double x, mdspan_2d_double cp, mdspan_2d_double dp);
 
-inline
+// Parallel cyclic reduction, each column is solved in log2(dolic+1) steps vectorised along the vertical
+void solve_tridiag_pcr(int blockNo, int start_index, int end_index, mdspan_2d_int dolic_c,
+                       mdspan_2d_double a, mdspan_2d_double b, mdspan_2d_double c, mdspan_2d_double d,
+                       mdspan_3d_double x);
+
 void tke_vertical_diffusion(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
                             double diff_surf_forc, double diff_bott_forc,
                             mdspan_2d_double a_dif, mdspan_2d_double b_dif, mdspan_2d_double c_dif,
                             mdspan_3d_double tke, mdspan_3d_double tke_Tdif);
 
-inline
 void tke_vertical_diffusion_ub_dirichlet(int blockNo, int start_index, int end_index, mdspan_2d_int dolic_c,
                                          double tke_surf, mdspan_2d_double ke, mdspan_2d_double dzw_stretched,
                                          mdspan_2d_double dzt_stretched, mdspan_3d_double tke,
                                          mdspan_3d_double tke_Tdif);
 
-inline
 void tke_vertical_diffusion_lb_dirichlet(int blockNo, int start_index, int end_index, mdspan_2d_int dolic_c,
                                          double tke_bott, mdspan_2d_double ke, mdspan_2d_double dzw_stretched,
                                          mdspan_2d_double dzt_stretched, mdspan_3d_double tke,
                                          mdspan_3d_double tke_Tdif);
 
-inline
 void tke_vertical_dissipation(int blockNo, int start_index, int end_index, int max_levels, mdspan_2d_int dolic_c,
                               int nlevs, double c_eps, mdspan_3d_double tke_Lmix, mdspan_2d_double sqrttke,
                               mdspan_3d_double tke, mdspan_3d_double tke_Tdis);
@@ -20,26 +20,28 @@
 #include "src/shared/utils.hpp"
 #include "src/backends/GPU/gpu_kernels.hpp"
 
-// Structures with memory views
-static struct t_cvmix_view<gpu_memview::mdspan, gpu_memview::dextents> p_cvmix_view;
-static struct t_patch_view<gpu_memview::mdspan, gpu_memview::dextents> p_patch_view;
-static struct t_ocean_state_view<gpu_memview::mdspan, gpu_memview::dextents> ocean_state_view;
-static struct t_atmo_fluxes_view<gpu_memview::mdspan, gpu_memview::dextents> atmos_fluxes_view;
-static struct t_atmos_for_ocean_view<gpu_memview::mdspan, gpu_memview::dextents> p_as_view;
-static struct t_sea_ice_view<gpu_memview::mdspan, gpu_memview::dextents> p_sea_ice_view;
-static struct t_tke_internal_view<gpu_memview::mdspan, gpu_memview::dextents> p_internal_view;
+// Structures with memory views of this instance
+struct TKE_gpu::Impl {
+    struct t_cvmix_view<gpu_memview::mdspan, gpu_memview::dextents> p_cvmix_view;
+    struct t_patch_view<gpu_memview::mdspan, gpu_memview::dextents> p_patch_view;
+    struct t_ocean_state_view<gpu_memview::mdspan, gpu_memview::dextents> ocean_state_view;
+    struct t_atmo_fluxes_view<gpu_memview::mdspan, gpu_memview::dextents> atmos_fluxes_view;
+    struct t_atmos_for_ocean_view<gpu_memview::mdspan, gpu_memview::dextents> p_as_view;
+    struct t_sea_ice_view<gpu_memview::mdspan, gpu_memview::dextents> p_sea_ice_view;
+    struct t_tke_internal_view<gpu_memview::mdspan, gpu_memview::dextents> p_internal_view;
+};
 
 TKE_gpu::TKE_gpu(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemix_tke,
                    int vert_cor_type, double dtime, double OceanReferenceDensity, double grav,
                    int l_lc, double clc, double ReferencePressureIndbars, double pi)
     : TKE_backend(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke,
                   vert_cor_type, dtime, OceanReferenceDensity, grav,
-                  l_lc, clc, ReferencePressureIndbars, pi) {
+                  l_lc, clc, ReferencePressureIndbars, pi), m_impl(new Impl) {
     // Allocate internal arrays memory and create memory views
     std::cout << "Initializing TKE (GPU)... " << std::endl;
 
     this->internal_fields_malloc<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
-                                (&p_internal_view);
+                                (&m_impl->p_internal_view);
 }
 
 TKE_gpu::~TKE_gpu() {
@@ -47,6 +49,7 @@ TKE_gpu::~TKE_gpu() {
     std::cout << "Finalizing TKE (GPU)... " << std::endl;
 
     this->internal_fields_free<gpu_memview_policy>();
+    delete m_impl;
 }
 
 void TKE_gpu::calc_impl(t_patch p_patch, t_cvmix p_cvmix,
@@ -56,24 +59,27 @@ void TKE_gpu::calc_impl(t_patch p_patch, t_cvmix p_cvmix,
                          int edges_start_index, int edges_end_index, int cells_block_size,
                          int cells_start_block, int cells_end_block, int cells_start_index,
                          int cells_end_index) {
-    // The pointer to the data should not change inside the time loop
-    // structs view are filled only at the first time step
+    // structs view are filled at the first time step and every time the bound pointers change
+    YAOP_TIMER_START(timer_view_init, &m_thread_timers[0]);
     if (!m_is_view_init) {
-        this->fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
-                                 (&p_cvmix_view, &p_cvmix, p_constant.nblocks, p_constant.nlevs, p_constant.nproma);
-        this->fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
-                                 (&p_patch_view, &p_patch, p_constant.nblocks, p_constant.nlevs, p_constant.nproma);
-        this->fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
-                                 (&ocean_state_view, &ocean_state, p_constant.nblocks, p_constant.nlevs,
-                                  p_constant.nproma);
-        this->fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
-                                 (&atmos_fluxes_view, &atmos_fluxes, p_constant.nblocks, p_constant.nproma);
-        this->fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
-                                 (&p_as_view, &p_as, p_constant.nblocks, p_constant.nproma);
-        this->fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
-                                 (&p_sea_ice_view, &p_sea_ice, p_constant.nblocks, p_constant.nproma);
+        fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
+                           (&m_impl->p_cvmix_view, &p_cvmix, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
+                           (&m_impl->p_patch_view, &p_patch, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
+                           (&m_impl->ocean_state_view, &ocean_state, p_constant.nblocks, p_constant.nlevs,
+                            p_constant.nproma);
+        fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
+                           (&m_impl->atmos_fluxes_view, &atmos_fluxes, p_constant.nblocks, p_constant.nproma);
+        fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
+                           (&m_impl->p_as_view, &p_as, p_constant.nblocks, p_constant.nproma);
+        fill_struct_memview<gpu_memview::mdspan, gpu_memview::dextents, gpu_memview_policy>
+                           (&m_impl->p_sea_ice_view, &p_sea_ice, p_constant.nblocks, p_constant.nproma);
         m_is_view_init = true;
     }
+    YAOP_TIMER_STOP(timer_view_init, &m_thread_timers[0], timing_view_init);
 
     // over cells
     for (int jb = cells_start_block; jb <= cells_end_block; jb++) {
@@ -83,10 +89,10 @@ void TKE_gpu::calc_impl(t_patch p_patch, t_cvmix p_cvmix,
         int threadsPerBlockI = 512;  // too many registers used for 1024
         int blocksPerGridI = (end_index - start_index) / threadsPerBlockI + 1;
         void *args[] = {&jb, &start_index, &end_index,
-                        &p_patch_view, &p_cvmix_view,
-                        &ocean_state_view, &atmos_fluxes_view,
-                        &p_as_view, &p_sea_ice_view,
-                        &p_internal_view, &p_constant,
+                        &m_impl->p_patch_view, &m_impl->p_cvmix_view,
+                        &m_impl->ocean_state_view, &m_impl->atmos_fluxes_view,
+                        &m_impl->p_as_view, &m_impl->p_sea_ice_view,
+                        &m_impl->p_internal_view, &p_constant,
                         &p_constant_tke};
         this->launch_kernel<gpu_launch_policy>(threadsPerBlockI, blocksPerGridI,
                                               reinterpret_cast<void *>(calc_impl_cells), args);
@@ -100,8 +106,8 @@ void TKE_gpu::calc_impl(t_patch p_patch, t_cvmix p_cvmix,
         int threadsPerBlockI = 1024;
         int blocksPerGridI = (end_index - start_index) / threadsPerBlockI + 1;
         void *args[] = {&jb, &start_index, &end_index,
-                        &p_patch_view, &p_cvmix_view,
-                        &p_internal_view, &p_constant};
+                        &m_impl->p_patch_view, &m_impl->p_cvmix_view,
+                        &m_impl->p_internal_view, &p_constant};
         this->launch_kernel<gpu_launch_policy>(threadsPerBlockI, blocksPerGridI,
                                               reinterpret_cast<void *>(calc_impl_edges), args);
     }
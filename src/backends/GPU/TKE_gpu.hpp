@@ -42,7 +42,7 @@ class TKE_gpu : public TKE_backend {
  protected:
     /*! \brief GPU implementation of TKE.
     *
-    *   It fills the memory view structures during the first call and then compute the
+    *   It fills the memory view structures when the bound pointers change and then compute the
     *   turbulent kinetic energy vertical scheme.
     */
     void calc_impl(struct t_patch p_patch, struct t_cvmix p_cvmix,
@@ -61,6 +61,10 @@ class TKE_gpu : public TKE_backend {
     void launch_kernel(int threadsPerBlock, int blocksPerGrid, void* func, void **args) {
         launch_policy::launch(threadsPerBlock, blocksPerGrid, func, args);
     }
+
+ private:
+    struct Impl;
+    Impl *m_impl;
 };
 
 #endif  // SRC_BACKENDS_GPU_TKE_GPU_HPP_
@@ -94,8 +94,33 @@ void calc_impl_cells(int blockNo, int start_index, int end_index,
                 p_internal.Ssqr(level, jc) = 0.0;
             }
 
-            // integration
-            integrate(jc, blockNo, p_patch, p_cvmix, p_internal, p_constant, p_constant_tke);
+            // Stokes drift and depth of the Langmuir cells, first interface where the potential energy
+            // of the stratification above exceeds the kinetic energy of the Stokes drift (Axell 2002)
+            if (p_constant.l_lc) {
+                double u_stokes = p_constant_tke.c_stokes * p_as.fu10(blockNo, jc) *
+                                  (1.0 - p_sea_ice.concsum(blockNo, jc));
+                double hlc = p_patch.depth_CellInterface(blockNo, levels, jc);
+                double pot_energy = 0.0;
+                for (int level = 1; level < levels+1; level++) {
+                    pot_energy += max(0.0, p_internal.Nsqr(level, jc)) *
+                                  p_patch.depth_CellInterface(blockNo, level, jc) * p_internal.dzt_stretched(level, jc);
+                    if (pot_energy >= 0.5 * u_stokes * u_stokes) {
+                        hlc = p_patch.depth_CellInterface(blockNo, level, jc);
+                        break;
+                    }
+                }
+                p_cvmix.u_stokes(blockNo, jc) = u_stokes;
+                p_cvmix.hlc(blockNo, jc) = hlc;
+            }
+
+            // integration, the substeps share the geometry, the vertical stability and the surface forcing
+            for (int substep = 0; substep < p_constant_tke.nsubsteps; substep++) {
+                if (substep > 0) {
+                    for (int level = 0; level < p_constant.nlevs+1; level++)
+                        p_internal.tke_old(level, jc) = p_cvmix.tke(blockNo, level, jc);
+                }
+                integrate(jc, blockNo, p_patch, p_cvmix, p_internal, p_constant, p_constant_tke);
+            }
 
             //  write tke vert. diffusivity to vert tracer diffusivities
             for (int level = 0; level < p_constant.nlevs+1; level++) {
@@ -140,9 +165,16 @@ void integrate(int jc, int blockNo,
         for (int level = 0; level < nlevels+1; level++)
             p_cvmix.tke_Lmix(blockNo, level, jc) = max(p_cvmix.tke_Lmix(blockNo, level, jc), p_constant_tke.mxl_min);
     } else if (p_constant_tke.tke_mxl_choice == 3) {
-        // TODO(EnricoDeg): not default
-    } else {
-        // Error
+        // as cvmix_tke (CVMix-src, src/shared/cvmix_tke.F90): the inner interfaces are bounded by the
+        // distance to the surface and to the bottom
+        double depth_bottom = p_patch.depth_CellInterface(blockNo, dolic, jc);
+        for (int level = 1; level < dolic; level++) {
+            double depth = p_patch.depth_CellInterface(blockNo, level, jc);
+            p_cvmix.tke_Lmix(blockNo, level, jc) = min(p_cvmix.tke_Lmix(blockNo, level, jc),
+                                                   min(fabs(depth), fabs(depth - depth_bottom)));
+        }
+        for (int level = 0; level < nlevels+1; level++)
+            p_cvmix.tke_Lmix(blockNo, level, jc) = max(p_cvmix.tke_Lmix(blockNo, level, jc), p_constant_tke.mxl_min);
     }
 
     // calculate diffusivities
@@ -172,9 +204,20 @@ void integrate(int jc, int blockNo,
         if (level == 0) p_cvmix.tke_Tbpr(blockNo, 0, jc) = 0.0;
 
         p_internal.forc(level, jc) = p_cvmix.tke_Tspr(blockNo, level, jc) - p_cvmix.tke_Tbpr(blockNo, level, jc);
-        // additional langmuir turbulence term
-        if (p_constant.l_lc)
-            p_internal.forc(level, jc) += p_cvmix.tke_plc(blockNo, level, jc);
+        // additional langmuir turbulence term, from the vertical velocity of the cells above hlc
+        if (p_constant.l_lc) {
+            double depth = p_patch.depth_CellInterface(blockNo, level, jc);
+            double hlc = p_cvmix.hlc(blockNo, jc);
+            double wlc = 0.0;
+            double plc = 0.0;
+            if (depth < hlc) {
+                wlc = p_constant.clc * p_cvmix.u_stokes(blockNo, jc) * sin(p_constant.pi * depth / hlc);
+                plc = wlc * wlc * wlc / hlc;
+            }
+            p_cvmix.wlc(blockNo, level, jc) = wlc;
+            p_cvmix.tke_plc(blockNo, level, jc) = plc;
+            p_internal.forc(level, jc) += plc;
+        }
         // forcing by internal wave dissipation
         if (!p_constant_tke.only_tke)
             p_internal.forc(level, jc) += p_cvmix.tke_Tiwf(blockNo, level, jc);
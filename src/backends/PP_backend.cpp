@@ -0,0 +1,44 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/backends/PP_backend.hpp"
+#include <cstring>
+
+PP_backend::PP_backend(int nproma, int nlevs, int nblocks) {
+    // only the grid sizes of the constants are used by the scheme
+    std::memset(&p_constant, 0, sizeof(p_constant));
+    p_constant.nproma = nproma;
+    p_constant.nblocks = nblocks;
+    p_constant.nlevs = nlevs;
+
+    // Internal parameters are set for now to the ICON default values
+    p_constant_pp.richardson_factor_veloc = 0.5e-2;
+    p_constant_pp.richardson_factor_tracer = 0.5e-2;
+    p_constant_pp.c1_pp = 5.0;
+    p_constant_pp.velocity_background = 1.0e-4;
+    p_constant_pp.tracer_background = 1.0e-5;
+    p_constant_pp.convection_threshold = -5.0e-8;
+    p_constant_pp.max_vert_diff_veloc = 0.1;
+    p_constant_pp.max_vert_diff_tracer = 0.1;
+
+    m_is_view_init = false;
+}
+
+void PP_backend::calc(t_patch p_patch, t_cvmix p_cvmix, t_vertical_stability stability,
+                      const t_index_range &range) {
+    this->calc_impl(p_patch, p_cvmix, stability, range);
+}
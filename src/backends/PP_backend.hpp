@@ -0,0 +1,77 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_BACKENDS_PP_BACKEND_HPP_
+#define SRC_BACKENDS_PP_BACKEND_HPP_
+
+#include <memory>
+#include "src/shared/interface/data_struct.hpp"
+#include "src/shared/memory_accounting.hpp"
+
+/*! \brief PP backend class.
+ *
+ *  It implements the part of the Pacanowski-Philander scheme which is in common for each backend:
+ *   - library frontend-backend interface
+ *   - scheme parameters
+ *  The vertical stability is not computed here: it is the one published by the tke backend.
+ */
+class PP_backend {
+ public:
+    typedef std::shared_ptr<PP_backend> Ptr;
+
+    /*! \brief PP backend class constructor.
+    */
+    PP_backend(int nproma, int nlevs, int nblocks);
+
+    /*! \brief PP backend class destructor.
+    */
+    virtual ~PP_backend() = default;
+
+    /*! \brief PP backend calculation.
+    *
+    *  It calls calc_impl which contains the actual implementation.
+    */
+    void calc(t_patch p_patch, t_cvmix p_cvmix, t_vertical_stability stability, const t_index_range &range);
+
+    /*! \brief Mark the memory views as outdated.
+    *
+    *  The memory view structures are rebuilt from the pointers passed to the next calc call.
+    */
+    void invalidate_views() { m_is_view_init = false; }
+
+    /*! \brief Allocations of the backend.
+    *
+    */
+    const memory_accounting &memory() const { return m_memory; }
+
+ protected:
+    /*! \brief Polymorphic function for the actual PP scheme backend implementation.
+    *
+    */
+    virtual void calc_impl(t_patch p_patch, t_cvmix p_cvmix, t_vertical_stability stability,
+                           const t_index_range &range) = 0;
+
+    // Structures with parameters
+    struct t_constant p_constant;
+    struct t_constant_pp p_constant_pp;
+
+    bool m_is_view_init;
+    // Allocations of the instance
+    memory_accounting m_memory;
+};
+
+#endif  // SRC_BACKENDS_PP_BACKEND_HPP_
@@ -15,7 +15,10 @@
  */
 
 #include "src/backends/TKE_backend.hpp"
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <utility>
 
 TKE_backend::TKE_backend(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemix_tke,
                          int vert_cor_type, double dtime, double OceanReferenceDensity, double grav,
@@ -40,7 +43,7 @@ TKE_backend::TKE_backend(int nproma, int nlevs, int nblocks, int vert_mix_type,
     p_constant_tke.c_eps = 0.7;
     p_constant_tke.cd = 3.75;
     p_constant_tke.alpha_tke = 30.0;
-    p_constant_tke.clc = 0.15;
+    p_constant_tke.c_stokes = 0.016;
     p_constant_tke.mxl_min = 1.0e-8;
     p_constant_tke.KappaM_min = 1.0e-4;
     p_constant_tke.KappaH_min = 1.0e-5;
@@ -49,12 +52,39 @@ TKE_backend::TKE_backend(int nproma, int nlevs, int nblocks, int vert_mix_type,
     p_constant_tke.tke_min = 1.0e-6;
     p_constant_tke.tke_mxl_choice = 2;
     p_constant_tke.handle_old_vals = 1;
-    p_constant_tke.only_tke = true;
+    // with IDEMIX the tke is forced by the internal wave dissipation and not bounded by tke_min
+    p_constant_tke.only_tke = (vert_mix_type != vmix_idemix_tke);
     p_constant_tke.use_Kappa_min = false;
     p_constant_tke.use_ubound_dirichlet = false;
     p_constant_tke.use_lbound_dirichlet = false;
+    p_constant_tke.tridiag_solver = tridiag_thomas;
+    p_constant_tke.nsubsteps = 1;
+    // quiescent columns are skipped and edges are fused only on request (set_quiescence, set_fuse_edges)
+    p_constant_tke.quiescent_threshold = 0.0;
+    p_constant_tke.quiescent_refresh = 10;
+    p_constant_tke.fuse_edges = false;
+
+    // Internal parameters are set for now to the ICON default values
+    p_constant_idemix.tau_v = 86400.0;
+    p_constant_idemix.tau_h = 1296000.0;
+    p_constant_idemix.gamma = 1.57;
+    p_constant_idemix.jstar = 5.0;
+    p_constant_idemix.mu0 = 4.0 / 3.0;
 
     m_is_view_init = false;
+    m_is_quiescence_reset = false;
+    m_is_idemix_view_init = false;
+    std::memset(&m_patch_bound, 0, sizeof(m_patch_bound));
+    m_is_stability_valid = false;
+    m_stability_generation = 0;
+    m_tke_stability_generation = 0;
+    m_idemix_stability_generation = 0;
+    std::memset(&m_stability_range, 0, sizeof(m_stability_range));
+    m_stability_Nsqr = nullptr;
+    m_stability_Ssqr = nullptr;
+    timing_reset(&m_timing);
+    m_trace_origin = std::chrono::steady_clock::now();
+    reserve_thread_timers(1);
 }
 
 void TKE_backend::calc(t_patch p_patch, t_cvmix p_cvmix,
@@ -64,9 +94,182 @@ void TKE_backend::calc(t_patch p_patch, t_cvmix p_cvmix,
                        int edges_start_index, int edges_end_index, int cells_block_size,
                        int cells_start_block, int cells_end_block, int cells_start_index,
                        int cells_end_index) {
+    reset_thread_timers();
+    YAOP_TIMER_START(timer_call, &m_thread_timers[0]);
     this->calc_impl(p_patch, p_cvmix, ocean_state, atmos_fluxes, p_as, p_sea_ice,
                     edges_block_size, edges_start_block, edges_end_block,
                     edges_start_index, edges_end_index, cells_block_size,
                     cells_start_block, cells_end_block, cells_start_index,
                     cells_end_index);
+    m_thread_timers[0].block = -1;
+    YAOP_TIMER_STOP(timer_call, &m_thread_timers[0], trace_call);
+    merge_thread_timers();
+}
+
+bool TKE_backend::calc_substeps(t_patch p_patch, t_cvmix p_cvmix,
+                                t_ocean_state ocean_state, t_atmo_fluxes atmos_fluxes,
+                                t_atmos_for_ocean p_as, t_sea_ice p_sea_ice,
+                                const t_index_range &range, int nsubsteps, double dtime) {
+    if (nsubsteps < 1 || !(dtime > 0.0)) {
+        std::cerr << "YAOP: invalid substeps " << nsubsteps << " of dtime " << dtime
+                  << ", expected a positive number of substeps and time step" << std::endl;
+        return false;
+    }
+    // the time step of the construction is used again by the next calls
+    double dtime_init = p_constant.dtime;
+    p_constant.dtime = dtime / nsubsteps;
+    p_constant_tke.nsubsteps = nsubsteps;
+    calc(p_patch, p_cvmix, ocean_state, atmos_fluxes, p_as, p_sea_ice,
+         range.edges_block_size, range.edges_start_block, range.edges_end_block,
+         range.edges_start_index, range.edges_end_index, range.cells_block_size,
+         range.cells_start_block, range.cells_end_block, range.cells_start_index,
+         range.cells_end_index);
+    p_constant.dtime = dtime_init;
+    p_constant_tke.nsubsteps = 1;
+    return true;
+}
+
+void TKE_backend::calc_vertical_stability(t_patch p_patch, t_ocean_state ocean_state, const t_index_range &range,
+                                          bool is_published) {
+    // the stage is not a tke call: only the stage timers are accumulated
+    reset_thread_timers();
+    if (this->calc_vertical_stability_impl(p_patch, ocean_state, range) && is_published)
+        publish_stability(range);
+    merge_thread_timers();
+}
+
+bool TKE_backend::calc_idemix(t_patch p_patch, t_cvmix p_cvmix, t_ocean_state ocean_state, t_idemix p_idemix,
+                              t_horizontal_grid p_grid, const t_index_range &range) {
+    // the stage is not a tke call: only the stage timers are accumulated
+    reset_thread_timers();
+    bool is_computed = this->calc_idemix_impl(p_patch, p_cvmix, ocean_state, p_idemix, p_grid, range);
+    merge_thread_timers();
+    return is_computed;
+}
+
+bool TKE_backend::calc_idemix_tke(t_patch p_patch, t_cvmix p_cvmix, t_ocean_state ocean_state,
+                                  t_atmo_fluxes atmos_fluxes, t_atmos_for_ocean p_as, t_sea_ice p_sea_ice,
+                                  t_idemix p_idemix, t_horizontal_grid p_grid, const t_index_range &range) {
+    reset_thread_timers();
+    YAOP_TIMER_START(timer_call, &m_thread_timers[0]);
+    bool is_computed = this->calc_idemix_tke_impl(p_patch, p_cvmix, ocean_state, atmos_fluxes, p_as, p_sea_ice,
+                                                  p_idemix, p_grid, range);
+    m_thread_timers[0].block = -1;
+    YAOP_TIMER_STOP(timer_call, &m_thread_timers[0], trace_call);
+    merge_thread_timers();
+    return is_computed;
+}
+
+bool TKE_backend::set_quiescence(double threshold, int refresh) {
+    if (!(threshold >= 0.0) || refresh < 1) {
+        std::cerr << "YAOP: invalid quiescence threshold " << threshold << " or refresh " << refresh
+                  << ", expected a non negative tke tendency and a positive number of steps" << std::endl;
+        return false;
+    }
+    if (threshold > 0.0 && !p_constant_tke.only_tke) {
+        std::cerr << "YAOP: the quiescent columns mode is not supported with IDEMIX" << std::endl;
+        return false;
+    }
+    p_constant_tke.quiescent_threshold = threshold;
+    p_constant_tke.quiescent_refresh = refresh;
+    m_is_quiescence_reset = true;
+    return true;
+}
+
+bool TKE_backend::set_tridiag_solver(int solver) {
+    if (solver != tridiag_thomas && solver != tridiag_pcr) {
+        std::cerr << "YAOP: unknown tridiagonal solver " << solver << ", expected " << tridiag_thomas
+                  << " (thomas) or " << tridiag_pcr << " (pcr)" << std::endl;
+        return false;
+    }
+    p_constant_tke.tridiag_solver = solver;
+    return true;
+}
+
+bool TKE_backend::set_tke_mxl_choice(int choice) {
+    if (choice != 2 && choice != 3) {
+        std::cerr << "YAOP: unknown tke_mxl_choice " << choice << ", expected 2 or 3" << std::endl;
+        return false;
+    }
+    p_constant_tke.tke_mxl_choice = choice;
+    return true;
+}
+
+bool TKE_backend::consume_stability(const t_index_range &range, int64_t *consumed) {
+    // only the cells range is relevant, the published fields are not defined outside of it
+    bool is_fresh = m_is_stability_valid && m_stability_generation > *consumed &&
+                    range.cells_block_size == m_stability_range.cells_block_size &&
+                    range.cells_start_block == m_stability_range.cells_start_block &&
+                    range.cells_end_block == m_stability_range.cells_end_block &&
+                    range.cells_start_index == m_stability_range.cells_start_index &&
+                    range.cells_end_index == m_stability_range.cells_end_index;
+    // otherwise the scheme computes the stability over the persistent fields, which are not published any more
+    if (!is_fresh)
+        m_is_stability_valid = false;
+    else
+        *consumed = m_stability_generation;
+    return is_fresh;
+}
+
+void TKE_backend::publish_stability(const t_index_range &range) {
+    m_stability_range = range;
+    m_stability_generation++;
+    m_is_stability_valid = true;
+}
+
+void TKE_backend::calc_ensemble(t_patch p_patch, int nmembers, const t_ensemble_member *members,
+                                const t_index_range &range) {
+    reset_thread_timers();
+    YAOP_TIMER_START(timer_call, &m_thread_timers[0]);
+    this->calc_ensemble_impl(p_patch, nmembers, members, range);
+    m_thread_timers[0].block = -1;
+    YAOP_TIMER_STOP(timer_call, &m_thread_timers[0], trace_call);
+    merge_thread_timers();
+}
+
+void TKE_backend::calc_ensemble_impl(t_patch p_patch, int nmembers, const t_ensemble_member *members,
+                                     const t_index_range &range) {
+    for (int m = 0; m < nmembers; m++) {
+        // each member binds different fields
+        m_is_view_init = false;
+        this->calc_impl(p_patch, members[m].p_cvmix, members[m].ocean_state, members[m].atmos_fluxes,
+                        members[m].p_as, members[m].p_sea_ice,
+                        range.edges_block_size, range.edges_start_block, range.edges_end_block,
+                        range.edges_start_index, range.edges_end_index, range.cells_block_size,
+                        range.cells_start_block, range.cells_end_block, range.cells_start_index,
+                        range.cells_end_index);
+    }
+    m_is_view_init = false;
+}
+
+void TKE_backend::reserve_thread_timers(int nthreads) {
+    while (static_cast<int>(m_thread_timers.size()) < nthreads) {
+        t_thread_timers timers;
+        timing_reset(&timers.report);
+        timers.block = -1;
+#ifdef YAOP_TRACING
+        // events kept per thread, the oldest ones are overwritten
+        size_t trace_capacity = 1 << 16;
+        if (const char *capacity = std::getenv("YAOP_TRACE_EVENTS"))
+            trace_capacity = std::strtoul(capacity, nullptr, 10);
+        timers.trace.reserve(trace_capacity);
+#endif
+        m_thread_timers.push_back(std::move(timers));
+    }
+}
+
+void TKE_backend::reset_thread_timers() {
+    for (t_thread_timers &timers : m_thread_timers) {
+        timing_reset(&timers.report);
+        timers.block = -1;
+    }
+}
+
+void TKE_backend::merge_thread_timers() {
+    for (const t_thread_timers &timers : m_thread_timers)
+        timing_merge(&m_timing, timers.report);
+}
+
+void TKE_backend::dump_trace(const std::string &filename) const {
+    trace_write(filename, m_thread_timers, m_trace_origin);
 }
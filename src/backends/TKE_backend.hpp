@@ -17,9 +17,16 @@
 #ifndef SRC_BACKENDS_TKE_BACKEND_HPP_
 #define SRC_BACKENDS_TKE_BACKEND_HPP_
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 #include "src/shared/interface/data_struct.hpp"
+#include "src/backends/memview_fill.hpp"
 #include "src/shared/interface/memview_struct.hpp"
+#include "src/shared/memory_accounting.hpp"
+#include "src/shared/timing.hpp"
 
 /*! \brief TKE backend class.
  *
@@ -53,6 +60,128 @@ class TKE_backend {
               int cells_start_block, int cells_end_block, int cells_start_index,
               int cells_end_index);
 
+    /*! \brief TKE backend calculation of nsubsteps time steps of length dtime / nsubsteps.
+    *
+    *  It calls calc_impl with the time step of this call. The geometry, the vertical stability and the
+    *  surface forcing are computed once and shared by the substeps of each block, and the diagnostics are
+    *  the ones of the last substep. It returns false and computes nothing for invalid substeps or time step.
+    */
+    bool calc_substeps(t_patch p_patch, t_cvmix p_cvmix,
+                       t_ocean_state ocean_state, t_atmo_fluxes atmos_fluxes,
+                       t_atmos_for_ocean p_as, t_sea_ice p_sea_ice,
+                       const t_index_range &range, int nsubsteps, double dtime);
+
+    /*! \brief TKE backend calculation of an ensemble of members sharing the grid info.
+    *
+    *  It calls calc_ensemble_impl. The output fields of the members must not overlap.
+    */
+    void calc_ensemble(t_patch p_patch, int nmembers, const t_ensemble_member *members,
+                       const t_index_range &range);
+
+    /*! \brief Vertical stability (Nsqr and Ssqr) of the cells range, published for the mixing schemes.
+    *
+    *  It calls calc_vertical_stability_impl. The next calc over the same cells range consumes the
+    *  published fields instead of evaluating the densities again. A scheme computing the stability for
+    *  itself does not publish it (is_published false).
+    */
+    void calc_vertical_stability(t_patch p_patch, t_ocean_state ocean_state, const t_index_range &range,
+                                 bool is_published = true);
+
+    /*! \brief Consume the vertical stability published by calc_vertical_stability for the cells range.
+    *
+    *   consumed is the generation read by the scheme at its previous call (0 at the first call). A
+    *   publication is read once by each scheme: a second call of the same scheme belongs to the next time
+    *   step, so the publication is discarded and false is returned, as for another cells range.
+    */
+    bool consume_stability(const t_index_range &range, int64_t *consumed);
+
+    /*! \brief Persistent vertical stability fields (nblocks, nlevs+1, nproma) of the backend.
+    *
+    *   The pointers are null when the backend does not publish the vertical stability.
+    */
+    t_vertical_stability stability() const { return {m_stability_Nsqr, m_stability_Ssqr}; }
+
+    /*! \brief IDEMIX calculation of the internal wave energy on the bound fields.
+    *
+    *  It calls calc_idemix_impl and returns false if the backend does not implement IDEMIX.
+    *  The internal wave dissipation is written to iwe_Tdis for a tke calculation called afterwards.
+    */
+    bool calc_idemix(t_patch p_patch, t_cvmix p_cvmix, t_ocean_state ocean_state, t_idemix p_idemix,
+                     t_horizontal_grid p_grid, const t_index_range &range);
+
+    /*! \brief Coupled IDEMIX and TKE backend calculation.
+    *
+    *  It calls calc_idemix_tke_impl and returns false if the backend does not implement IDEMIX.
+    *  The internal wave dissipation is passed from IDEMIX to tke in the block scratch of the thread.
+    */
+    bool calc_idemix_tke(t_patch p_patch, t_cvmix p_cvmix, t_ocean_state ocean_state,
+                         t_atmo_fluxes atmos_fluxes, t_atmos_for_ocean p_as, t_sea_ice p_sea_ice,
+                         t_idemix p_idemix, t_horizontal_grid p_grid, const t_index_range &range);
+
+    /*! \brief Mark the memory views and the published vertical stability as outdated.
+    *
+    *  The memory view structures are rebuilt from the pointers passed to the next calc call, which
+    *  is a full step in the quiescent columns mode since the outputs of the new fields are not written.
+    *  The cost does not depend on the problem size.
+    */
+    void invalidate_views() {
+        m_is_view_init = false;
+        m_is_idemix_view_init = false;
+        m_is_stability_valid = false;
+        m_is_quiescence_reset = true;
+    }
+
+    /*! \brief Stage timers accumulated since the construction or the last reset_timing call.
+    *
+    */
+    const t_timing_report &timing_report() const { return m_timing; }
+
+    /*! \brief Reset the stage timers.
+    *
+    */
+    void reset_timing() { timing_reset(&m_timing); }
+
+    /*! \brief Write the execution timeline of all the threads as Chrome trace JSON.
+    *
+    *   The timeline is recorded only when the library is compiled with YAOP_TRACING.
+    */
+    void dump_trace(const std::string &filename) const;
+
+    /*! \brief Columns skipped in the last call by the quiescent columns mode.
+    *
+    *   enabled is 0 when the mode is off or when the backend does not implement it.
+    */
+    virtual t_quiescence_report quiescence_report() const { return {0, 0, 0, 0, 0.0}; }
+
+    /*! \brief Skip the tke step of the quiescent blocks of columns, threshold 0 computes all of them.
+    *
+    *   A full step is forced every refresh skipped steps. It returns false and keeps the previous
+    *   setting for a negative threshold, a refresh smaller than 1 or a positive threshold with IDEMIX.
+    */
+    bool set_quiescence(double threshold, int refresh);
+
+    /*! \brief Compute the edges with both neighbours in the same cell block right after the block.
+    *
+    */
+    void set_fuse_edges(bool fuse_edges) { p_constant_tke.fuse_edges = fuse_edges; }
+
+    /*! \brief Solver of the tridiagonal system of tke (a t_tridiag_solver).
+    *
+    *   It returns false and keeps the previous solver for an unknown one.
+    */
+    bool set_tridiag_solver(int solver);
+
+    /*! \brief Bound of the mixing length: 2 by its vertical gradient, 3 by the distance to the surface and bottom.
+    *
+    *   It returns false and keeps the previous choice for any other value.
+    */
+    bool set_tke_mxl_choice(int choice);
+
+    /*! \brief Allocations of the backend (internal fields, geometry cache, thread scratch and ensemble arrays).
+    *
+    */
+    const memory_accounting &memory() const { return m_memory; }
+
  protected:
     /*! \brief Polymorphic function for the actual TKE scheme backend implementation.
     *
@@ -65,97 +194,58 @@ class TKE_backend {
                            int cells_start_block, int cells_end_block, int cells_start_index,
                            int cells_end_index) = 0;
 
-    /*! \brief fill a structure of memory views given a structure of pointers about the grid info.
+    /*! \brief Polymorphic function for the ensemble implementation.
     *
-    *   It is templated with a memview class and a dext class which define the memory view implementation
-    *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
-    *   and how to create a memory view object.
+    *   The default implementation computes the members one after the other with calc_impl.
     */
-    template <template <class ...> class memview,
-              template <class, size_t> class dext,
-              class memview_policy>
-    void fill_struct_memview(t_patch_view<memview, dext> *p_patch_view,
-                             t_patch *p_patch, int nblocks, int nlevs, int nproma) {
-        p_patch_view->depth_CellInterface = memview_policy::memview(p_patch->depth_CellInterface,
-                                                                    nblocks, nlevs+1, nproma);
-        p_patch_view->prism_center_dist_c = memview_policy::memview(p_patch->prism_center_dist_c,
-                                                                    nblocks, nlevs+1, nproma);
-        p_patch_view->inv_prism_center_dist_c = memview_policy::memview(p_patch->inv_prism_center_dist_c,
-                                                                        nblocks, nlevs+1, nproma);
-        p_patch_view->prism_thick_c = memview_policy::memview(p_patch->prism_thick_c, nblocks, nlevs, nproma);
-        p_patch_view->dolic_c = memview_policy::memview(p_patch->dolic_c, nblocks, nproma);
-        p_patch_view->dolic_e = memview_policy::memview(p_patch->dolic_e, nblocks, nproma);
-        p_patch_view->zlev_i = memview_policy::memview(p_patch->zlev_i, nlevs);
-        p_patch_view->wet_c = memview_policy::memview(p_patch->wet_c, nblocks, nlevs, nproma);
-        p_patch_view->edges_cell_idx = memview_policy::memview(p_patch->edges_cell_idx, 2, nlevs, nproma);
-        p_patch_view->edges_cell_blk = memview_policy::memview(p_patch->edges_cell_blk, 2, nlevs, nproma);
-    }
+    virtual void calc_ensemble_impl(t_patch p_patch, int nmembers, const t_ensemble_member *members,
+                                    const t_index_range &range);
 
-    /*! \brief fill a structure of memory views given a structure of pointers about the sea ice info.
+    /*! \brief Polymorphic function for the vertical stability stage.
     *
-    *   It is templated with a memview class and a dext class which define the memory view implementation
-    *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
-    *   and how to create a memory view object.
+    *   It returns whether the fields were published. The default implementation does not publish
+    *   them and calc_impl keeps computing the vertical stability of each block.
     */
-    template <template <class ...> class memview,
-              template <class, size_t> class dext,
-              class memview_policy>
-    void fill_struct_memview(t_sea_ice_view<memview, dext> *p_sea_ice_view, t_sea_ice *p_sea_ice,
-                             int nblocks, int nproma) {
-        p_sea_ice_view->concsum = memview_policy::memview(p_sea_ice->concsum, nblocks, nproma);
-    }
+    virtual bool calc_vertical_stability_impl(t_patch, t_ocean_state, const t_index_range &) { return false; }
 
-    /*! \brief fill a structure of memory views given a structure of pointers about the atmosphere info.
+    /*! \brief Polymorphic function for the IDEMIX calculation.
     *
-    *   It is templated with a memview class and a dext class which define the memory view implementation
-    *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
-    *   and how to create a memory view object.
+    *   It returns whether IDEMIX has been computed. The default implementation does not compute it.
     */
-    template <template <class ...> class memview,
-              template <class, size_t> class dext,
-              class memview_policy>
-    void fill_struct_memview(t_atmos_for_ocean_view<memview, dext> *p_as_view, t_atmos_for_ocean *p_as,
-                             int nblocks, int nproma) {
-        p_as_view->fu10 = memview_policy::memview(p_as->fu10, nblocks, nproma);
-    }
+    virtual bool calc_idemix_impl(t_patch, t_cvmix, t_ocean_state, t_idemix, t_horizontal_grid,
+                                  const t_index_range &) { return false; }
 
-    /*! \brief fill a structure of memory views given a structure of pointers about the atmosphere fluxes info.
+    /*! \brief Polymorphic function for the coupled IDEMIX and TKE calculation.
     *
-    *   It is templated with a memview class and a dext class which define the memory view implementation
-    *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
-    *   and how to create a memory view object.
+    *   It returns whether the step has been computed. The default implementation does not compute it.
     */
-    template <template <class ...> class memview,
-              template <class, size_t> class dext,
-              class memview_policy>
-    void fill_struct_memview(t_atmo_fluxes_view<memview, dext> *atmos_fluxes_view, t_atmo_fluxes *atmos_fluxes,
-                             int nblocks, int nproma) {
-        atmos_fluxes_view->stress_xw = memview_policy::memview(atmos_fluxes->stress_xw, nblocks, nproma);
-        atmos_fluxes_view->stress_yw = memview_policy::memview(atmos_fluxes->stress_yw, nblocks, nproma);
-    }
+    virtual bool calc_idemix_tke_impl(t_patch, t_cvmix, t_ocean_state, t_atmo_fluxes, t_atmos_for_ocean, t_sea_ice,
+                                      t_idemix, t_horizontal_grid, const t_index_range &) { return false; }
 
-    /*! \brief fill a structure of memory views given a structure of pointers about the ocean state info.
+    /*! \brief Record that the vertical stability of the cells range has been published.
     *
-    *   It is templated with a memview class and a dext class which define the memory view implementation
-    *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
-    *   and how to create a memory view object.
     */
-    template <template <class ...> class memview,
-              template <class, size_t> class dext,
-              class memview_policy>
-    void fill_struct_memview(t_ocean_state_view<memview, dext> *ocean_state_view,
-                             t_ocean_state *ocean_state, int nblocks, int nlevs, int nproma) {
-        ocean_state_view->temp = memview_policy::memview(ocean_state->temp, nblocks, nlevs, nproma);
-        ocean_state_view->salt = memview_policy::memview(ocean_state->salt, nblocks, nlevs, nproma);
-        ocean_state_view->stretch_c = memview_policy::memview(ocean_state->stretch_c, nblocks, nproma);
-        ocean_state_view->eta_c = memview_policy::memview(ocean_state->eta_c, nblocks, nproma);
-        ocean_state_view->p_vn_x1 = memview_policy::memview(ocean_state->p_vn_x1, nblocks, nlevs, nproma);
-        ocean_state_view->p_vn_x2 = memview_policy::memview(ocean_state->p_vn_x2, nblocks, nlevs, nproma);
-        ocean_state_view->p_vn_x3 = memview_policy::memview(ocean_state->p_vn_x3, nblocks, nlevs, nproma);
-    }
+    void publish_stability(const t_index_range &range);
+
+    /*! \brief Make sure that there are timers for nthreads threads.
+    *
+    *   It has to be called outside of the parallel regions, before using the timers of the threads.
+    */
+    void reserve_thread_timers(int nthreads);
 
-    /*! \brief fill a structure of memory views given a structure of pointers about the cvmix info.
+    /*! \brief Reset the stage timers of the threads before a call.
     *
+    */
+    void reset_thread_timers();
+
+    /*! \brief Accumulate the stage timers of the threads in the timing report after a call.
+    *
+    */
+    void merge_thread_timers();
+
+    /*! \brief allocate internal memory and return a 1D memory view object of the allocated memory.
+    *
+    *   The allocation is recorded with its name in the memory accounting of the instance.
     *   It is templated with a memview class and a dext class which define the memory view implementation
     *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
     *   and how to create a memory view object.
@@ -163,33 +253,14 @@ class TKE_backend {
     template <template <class ...> class memview,
               template <class, size_t> class dext,
               class memview_policy>
-    void fill_struct_memview(t_cvmix_view<memview, dext> *p_cvmix_view, t_cvmix *p_cvmix,
-                             int nblocks, int nlevs, int nproma) {
-        p_cvmix_view->tke = memview_policy::memview(p_cvmix->tke, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_plc = memview_policy::memview(p_cvmix->tke_plc, nblocks, nlevs+1, nproma);
-        p_cvmix_view->hlc = memview_policy::memview(p_cvmix->hlc, nblocks, nproma);
-        p_cvmix_view->wlc = memview_policy::memview(p_cvmix->wlc, nblocks, nlevs+1, nproma);
-        p_cvmix_view->u_stokes = memview_policy::memview(p_cvmix->u_stokes, nblocks, nproma);
-        p_cvmix_view->a_veloc_v = memview_policy::memview(p_cvmix->a_veloc_v, nblocks, nlevs+1, nproma);
-        p_cvmix_view->a_temp_v = memview_policy::memview(p_cvmix->a_temp_v, nblocks, nlevs+1, nproma);
-        p_cvmix_view->a_salt_v = memview_policy::memview(p_cvmix->a_salt_v, nblocks, nlevs+1, nproma);
-        p_cvmix_view->iwe_Tdis = memview_policy::memview(p_cvmix->iwe_Tdis, nblocks, nlevs+1, nproma);
-        p_cvmix_view->cvmix_dummy_1 = memview_policy::memview(p_cvmix->cvmix_dummy_1, nblocks, nlevs+1, nproma);
-        p_cvmix_view->cvmix_dummy_2 = memview_policy::memview(p_cvmix->cvmix_dummy_2, nblocks, nlevs+1, nproma);
-        p_cvmix_view->cvmix_dummy_3 = memview_policy::memview(p_cvmix->cvmix_dummy_3, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Tbpr = memview_policy::memview(p_cvmix->tke_Tbpr, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Tspr = memview_policy::memview(p_cvmix->tke_Tspr, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Tdif = memview_policy::memview(p_cvmix->tke_Tdif, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Tdis = memview_policy::memview(p_cvmix->tke_Tdis, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Twin = memview_policy::memview(p_cvmix->tke_Twin, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Tiwf = memview_policy::memview(p_cvmix->tke_Tiwf, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Tbck = memview_policy::memview(p_cvmix->tke_Tbck, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Ttot = memview_policy::memview(p_cvmix->tke_Ttot, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Lmix = memview_policy::memview(p_cvmix->tke_Lmix, nblocks, nlevs+1, nproma);
-        p_cvmix_view->tke_Pr = memview_policy::memview(p_cvmix->tke_Pr, nblocks, nlevs+1, nproma);
+    memview<double, dext<int, 1>> memview_malloc(const char *name, double *&field, int dim1) {
+        memview<double, dext<int, 1>> view = counting_memview_policy<memview_policy>(&m_memory)
+                                                     .memview_malloc(name, field, dim1);
+        field = view.data_handle();
+        return view;
     }
 
-    /*! \brief allocate internal memory and return a 1D memory view object of the allocated memory.
+    /*! \brief allocate internal memory and return a 2D memory view object of the allocated memory.
     *
     *   It is templated with a memview class and a dext class which define the memory view implementation
     *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
@@ -198,11 +269,14 @@ class TKE_backend {
     template <template <class ...> class memview,
               template <class, size_t> class dext,
               class memview_policy>
-    memview<double, dext<int, 1>> memview_malloc(double *field, int dim1) {
-        return memview_policy::memview_malloc(field, dim1);
+    memview<double, dext<int, 2>> memview_malloc(const char *name, double *&field, int dim1, int dim2) {
+        memview<double, dext<int, 2>> view = counting_memview_policy<memview_policy>(&m_memory)
+                                                     .memview_malloc(name, field, dim1, dim2);
+        field = view.data_handle();
+        return view;
     }
 
-    /*! \brief allocate internal memory and return a 2D memory view object of the allocated memory.
+    /*! \brief allocate internal memory and return a 3D memory view object of the allocated memory.
     *
     *   It is templated with a memview class and a dext class which define the memory view implementation
     *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
@@ -211,11 +285,14 @@ class TKE_backend {
     template <template <class ...> class memview,
               template <class, size_t> class dext,
               class memview_policy>
-    memview<double, dext<int, 2>> memview_malloc(double *field, int dim1, int dim2) {
-        return memview_policy::memview_malloc(field, dim1, dim2);
+    memview<double, dext<int, 3>> memview_malloc(const char *name, double *&field, int dim1, int dim2, int dim3) {
+        memview<double, dext<int, 3>> view = counting_memview_policy<memview_policy>(&m_memory)
+                                                     .memview_malloc(name, field, dim1, dim2, dim3);
+        field = view.data_handle();
+        return view;
     }
 
-    /*! \brief allocate internal memory and return a 3D memory view object of the allocated memory.
+    /*! \brief allocate internal memory and return a 1D memory view object of the allocated integer memory.
     *
     *   It is templated with a memview class and a dext class which define the memory view implementation
     *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
@@ -224,8 +301,11 @@ class TKE_backend {
     template <template <class ...> class memview,
               template <class, size_t> class dext,
               class memview_policy>
-    memview<double, dext<int, 3>> memview_malloc(double *field, int dim1, int dim2, int dim3) {
-        return memview_policy::memview_malloc(field, dim1, dim2, dim3);
+    memview<int, dext<int, 1>> memview_malloc(const char *name, int *&field, int dim1) {
+        memview<int, dext<int, 1>> view = counting_memview_policy<memview_policy>(&m_memory)
+                                                     .memview_malloc(name, field, dim1);
+        field = view.data_handle();
+        return view;
     }
 
     /*! \brief deallocate internal memory.
@@ -234,7 +314,16 @@ class TKE_backend {
     */
     template <typename memview_policy>
     void memview_free(double *field) {
-        return memview_policy::memview_free(field);
+        counting_memview_policy<memview_policy>(&m_memory).memview_free(field);
+    }
+
+    /*! \brief deallocate internal integer memory.
+    *
+    *   It is templated with a memview_policy which defines how to deallocate memory in the actual backend.
+    */
+    template <typename memview_policy>
+    void memview_free(int *field) {
+        counting_memview_policy<memview_policy>(&m_memory).memview_free(field);
     }
 
     /*! \brief fill the internal data structure allocating the arrays and creating memory views.
@@ -248,49 +337,52 @@ class TKE_backend {
               class memview_policy>
     void internal_fields_malloc(t_tke_internal_view<memview, dext> *p_internal_view) {
         p_internal_view->tke_old = this->memview_malloc<memview, dext, memview_policy>
-                                         (m_tke_old, p_constant.nlevs+1, p_constant.nproma);
+                                         ("tke_old", m_tke_old, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->forc_tke_surf_2D = this->memview_malloc<memview, dext, memview_policy>
-                                                  (m_forc_tke_surf_2D, p_constant.nproma);
+                                                  ("forc_tke_surf_2D", m_forc_tke_surf_2D, p_constant.nproma);
+        p_internal_view->pot_energy_lc_2D = this->memview_malloc<memview, dext, memview_policy>
+                                                  ("pot_energy_lc_2D", m_pot_energy_lc_2D, p_constant.nproma);
         p_internal_view->dzw_stretched = this->memview_malloc<memview, dext, memview_policy>
-                                               (m_dzw_stretched, p_constant.nlevs, p_constant.nproma);
+                                               ("dzw_stretched", m_dzw_stretched, p_constant.nlevs, p_constant.nproma);
         p_internal_view->dzt_stretched = this->memview_malloc<memview, dext, memview_policy>
-                                               (m_dzt_stretched, p_constant.nlevs+1, p_constant.nproma);
+                                               ("dzt_stretched", m_dzt_stretched,
+                                                p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->tke_Av = this->memview_malloc<memview, dext, memview_policy>
-                                        (m_tke_Av, p_constant.nblocks, p_constant.nlevs+1, p_constant.nproma);
+                                        ("tke_Av", m_tke_Av, p_constant.nblocks, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->tke_kv = this->memview_malloc<memview, dext, memview_policy>
-                                        (m_tke_kv, p_constant.nlevs+1, p_constant.nproma);
+                                        ("tke_kv", m_tke_kv, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->Nsqr = this->memview_malloc<memview, dext, memview_policy>
-                                      (m_Nsqr, p_constant.nlevs+1, p_constant.nproma);
+                                      ("Nsqr", m_Nsqr, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->Ssqr = this->memview_malloc<memview, dext, memview_policy>
-                                      (m_Ssqr, p_constant.nlevs+1, p_constant.nproma);
+                                      ("Ssqr", m_Ssqr, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->a_dif = this->memview_malloc<memview, dext, memview_policy>
-                                       (m_a_dif, p_constant.nlevs+1, p_constant.nproma);
+                                       ("a_dif", m_a_dif, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->b_dif = this->memview_malloc<memview, dext, memview_policy>
-                                       (m_b_dif, p_constant.nlevs+1, p_constant.nproma);
+                                       ("b_dif", m_b_dif, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->c_dif = this->memview_malloc<memview, dext, memview_policy>
-                                       (m_c_dif, p_constant.nlevs+1, p_constant.nproma);
+                                       ("c_dif", m_c_dif, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->a_tri = this->memview_malloc<memview, dext, memview_policy>
-                                       (m_a_tri, p_constant.nlevs+1, p_constant.nproma);
+                                       ("a_tri", m_a_tri, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->b_tri = this->memview_malloc<memview, dext, memview_policy>
-                                       (m_b_tri, p_constant.nlevs+1, p_constant.nproma);
+                                       ("b_tri", m_b_tri, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->c_tri = this->memview_malloc<memview, dext, memview_policy>
-                                       (m_c_tri, p_constant.nlevs+1, p_constant.nproma);
+                                       ("c_tri", m_c_tri, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->d_tri = this->memview_malloc<memview, dext, memview_policy>
-                                       (m_d_tri, p_constant.nlevs+1, p_constant.nproma);
+                                       ("d_tri", m_d_tri, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->sqrttke = this->memview_malloc<memview, dext, memview_policy>
-                                         (m_sqrttke, p_constant.nlevs+1, p_constant.nproma);
+                                         ("sqrttke", m_sqrttke, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->forc = this->memview_malloc<memview, dext, memview_policy>
-                                      (m_forc, p_constant.nlevs+1, p_constant.nproma);
+                                      ("forc", m_forc, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->ke = this->memview_malloc<memview, dext, memview_policy>
-                                    (m_ke, p_constant.nlevs+1, p_constant.nproma);
+                                    ("ke", m_ke, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->cp = this->memview_malloc<memview, dext, memview_policy>
-                                    (m_cp, p_constant.nlevs+1, p_constant.nproma);
+                                    ("cp", m_cp, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->dp = this->memview_malloc<memview, dext, memview_policy>
-                                    (m_dp, p_constant.nlevs+1, p_constant.nproma);
+                                    ("dp", m_dp, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->tke_upd = this->memview_malloc<memview, dext, memview_policy>
-                                         (m_tke_upd, p_constant.nlevs+1, p_constant.nproma);
+                                         ("tke_upd", m_tke_upd, p_constant.nlevs+1, p_constant.nproma);
         p_internal_view->tke_unrest = this->memview_malloc<memview, dext, memview_policy>
-                                            (m_tke_unrest, p_constant.nlevs+1, p_constant.nproma);
+                                            ("tke_unrest", m_tke_unrest, p_constant.nlevs+1, p_constant.nproma);
     }
 
     /*! \brief free the internal data structure memory deallocating the arrays.
@@ -300,9 +392,10 @@ class TKE_backend {
     template <typename memview_policy>
     void internal_fields_free() {
         this->memview_free<memview_policy>(m_tke_old);
+        this->memview_free<memview_policy>(m_forc_tke_surf_2D);
+        this->memview_free<memview_policy>(m_pot_energy_lc_2D);
         this->memview_free<memview_policy>(m_dzw_stretched);
         this->memview_free<memview_policy>(m_dzt_stretched);
-        this->memview_free<memview_policy>(m_tke_old);
         this->memview_free<memview_policy>(m_tke_Av);
         this->memview_free<memview_policy>(m_tke_kv);
         this->memview_free<memview_policy>(m_Nsqr);
@@ -323,17 +416,115 @@ class TKE_backend {
         this->memview_free<memview_policy>(m_tke_unrest);
     }
 
+    /*! \brief fill the geometry cache structure allocating the arrays and creating memory views.
+    *
+    *   The geometry cache holds the time-invariant vertical grid terms (stretched layer thicknesses,
+    *   inverse distances, reference pressure and maximum number of levels per block), which only
+    *   depend on the grid and on stretch_c.
+    *   It is templated with a memview class and a dext class which define the memory view implementation
+    *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+    *   and how to create a memory view object.
+    */
+    template <template <class ...> class memview,
+              template <class, size_t> class dext,
+              class memview_policy>
+    void geometry_fields_malloc(t_tke_geometry_view<memview, dext> *p_geometry_view) {
+        p_geometry_view->dzw_stretched = this->memview_malloc<memview, dext, memview_policy>
+                                               ("geometry.dzw_stretched", m_geometry_dzw_stretched,
+                                                p_constant.nblocks, p_constant.nlevs, p_constant.nproma);
+        p_geometry_view->dzt_stretched = this->memview_malloc<memview, dext, memview_policy>
+                                               ("geometry.dzt_stretched", m_geometry_dzt_stretched,
+                                                p_constant.nblocks, p_constant.nlevs+1, p_constant.nproma);
+        p_geometry_view->inv_dzt_stretched = this->memview_malloc<memview, dext, memview_policy>
+                                                   ("geometry.inv_dzt_stretched", m_geometry_inv_dzt_stretched,
+                                                    p_constant.nblocks, p_constant.nlevs+1, p_constant.nproma);
+        p_geometry_view->stretch_c = this->memview_malloc<memview, dext, memview_policy>
+                                           ("geometry.stretch_c", m_geometry_stretch_c,
+                                            p_constant.nblocks, p_constant.nproma);
+        p_geometry_view->pressure = this->memview_malloc<memview, dext, memview_policy>
+                                          ("geometry.pressure", m_geometry_pressure, p_constant.nlevs);
+        p_geometry_view->max_levels = this->memview_malloc<memview, dext, memview_policy>
+                                            ("geometry.max_levels", m_geometry_max_levels, p_constant.nblocks);
+    }
+
+    /*! \brief fill the vertical stability structure allocating the arrays and creating memory views.
+    *
+    *   Nsqr and Ssqr are kept for all the blocks, so that they can be shared by the mixing schemes
+    *   of a time step.
+    *   It is templated with a memview class and a dext class which define the memory view implementation
+    *   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+    *   and how to create a memory view object.
+    */
+    template <template <class ...> class memview,
+              template <class, size_t> class dext,
+              class memview_policy>
+    void stability_fields_malloc(t_vertical_stability_view<memview, dext> *p_stability_view) {
+        p_stability_view->Nsqr = this->memview_malloc<memview, dext, memview_policy>
+                                       ("stability.Nsqr", m_stability_Nsqr,
+                                        p_constant.nblocks, p_constant.nlevs+1, p_constant.nproma);
+        p_stability_view->Ssqr = this->memview_malloc<memview, dext, memview_policy>
+                                       ("stability.Ssqr", m_stability_Ssqr,
+                                        p_constant.nblocks, p_constant.nlevs+1, p_constant.nproma);
+    }
+
+    /*! \brief free the vertical stability memory deallocating the arrays.
+    *
+    *   It is templated with a memview_policy which defines how to deallocate memory in the actual backend.
+    */
+    template <typename memview_policy>
+    void stability_fields_free() {
+        this->memview_free<memview_policy>(m_stability_Nsqr);
+        this->memview_free<memview_policy>(m_stability_Ssqr);
+    }
+
+    /*! \brief free the geometry cache memory deallocating the arrays.
+    *
+    *   It is templated with a memview_policy which defines how to deallocate memory in the actual backend.
+    */
+    template <typename memview_policy>
+    void geometry_fields_free() {
+        this->memview_free<memview_policy>(m_geometry_dzw_stretched);
+        this->memview_free<memview_policy>(m_geometry_dzt_stretched);
+        this->memview_free<memview_policy>(m_geometry_inv_dzt_stretched);
+        this->memview_free<memview_policy>(m_geometry_stretch_c);
+        this->memview_free<memview_policy>(m_geometry_pressure);
+        this->memview_free<memview_policy>(m_geometry_max_levels);
+    }
+
  protected:
     // Structures with parameters
     struct t_constant p_constant;
     struct t_constant_tke p_constant_tke;
+    struct t_constant_idemix p_constant_idemix;
 
     bool m_is_view_init;
+    // The quiescent columns mode restarts with a full step after a change of its setting
+    bool m_is_quiescence_reset;
+    // Memory views of the IDEMIX fields, rebuilt independently of the tke ones
+    bool m_is_idemix_view_init;
+    // Stage timers, the timers of the threads are accumulated here after each call
+    struct t_timing_report m_timing;
+    // Timers of each thread, the first one is also used outside of the parallel regions
+    std::vector<t_thread_timers> m_thread_timers;
+    // Origin of the timeline timestamps
+    std::chrono::steady_clock::time_point m_trace_origin;
+    // Allocations of the instance
+    memory_accounting m_memory;
+    // Grid info pointers used to build the current memory views
+    struct t_patch m_patch_bound;
+    // Vertical stability: generation and cells range of the fields published by calc_vertical_stability,
+    // generations consumed by tke and idemix
+    bool m_is_stability_valid;
+    int64_t m_stability_generation;
+    int64_t m_tke_stability_generation;
+    int64_t m_idemix_stability_generation;
+    struct t_index_range m_stability_range;
 
     double *m_tke_old;
     double *m_tke_Av;
     double *m_tke_kv;
     double *m_forc_tke_surf_2D;
+    double *m_pot_energy_lc_2D;
     double *m_dzw_stretched;
     double *m_dzt_stretched;
     double *m_Nsqr;
@@ -352,6 +543,18 @@ class TKE_backend {
     double *m_dp;
     double *m_tke_upd;
     double *m_tke_unrest;
+
+    // Geometry cache
+    double *m_geometry_dzw_stretched;
+    double *m_geometry_dzt_stretched;
+    double *m_geometry_inv_dzt_stretched;
+    double *m_geometry_stretch_c;
+    double *m_geometry_pressure;
+    int *m_geometry_max_levels;
+
+    // Vertical stability
+    double *m_stability_Nsqr;
+    double *m_stability_Ssqr;
 };
 
 #endif  // SRC_BACKENDS_TKE_BACKEND_HPP_
@@ -68,3 +68,20 @@ double calculate_density(double temp, double salt, double pressure) {
 
     return rho/denom;
 }
+
+#if defined CUDA || defined HIP
+__device__
+#endif
+double idemix_gofx2(double x, double pi) {
+    x = max(3.0, x);
+    double c = 1.0 - (2.0 / pi) * asin(1.0 / x);
+    return 2.0 / pi / c * 0.9 * pow(x, -2.0 / 3.0) * (1.0 - exp(-x / 4.3));
+}
+
+#if defined CUDA || defined HIP
+__device__
+#endif
+double idemix_hofx1(double x, double pi) {
+    x = max(1.0 + 1.0e-10, x);
+    return (2.0 / pi) / (1.0 - (2.0 / pi) * asin(1.0 / x)) * (x - 1.0) / (x + 1.0);
+}
@@ -25,4 +25,22 @@ __device__
 #endif
 double calculate_density(double temp, double salt, double pressure);
 
+/*! \brief IDEMIX shape function of the vertical group velocity of the internal waves.
+*
+*   x is the ratio of the buoyancy frequency to the Coriolis parameter.
+*/
+#if defined CUDA || defined HIP
+__device__
+#endif
+double idemix_gofx2(double x, double pi);
+
+/*! \brief IDEMIX shape function of the horizontal group velocity of the internal waves.
+*
+*   x is the ratio of the buoyancy frequency to the Coriolis parameter.
+*/
+#if defined CUDA || defined HIP
+__device__
+#endif
+double idemix_hofx1(double x, double pi);
+
 #endif  // SRC_BACKENDS_KERNELS_HPP_
@@ -0,0 +1,205 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_BACKENDS_MEMVIEW_FILL_HPP_
+#define SRC_BACKENDS_MEMVIEW_FILL_HPP_
+
+#include <cstddef>
+#include "src/shared/interface/data_struct.hpp"
+#include "src/shared/interface/memview_struct.hpp"
+
+// Memory views of the structures of pointers passed by the model, shared by the backends of the schemes
+
+/*! \brief fill a structure of memory views given a structure of pointers about the grid info.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_patch_view<memview, dext> *p_patch_view,
+                         t_patch *p_patch, int nblocks, int nlevs, int nproma) {
+    p_patch_view->depth_CellInterface = memview_policy::memview(p_patch->depth_CellInterface,
+                                                                nblocks, nlevs+1, nproma);
+    p_patch_view->prism_center_dist_c = memview_policy::memview(p_patch->prism_center_dist_c,
+                                                                nblocks, nlevs+1, nproma);
+    p_patch_view->inv_prism_center_dist_c = memview_policy::memview(p_patch->inv_prism_center_dist_c,
+                                                                    nblocks, nlevs+1, nproma);
+    p_patch_view->prism_thick_c = memview_policy::memview(p_patch->prism_thick_c, nblocks, nlevs, nproma);
+    p_patch_view->dolic_c = memview_policy::memview(p_patch->dolic_c, nblocks, nproma);
+    p_patch_view->dolic_e = memview_policy::memview(p_patch->dolic_e, nblocks, nproma);
+    p_patch_view->zlev_i = memview_policy::memview(p_patch->zlev_i, nlevs);
+    p_patch_view->wet_c = memview_policy::memview(p_patch->wet_c, nblocks, nlevs, nproma);
+    p_patch_view->edges_cell_idx = memview_policy::memview(p_patch->edges_cell_idx, 2, nblocks, nproma);
+    p_patch_view->edges_cell_blk = memview_policy::memview(p_patch->edges_cell_blk, 2, nblocks, nproma);
+}
+
+/*! \brief fill a structure of memory views given a structure of pointers about the sea ice info.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_sea_ice_view<memview, dext> *p_sea_ice_view, t_sea_ice *p_sea_ice,
+                         int nblocks, int nproma) {
+    p_sea_ice_view->concsum = memview_policy::memview(p_sea_ice->concsum, nblocks, nproma);
+}
+
+/*! \brief fill a structure of memory views given a structure of pointers about the atmosphere info.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_atmos_for_ocean_view<memview, dext> *p_as_view, t_atmos_for_ocean *p_as,
+                         int nblocks, int nproma) {
+    p_as_view->fu10 = memview_policy::memview(p_as->fu10, nblocks, nproma);
+}
+
+/*! \brief fill a structure of memory views given a structure of pointers about the atmosphere fluxes info.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_atmo_fluxes_view<memview, dext> *atmos_fluxes_view, t_atmo_fluxes *atmos_fluxes,
+                         int nblocks, int nproma) {
+    atmos_fluxes_view->stress_xw = memview_policy::memview(atmos_fluxes->stress_xw, nblocks, nproma);
+    atmos_fluxes_view->stress_yw = memview_policy::memview(atmos_fluxes->stress_yw, nblocks, nproma);
+}
+
+/*! \brief fill a structure of memory views given a structure of pointers about the ocean state info.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_ocean_state_view<memview, dext> *ocean_state_view,
+                         t_ocean_state *ocean_state, int nblocks, int nlevs, int nproma) {
+    ocean_state_view->temp = memview_policy::memview(ocean_state->temp, nblocks, nlevs, nproma);
+    ocean_state_view->salt = memview_policy::memview(ocean_state->salt, nblocks, nlevs, nproma);
+    ocean_state_view->stretch_c = memview_policy::memview(ocean_state->stretch_c, nblocks, nproma);
+    ocean_state_view->eta_c = memview_policy::memview(ocean_state->eta_c, nblocks, nproma);
+    ocean_state_view->p_vn_x1 = memview_policy::memview(ocean_state->p_vn_x1, nblocks, nlevs, nproma);
+    ocean_state_view->p_vn_x2 = memview_policy::memview(ocean_state->p_vn_x2, nblocks, nlevs, nproma);
+    ocean_state_view->p_vn_x3 = memview_policy::memview(ocean_state->p_vn_x3, nblocks, nlevs, nproma);
+}
+
+/*! \brief fill a structure of memory views given a structure of pointers about the cvmix info.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_cvmix_view<memview, dext> *p_cvmix_view, t_cvmix *p_cvmix,
+                         int nblocks, int nlevs, int nproma) {
+    p_cvmix_view->tke = memview_policy::memview(p_cvmix->tke, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_plc = memview_policy::memview(p_cvmix->tke_plc, nblocks, nlevs+1, nproma);
+    p_cvmix_view->hlc = memview_policy::memview(p_cvmix->hlc, nblocks, nproma);
+    p_cvmix_view->wlc = memview_policy::memview(p_cvmix->wlc, nblocks, nlevs+1, nproma);
+    p_cvmix_view->u_stokes = memview_policy::memview(p_cvmix->u_stokes, nblocks, nproma);
+    p_cvmix_view->a_veloc_v = memview_policy::memview(p_cvmix->a_veloc_v, nblocks, nlevs+1, nproma);
+    p_cvmix_view->a_temp_v = memview_policy::memview(p_cvmix->a_temp_v, nblocks, nlevs+1, nproma);
+    p_cvmix_view->a_salt_v = memview_policy::memview(p_cvmix->a_salt_v, nblocks, nlevs+1, nproma);
+    p_cvmix_view->iwe_Tdis = memview_policy::memview(p_cvmix->iwe_Tdis, nblocks, nlevs+1, nproma);
+    p_cvmix_view->cvmix_dummy_1 = memview_policy::memview(p_cvmix->cvmix_dummy_1, nblocks, nlevs+1, nproma);
+    p_cvmix_view->cvmix_dummy_2 = memview_policy::memview(p_cvmix->cvmix_dummy_2, nblocks, nlevs+1, nproma);
+    p_cvmix_view->cvmix_dummy_3 = memview_policy::memview(p_cvmix->cvmix_dummy_3, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Tbpr = memview_policy::memview(p_cvmix->tke_Tbpr, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Tspr = memview_policy::memview(p_cvmix->tke_Tspr, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Tdif = memview_policy::memview(p_cvmix->tke_Tdif, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Tdis = memview_policy::memview(p_cvmix->tke_Tdis, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Twin = memview_policy::memview(p_cvmix->tke_Twin, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Tiwf = memview_policy::memview(p_cvmix->tke_Tiwf, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Tbck = memview_policy::memview(p_cvmix->tke_Tbck, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Ttot = memview_policy::memview(p_cvmix->tke_Ttot, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Lmix = memview_policy::memview(p_cvmix->tke_Lmix, nblocks, nlevs+1, nproma);
+    p_cvmix_view->tke_Pr = memview_policy::memview(p_cvmix->tke_Pr, nblocks, nlevs+1, nproma);
+}
+
+/*! \brief fill a structure of memory views given a structure of pointers about the vertical stability.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_vertical_stability_view<memview, dext> *p_stability_view,
+                         t_vertical_stability *p_stability, int nblocks, int nlevs, int nproma) {
+    p_stability_view->Nsqr = memview_policy::memview(p_stability->Nsqr, nblocks, nlevs+1, nproma);
+    p_stability_view->Ssqr = memview_policy::memview(p_stability->Ssqr, nblocks, nlevs+1, nproma);
+}
+
+/*! \brief fill a structure of memory views given a structure of pointers about the IDEMIX state and forcing.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_idemix_view<memview, dext> *p_idemix_view,
+                         t_idemix *p_idemix, int nblocks, int nlevs, int nproma) {
+    p_idemix_view->iwe = memview_policy::memview(p_idemix->iwe, nblocks, nlevs+1, nproma);
+    p_idemix_view->forc_iw_surface = memview_policy::memview(p_idemix->forc_iw_surface, nblocks, nproma);
+    p_idemix_view->forc_iw_bottom = memview_policy::memview(p_idemix->forc_iw_bottom, nblocks, nproma);
+}
+
+/*! \brief fill a structure of memory views given a structure of pointers about the horizontal grid info.
+*
+*   It is templated with a memview class and a dext class which define the memory view implementation
+*   and with a memview_policy which defines how to allocate and deallocate memory in the actual backend
+*   and how to create a memory view object.
+*/
+template <template <class ...> class memview,
+          template <class, size_t> class dext,
+          class memview_policy>
+void fill_struct_memview(t_horizontal_grid_view<memview, dext> *p_grid_view,
+                         t_horizontal_grid *p_grid, int nblocks, int nproma) {
+    p_grid_view->f_c = memview_policy::memview(p_grid->f_c, nblocks, nproma);
+    p_grid_view->cells_area = memview_policy::memview(p_grid->cells_area, nblocks, nproma);
+    p_grid_view->cells_edge_idx = memview_policy::memview(p_grid->cells_edge_idx, 3, nblocks, nproma);
+    p_grid_view->cells_edge_blk = memview_policy::memview(p_grid->cells_edge_blk, 3, nblocks, nproma);
+    p_grid_view->cells_edge_orientation = memview_policy::memview(p_grid->cells_edge_orientation,
+                                                                  3, nblocks, nproma);
+    p_grid_view->edges_primal_edge_length = memview_policy::memview(p_grid->edges_primal_edge_length,
+                                                                    nblocks, nproma);
+    p_grid_view->edges_dual_edge_length = memview_policy::memview(p_grid->edges_dual_edge_length,
+                                                                  nblocks, nproma);
+}
+
+#endif  // SRC_BACKENDS_MEMVIEW_FILL_HPP_
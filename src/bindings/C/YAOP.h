@@ -21,16 +21,65 @@
 extern "C" {
 #endif
 
+// Opaque handle to a YAOP instance
+typedef struct YAOP_Handle YAOP_Handle;
+
+// Number of stages of the timing report: view_init, pre_integration, nsqr_ssqr, mixing_length,
+// diffusivity, forcing, tridiag_build, solve, diagnostics, edges, idemix
+#define YAOP_TIMING_NSTAGES 11
+
+// Number of hardware counters of the timing report: cycles, instructions, cache_misses, fp_scalar, fp_vector
+#define YAOP_PERF_NCOUNTERS 5
+
+// Solvers of the tridiagonal system of tke (same values as t_tridiag_solver)
+#define YAOP_TRIDIAG_THOMAS 0
+#define YAOP_TRIDIAG_PCR 1
+
+// Stage timers accumulated since the construction or the last reset (same layout as t_timing_report)
+typedef struct YAOP_Timing_data {
+    int enabled;
+    int counters_enabled;
+    long long ncalls;
+    double total_seconds;
+    double seconds[YAOP_TIMING_NSTAGES];
+    long long count[YAOP_TIMING_NSTAGES];
+    long long counters[YAOP_TIMING_NSTAGES][YAOP_PERF_NCOUNTERS];
+} YAOP_Timing_data;
+
+// Memory allocated by YAOP (current and peak) and memory of the fields bound by the model
+typedef struct YAOP_Memory_data {
+    long long internal_bytes;
+    long long peak_bytes;
+    long long registered_bytes;
+    int ninternal_fields;
+    int nregistered_fields;
+} YAOP_Memory_data;
+
+// Columns skipped in the last call by the quiescent columns mode (same layout as t_quiescence_report)
+typedef struct YAOP_Quiescence_data {
+    int enabled;
+    int nblocks_skipped;
+    long long ncolumns;
+    long long nquiescent;
+    double max_error_bound;
+} YAOP_Quiescence_data;
+
 // Constructor
-void YAOP_Init(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemix_tke,
+YAOP_Handle *YAOP_Init(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemix_tke,
               int vert_cor_type, double dtime, double OceanReferenceDensity, double grav,
               int l_lc, double clc, double ReferencePressureIndbars, double pi);
 
 // Destructor
-void YAOP_Finalize();
+void YAOP_Finalize(YAOP_Handle *handle);
 
-// Calculation
-void YAOP_Calc_tke(double *depth_CellInterface, double *prism_center_dist_c,
+// Numerical settings of the tke scheme, the int ones return 0 and keep the previous setting for invalid values
+int YAOP_Set_quiescence(YAOP_Handle *handle, double threshold, int refresh);
+void YAOP_Set_fuse_edges(YAOP_Handle *handle, int fuse_edges);
+int YAOP_Set_tridiag_solver(YAOP_Handle *handle, int solver);
+int YAOP_Set_tke_mxl_choice(YAOP_Handle *handle, int choice);
+
+// Calculation, with l_lc hlc_in, u_stokes_in, wlc_in and tke_plc_in are written by the library
+void YAOP_Calc_tke(YAOP_Handle *handle, double *depth_CellInterface, double *prism_center_dist_c,
               double *inv_prism_center_dist_c, double *prism_thick_c,
               int *dolic_c, int *dolic_e, double *zlev_i, double *wet_c,
               int *edges_cell_idx, int *edges_cell_blk,
@@ -49,11 +98,77 @@ void YAOP_Calc_tke(double *depth_CellInterface, double *prism_center_dist_c,
               int cells_start_block, int cells_end_block, int cells_start_index,
               int cells_end_index);
 
-void YAOP_Calc_vertical_stability();
+// Fields registration (C order shape, strides in elements or NULL if contiguous)
+void YAOP_Register_field_double(YAOP_Handle *handle, const char *name, double *data, int ndims,
+                                const int *shape, const int *strides);
+
+void YAOP_Register_field_int(YAOP_Handle *handle, const char *name, int *data, int ndims,
+                             const int *shape, const int *strides);
+
+// Calculation on the registered fields
+void YAOP_Step(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+               int edges_start_index, int edges_end_index, int cells_block_size,
+               int cells_start_block, int cells_end_block, int cells_start_index,
+               int cells_end_index);
+
+// Calculation on the registered fields with nsubsteps tke steps of dtime / nsubsteps, 0 if they are not positive
+int YAOP_Step_substeps(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+                       int edges_start_index, int edges_end_index, int cells_block_size,
+                       int cells_start_block, int cells_end_block, int cells_start_index,
+                       int cells_end_index, int nsubsteps, double dtime);
+
+// Fields binding
+void YAOP_Rebind_field_double(YAOP_Handle *handle, const char *name, double *data);
+
+void YAOP_Rebind_field_int(YAOP_Handle *handle, const char *name, int *data);
+
+int YAOP_Save_buffer_set(YAOP_Handle *handle);
+
+void YAOP_Select_buffer_set(YAOP_Handle *handle, int id);
+
+// Calculation on an ensemble of saved buffer sets sharing the grid info
+void YAOP_Step_ensemble(YAOP_Handle *handle, int nmembers, const int *set_ids,
+                        int edges_block_size, int edges_start_block, int edges_end_block,
+                        int edges_start_index, int edges_end_index, int cells_block_size,
+                        int cells_start_block, int cells_end_block, int cells_start_index,
+                        int cells_end_index);
+
+// Stage timers
+void YAOP_Timing_report(YAOP_Handle *handle, YAOP_Timing_data *report);
+void YAOP_Reset_timing(YAOP_Handle *handle);
+const char *YAOP_Timing_stage_name(int stage);
+const char *YAOP_Perf_counter_name(int counter);
+// Execution timeline as Chrome trace JSON
+void YAOP_Dump_trace(YAOP_Handle *handle, const char *filename);
+// Quiescent columns report of the last call
+void YAOP_Quiescence_report(YAOP_Handle *handle, YAOP_Quiescence_data *report);
+// Memory report, the fields are queried by index (registered = 0 for the internal ones, 1 for the bound ones)
+void YAOP_Memory_report(YAOP_Handle *handle, YAOP_Memory_data *report);
+const char *YAOP_Memory_field(YAOP_Handle *handle, int registered, int index, long long *bytes);
+// Snapshot of the inputs of a step (counted from 1), to be re-run with yaop_replay
+void YAOP_Capture(YAOP_Handle *handle, int call, const char *filename);
+// Vertical stability shared by the mixing schemes called afterwards with the same cells range
+void YAOP_Calc_vertical_stability(YAOP_Handle *handle, int edges_block_size, int edges_start_block,
+                                  int edges_end_block, int edges_start_index, int edges_end_index,
+                                  int cells_block_size, int cells_start_block, int cells_end_block,
+                                  int cells_start_index, int cells_end_index);
 
-void YAOP_Calc_pp();
+// Pacanowski-Philander scheme on the bound fields
+void YAOP_Calc_pp(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+                  int edges_start_index, int edges_end_index, int cells_block_size,
+                  int cells_start_block, int cells_end_block, int cells_start_index,
+                  int cells_end_index);
 
-void YAOP_Calc_idemix();
+// IDEMIX scheme on the bound fields, the dissipation is written to iwe_Tdis
+void YAOP_Calc_idemix(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+                      int edges_start_index, int edges_end_index, int cells_block_size,
+                      int cells_start_block, int cells_end_block, int cells_start_index,
+                      int cells_end_index);
+// IDEMIX coupled with the tke scheme on the bound fields, block by block
+void YAOP_Step_idemix_tke(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+                          int edges_start_index, int edges_end_index, int cells_block_size,
+                          int cells_start_block, int cells_end_block, int cells_start_index,
+                          int cells_end_index);
 
 #ifdef __cplusplus
 }
@@ -14,39 +14,75 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <memory>
+#include <cstring>
+#include <vector>
 extern "C" {
 #include "src/bindings/C/YAOP.h"
 }
 #include "src/YAOP.hpp"
 
-static std::unique_ptr<YAOP> impl = nullptr;
+// The opaque handle is the YAOP object itself
+static YAOP *get_impl(YAOP_Handle *handle) {
+    return reinterpret_cast<YAOP *>(handle);
+}
 
 /*! \brief YAOP library initialization.
 *
-*   It creates a unique pointer to a YAOP object, which is calling the YAOP constructor.
+*   It creates a YAOP object, which is calling the YAOP constructor, and returns an opaque
+*   handle to it. Several handles can be used concurrently in the same process.
 */
-void YAOP_Init(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemix_tke,
+YAOP_Handle *YAOP_Init(int nproma, int nlevs, int nblocks, int vert_mix_type, int vmix_idemix_tke,
               int vert_cor_type, double dtime, double OceanReferenceDensity, double grav,
               int l_lc, double clc, double ReferencePressureIndbars, double pi) {
-    impl.reset(new YAOP(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke,
-                       vert_cor_type, dtime, OceanReferenceDensity, grav,
-                       l_lc, clc, ReferencePressureIndbars, pi));
+    YAOP *impl = new YAOP(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke,
+                          vert_cor_type, dtime, OceanReferenceDensity, grav,
+                          l_lc, clc, ReferencePressureIndbars, pi);
+    return reinterpret_cast<YAOP_Handle *>(impl);
 }
 
 /*! \brief YAOP library finalization.
 *
-*   It reset the pointer to a YAOP object so that the YAOP destructor is called.
+*   It deletes the YAOP object associated to the handle so that the YAOP destructor is called.
+*/
+void YAOP_Finalize(YAOP_Handle *handle) {
+    delete get_impl(handle);
+}
+
+/*! \brief Quiescent columns mode of the tke scheme, 1 if the setting is applied.
+*
+*/
+int YAOP_Set_quiescence(YAOP_Handle *handle, double threshold, int refresh) {
+    return get_impl(handle)->set_quiescence(threshold, refresh) ? 1 : 0;
+}
+
+/*! \brief Compute the edges inside a cell block right after the block.
+*
+*/
+void YAOP_Set_fuse_edges(YAOP_Handle *handle, int fuse_edges) {
+    get_impl(handle)->set_fuse_edges(fuse_edges != 0);
+}
+
+/*! \brief Solver of the tridiagonal system of tke, 1 if the solver is applied.
+*
 */
-void YAOP_Finalize() {
-    impl.reset();
+int YAOP_Set_tridiag_solver(YAOP_Handle *handle, int solver) {
+    static_assert(YAOP_TRIDIAG_THOMAS == tridiag_thomas && YAOP_TRIDIAG_PCR == tridiag_pcr,
+                  "YAOP_TRIDIAG_* and t_tridiag_solver must have the same values");
+    return get_impl(handle)->set_tridiag_solver(solver) ? 1 : 0;
+}
+
+/*! \brief Bound of the mixing length of tke (2 or 3), 1 if the choice is applied.
+*
+*/
+int YAOP_Set_tke_mxl_choice(YAOP_Handle *handle, int choice) {
+    return get_impl(handle)->set_tke_mxl_choice(choice) ? 1 : 0;
 }
 
 /*! \brief YAOP time loop calculation.
 *
 *   It calls the calc method of the tke backend class.
 */
-void YAOP_Calc_tke(double *depth_CellInterface, double *prism_center_dist_c,
+void YAOP_Calc_tke(YAOP_Handle *handle, double *depth_CellInterface, double *prism_center_dist_c,
                    double *inv_prism_center_dist_c, double *prism_thick_c,
                    int *dolic_c, int *dolic_e, double *zlev_i, double *wet_c,
                    int *edges_cell_idx, int *edges_cell_blk,
@@ -64,7 +100,7 @@ void YAOP_Calc_tke(double *depth_CellInterface, double *prism_center_dist_c,
                    int edges_start_index, int edges_end_index, int cells_block_size,
                    int cells_start_block, int cells_end_block, int cells_start_index,
                    int cells_end_index) {
-    impl->calc_tke(depth_CellInterface, prism_center_dist_c,
+    get_impl(handle)->calc_tke(depth_CellInterface, prism_center_dist_c,
                    inv_prism_center_dist_c, prism_thick_c,
                    dolic_c, dolic_e, zlev_i, wet_c,
                    edges_cell_idx, edges_cell_blk,
@@ -84,8 +120,231 @@ void YAOP_Calc_tke(double *depth_CellInterface, double *prism_center_dist_c,
                    cells_end_index);
 }
 
-void YAOP_Calc_vertical_stability() {}
+/*! \brief YAOP time loop calculation on the registered fields.
+*
+*   It calls the step method of the YAOP object.
+*/
+void YAOP_Step(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+               int edges_start_index, int edges_end_index, int cells_block_size,
+               int cells_start_block, int cells_end_block, int cells_start_index,
+               int cells_end_index) {
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    get_impl(handle)->step(range);
+}
+
+/*! \brief YAOP time loop calculation with substeps on the registered fields.
+*
+*   It calls the step method of the YAOP object with the substeps and the time step of the call,
+*   and returns 0 if they are not positive.
+*/
+int YAOP_Step_substeps(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+                       int edges_start_index, int edges_end_index, int cells_block_size,
+                       int cells_start_block, int cells_end_block, int cells_start_index,
+                       int cells_end_index, int nsubsteps, double dtime) {
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    return get_impl(handle)->step(range, nsubsteps, dtime) ? 1 : 0;
+}
+
+/*! \brief Register a double precision field given its shape and strides (C order).
+*
+*   The strides can be NULL for contiguous memory.
+*/
+void YAOP_Register_field_double(YAOP_Handle *handle, const char *name, double *data, int ndims,
+                                const int *shape, const int *strides) {
+    get_impl(handle)->register_field(name, data, ndims, shape, strides);
+}
+
+/*! \brief Register an integer field given its shape and strides (C order).
+*
+*   The strides can be NULL for contiguous memory.
+*/
+void YAOP_Register_field_int(YAOP_Handle *handle, const char *name, int *data, int ndims,
+                             const int *shape, const int *strides) {
+    get_impl(handle)->register_field(name, data, ndims, shape, strides);
+}
+
+/*! \brief Rebind a double precision field to a new memory location.
+*
+*/
+void YAOP_Rebind_field_double(YAOP_Handle *handle, const char *name, double *data) {
+    get_impl(handle)->rebind_field(name, data);
+}
+
+/*! \brief Rebind an integer field to a new memory location.
+*
+*/
+void YAOP_Rebind_field_int(YAOP_Handle *handle, const char *name, int *data) {
+    get_impl(handle)->rebind_field(name, data);
+}
+
+/*! \brief Save the currently bound fields as a buffer set and return its id.
+*
+*/
+int YAOP_Save_buffer_set(YAOP_Handle *handle) {
+    return get_impl(handle)->save_buffer_set();
+}
+
+/*! \brief Bind the fields of a previously saved buffer set.
+*
+*/
+void YAOP_Select_buffer_set(YAOP_Handle *handle, int id) {
+    get_impl(handle)->select_buffer_set(id);
+}
+
+/*! \brief Calculation of an ensemble of saved buffer sets sharing the grid info.
+*
+*/
+void YAOP_Step_ensemble(YAOP_Handle *handle, int nmembers, const int *set_ids,
+                        int edges_block_size, int edges_start_block, int edges_end_block,
+                        int edges_start_index, int edges_end_index, int cells_block_size,
+                        int cells_start_block, int cells_end_block, int cells_start_index,
+                        int cells_end_index) {
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    get_impl(handle)->step_ensemble(nmembers, set_ids, range);
+}
+
+/*! \brief Copy the stage timers of the tke scheme in report.
+*
+*/
+void YAOP_Timing_report(YAOP_Handle *handle, YAOP_Timing_data *report) {
+    static_assert(sizeof(YAOP_Timing_data) == sizeof(t_timing_report) && YAOP_TIMING_NSTAGES == timing_nstages &&
+                  YAOP_PERF_NCOUNTERS == perf_ncounters,
+                  "YAOP_Timing_data and t_timing_report must have the same layout");
+    t_timing_report timing = get_impl(handle)->timing_report();
+    std::memcpy(report, &timing, sizeof(t_timing_report));
+}
+
+/*! \brief Copy the quiescent columns report of the last call in report.
+*
+*/
+void YAOP_Quiescence_report(YAOP_Handle *handle, YAOP_Quiescence_data *report) {
+    static_assert(sizeof(YAOP_Quiescence_data) == sizeof(t_quiescence_report),
+                  "YAOP_Quiescence_data and t_quiescence_report must have the same layout");
+    t_quiescence_report quiescence = get_impl(handle)->quiescence_report();
+    std::memcpy(report, &quiescence, sizeof(t_quiescence_report));
+}
+
+/*! \brief Reset the stage timers of the tke scheme.
+*
+*/
+void YAOP_Reset_timing(YAOP_Handle *handle) {
+    get_impl(handle)->reset_timing();
+}
+
+/*! \brief Name of a stage of the timing report.
+*
+*/
+const char *YAOP_Timing_stage_name(int stage) {
+    return YAOP::timing_stage_name(stage);
+}
 
-void YAOP_Calc_pp() {}
+/*! \brief Name of a hardware counter of the timing report.
+*
+*/
+const char *YAOP_Perf_counter_name(int counter) {
+    return YAOP::perf_counter_name(counter);
+}
 
-void YAOP_Calc_idemix() {}
+/*! \brief Write the execution timeline as Chrome trace JSON.
+*
+*/
+void YAOP_Dump_trace(YAOP_Handle *handle, const char *filename) {
+    get_impl(handle)->dump_trace(filename);
+}
+
+/*! \brief Totals of the memory report.
+*
+*/
+void YAOP_Memory_report(YAOP_Handle *handle, YAOP_Memory_data *report) {
+    t_memory_report memory = get_impl(handle)->memory_report();
+    report->internal_bytes = static_cast<long long>(memory.internal_bytes);
+    report->peak_bytes = static_cast<long long>(memory.peak_bytes);
+    report->registered_bytes = static_cast<long long>(memory.registered_bytes);
+    report->ninternal_fields = static_cast<int>(memory.internal_fields.size());
+    report->nregistered_fields = static_cast<int>(memory.registered_fields.size());
+}
+
+/*! \brief Name and bytes of a field of the memory report, NULL if index is out of range.
+*
+*   The name is valid as long as the handle.
+*/
+const char *YAOP_Memory_field(YAOP_Handle *handle, int registered, int index, long long *bytes) {
+    t_memory_report memory = get_impl(handle)->memory_report();
+    const std::vector<t_memory_field> &fields = registered ? memory.registered_fields : memory.internal_fields;
+    if (index < 0 || index >= static_cast<int>(fields.size()))
+        return nullptr;
+    *bytes = static_cast<long long>(fields[index].bytes);
+    return fields[index].name;
+}
+
+/*! \brief Capture the inputs of a time step to a binary snapshot.
+*
+*/
+void YAOP_Capture(YAOP_Handle *handle, int call, const char *filename) {
+    get_impl(handle)->capture(call, filename);
+}
+
+/*! \brief Vertical stability of the cells range, shared by the mixing schemes of the time step.
+*
+*/
+void YAOP_Calc_vertical_stability(YAOP_Handle *handle, int edges_block_size, int edges_start_block,
+                                  int edges_end_block, int edges_start_index, int edges_end_index,
+                                  int cells_block_size, int cells_start_block, int cells_end_block,
+                                  int cells_start_index, int cells_end_index) {
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    get_impl(handle)->calc_vertical_stability(range);
+}
+
+/*! \brief Pacanowski-Philander scheme on the bound fields.
+*
+*/
+void YAOP_Calc_pp(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+                  int edges_start_index, int edges_end_index, int cells_block_size,
+                  int cells_start_block, int cells_end_block, int cells_start_index,
+                  int cells_end_index) {
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    get_impl(handle)->calc_pp(range);
+}
+
+/*! \brief IDEMIX scheme on the bound fields, iwe_Tdis forces a tke step called afterwards.
+*
+*/
+void YAOP_Calc_idemix(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+                      int edges_start_index, int edges_end_index, int cells_block_size,
+                      int cells_start_block, int cells_end_block, int cells_start_index,
+                      int cells_end_index) {
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    get_impl(handle)->calc_idemix(range);
+}
+
+/*! \brief IDEMIX coupled with the tke scheme on the bound fields, block by block in one call.
+*
+*/
+void YAOP_Step_idemix_tke(YAOP_Handle *handle, int edges_block_size, int edges_start_block, int edges_end_block,
+                          int edges_start_index, int edges_end_index, int cells_block_size,
+                          int cells_start_block, int cells_end_block, int cells_start_index,
+                          int cells_end_index) {
+    t_index_range range = {edges_block_size, edges_start_block, edges_end_block,
+                           edges_start_index, edges_end_index, cells_block_size,
+                           cells_start_block, cells_end_block, cells_start_index,
+                           cells_end_index};
+    get_impl(handle)->step_idemix_tke(range);
+}
@@ -22,22 +22,162 @@ module mod_YAOP
     integer, parameter :: rd = 307
     integer, parameter :: dp = selected_real_kind(pd,rd)
 
+    !> Opaque handle to a YAOP instance
+    type, public :: t_yaop
+        type(c_ptr) :: handle = c_null_ptr
+    end type t_yaop
+
+    !> Number of stages of the timing report
+    integer, parameter, public :: yaop_timing_nstages = 11
+
+    !> Names of the stages of the timing report
+    character(len=15), parameter, public :: yaop_timing_stage_names(yaop_timing_nstages) = &
+        [character(len=15) :: "view_init", "pre_integration", "nsqr_ssqr", "mixing_length", &
+                              "diffusivity", "forcing", "tridiag_build", "solve", "diagnostics", "edges", &
+                              "idemix"]
+
+    !> Solvers of the tridiagonal system of tke (same values as YAOP_TRIDIAG_THOMAS and YAOP_TRIDIAG_PCR)
+    integer, parameter, public :: yaop_tridiag_thomas = 0
+    integer, parameter, public :: yaop_tridiag_pcr = 1
+
+    !> Number of hardware counters of the timing report
+    integer, parameter, public :: yaop_perf_ncounters = 5
+
+    !> Names of the hardware counters of the timing report
+    character(len=12), parameter, public :: yaop_perf_counter_names(yaop_perf_ncounters) = &
+        [character(len=12) :: "cycles", "instructions", "cache_misses", "fp_scalar", "fp_vector"]
+
+    !> Stage timers accumulated since the construction or the last reset (same layout as YAOP_Timing_data)
+    type, bind(C), public :: t_yaop_timing_report
+        integer(c_int)       :: enabled
+        integer(c_int)       :: counters_enabled
+        integer(c_long_long) :: ncalls
+        real(c_double)       :: total_seconds
+        real(c_double)       :: seconds(yaop_timing_nstages)
+        integer(c_long_long) :: count(yaop_timing_nstages)
+        integer(c_long_long) :: counters(yaop_perf_ncounters, yaop_timing_nstages)
+    end type t_yaop_timing_report
+
+    !> Memory allocated by YAOP and memory of the bound fields (same layout as YAOP_Memory_data)
+    type, bind(C), public :: t_yaop_memory_report
+        integer(c_long_long) :: internal_bytes
+        integer(c_long_long) :: peak_bytes
+        integer(c_long_long) :: registered_bytes
+        integer(c_int)       :: ninternal_fields
+        integer(c_int)       :: nregistered_fields
+    end type t_yaop_memory_report
+
+    !> Columns skipped in the last call by the quiescent columns mode (same layout as YAOP_Quiescence_data)
+    type, bind(C), public :: t_yaop_quiescence_report
+        integer(c_int)       :: enabled
+        integer(c_int)       :: nblocks_skipped
+        integer(c_long_long) :: ncolumns
+        integer(c_long_long) :: nquiescent
+        real(c_double)       :: max_error_bound
+    end type t_yaop_quiescence_report
+
     public :: yaop_init_f
     public :: yaop_finalize_f
+    public :: yaop_set_quiescence_f
+    public :: yaop_set_fuse_edges_f
+    public :: yaop_set_tridiag_solver_f
+    public :: yaop_set_tke_mxl_choice_f
     public :: yaop_calc_tke_f
+    public :: yaop_register_field_f
+    public :: yaop_step_f
+    public :: yaop_step_substeps_f
+    public :: yaop_rebind_field_f
+    public :: yaop_save_buffer_set_f
+    public :: yaop_select_buffer_set_f
+    public :: yaop_step_ensemble_f
+    public :: yaop_timing_report_f
+    public :: yaop_reset_timing_f
+    public :: yaop_dump_trace_f
+    public :: yaop_quiescence_report_f
+    public :: yaop_memory_report_f
+    public :: yaop_memory_field_f
+    public :: yaop_capture_f
     public :: yaop_calc_vertical_stability_f
     public :: yaop_calc_pp_f
     public :: yaop_calc_idemix_f
+    public :: yaop_step_idemix_tke_f
+
+    !> Register a field, given its name, with its shape.
+    !!
+    !! The shape is reversed to the C order and only contiguous arrays are accepted.
+    interface yaop_register_field_f
+        module procedure yaop_register_field_double_1d_f
+        module procedure yaop_register_field_double_2d_f
+        module procedure yaop_register_field_double_3d_f
+        module procedure yaop_register_field_int_2d_f
+        module procedure yaop_register_field_int_3d_f
+    end interface yaop_register_field_f
+
+    !> Rebind a field, given its name, to a new memory location.
+    interface yaop_rebind_field_f
+        module procedure yaop_rebind_field_double_1d_f
+        module procedure yaop_rebind_field_double_2d_f
+        module procedure yaop_rebind_field_double_3d_f
+        module procedure yaop_rebind_field_int_2d_f
+        module procedure yaop_rebind_field_int_3d_f
+    end interface yaop_rebind_field_f
+
+    interface
+        subroutine yaop_register_field_double_c(handle, name, data, ndims, shape, strides) &
+                                                bind(C, name="YAOP_Register_field_double")
+            use iso_c_binding
+            implicit none
+
+            type(c_ptr), value                   :: handle
+            character(kind=c_char), dimension(*) :: name
+            type(c_ptr), value                   :: data
+            integer(c_int), value                :: ndims
+            integer(c_int), dimension(*)         :: shape
+            type(c_ptr), value                   :: strides
+        end subroutine yaop_register_field_double_c
+
+        subroutine yaop_register_field_int_c(handle, name, data, ndims, shape, strides) &
+                                             bind(C, name="YAOP_Register_field_int")
+            use iso_c_binding
+            implicit none
+
+            type(c_ptr), value                   :: handle
+            character(kind=c_char), dimension(*) :: name
+            type(c_ptr), value                   :: data
+            integer(c_int), value                :: ndims
+            integer(c_int), dimension(*)         :: shape
+            type(c_ptr), value                   :: strides
+        end subroutine yaop_register_field_int_c
+
+        subroutine yaop_rebind_field_double_c(handle, name, data) bind(C, name="YAOP_Rebind_field_double")
+            use iso_c_binding
+            implicit none
+
+            type(c_ptr), value                   :: handle
+            character(kind=c_char), dimension(*) :: name
+            type(c_ptr), value                   :: data
+        end subroutine yaop_rebind_field_double_c
+
+        subroutine yaop_rebind_field_int_c(handle, name, data) bind(C, name="YAOP_Rebind_field_int")
+            use iso_c_binding
+            implicit none
+
+            type(c_ptr), value                   :: handle
+            character(kind=c_char), dimension(*) :: name
+            type(c_ptr), value                   :: data
+        end subroutine yaop_rebind_field_int_c
+    end interface
 
     contains
 
     !> YAOP initialization.
     !!
     !! It calls the YAOP_Init C function.
-    subroutine yaop_init_f(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, &
+    subroutine yaop_init_f(yaop, nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, &
                           vert_cor_type, dtime, OceanReferenceDensity, grav, &
                           l_lc, clc, ReferencePressureIndbars, pi)
         implicit none
+        type(t_yaop), intent(inout) :: yaop
         integer, intent(in)  :: nproma
         integer, intent(in)  :: nlevs
         integer, intent(in)  :: nblocks
@@ -53,9 +193,9 @@ module mod_YAOP
         real(dp), intent(in) :: pi
 
         interface
-            subroutine yaop_init_c(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, &
-                                  vert_cor_type, dtime, OceanReferenceDensity, grav, &
-                                  l_lc, clc, ReferencePressureIndbars, pi) bind(C, name="YAOP_Init")
+            function yaop_init_c(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, &
+                                 vert_cor_type, dtime, OceanReferenceDensity, grav, &
+                                 l_lc, clc, ReferencePressureIndbars, pi) bind(C, name="YAOP_Init")
                 use iso_c_binding
                 implicit none
 
@@ -72,35 +212,131 @@ module mod_YAOP
                 real(c_double), value :: clc
                 real(c_double), value :: ReferencePressureIndbars
                 real(c_double), value :: pi
-            end subroutine yaop_init_c
+                type(c_ptr)           :: yaop_init_c
+            end function yaop_init_c
         end interface
 
-        CALL yaop_init_c(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, &
-                        vert_cor_type, dtime, OceanReferenceDensity, grav, &
-                        l_lc, clc, ReferencePressureIndbars, pi)
+        yaop%handle = yaop_init_c(nproma, nlevs, nblocks, vert_mix_type, vmix_idemix_tke, &
+                                  vert_cor_type, dtime, OceanReferenceDensity, grav, &
+                                  l_lc, clc, ReferencePressureIndbars, pi)
     end subroutine yaop_init_f
 
     !> YAOP finalization.
     !!
     !! It calls the YAOP_Finalize C function.
-    subroutine yaop_finalize_f()
+    subroutine yaop_finalize_f(yaop)
         implicit none
+        type(t_yaop), intent(inout) :: yaop
 
         interface
-            subroutine yaop_finalize_c() bind(C, name="YAOP_Finalize")
+            subroutine yaop_finalize_c(handle) bind(C, name="YAOP_Finalize")
                 use iso_c_binding
                 implicit none
 
+                type(c_ptr), value :: handle
             end subroutine yaop_finalize_c
         end interface
 
-        CALL yaop_finalize_c()
+        CALL yaop_finalize_c(yaop%handle)
+        yaop%handle = c_null_ptr
     end subroutine yaop_finalize_f
 
+    !> Quiescent columns mode of the tke scheme (threshold 0 computes all the columns).
+    !!
+    !! It calls the YAOP_Set_quiescence C function and returns false if the setting is not applied.
+    function yaop_set_quiescence_f(yaop, threshold, refresh) result(is_set)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        real(dp), intent(in) :: threshold
+        integer, intent(in) :: refresh
+        logical :: is_set
+
+        interface
+            function yaop_set_quiescence_c(handle, threshold_c, refresh_c) bind(C, name="YAOP_Set_quiescence")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                real(c_double), value :: threshold_c
+                integer(c_int), value :: refresh_c
+                integer(c_int)        :: yaop_set_quiescence_c
+            end function yaop_set_quiescence_c
+        end interface
+
+        is_set = yaop_set_quiescence_c(yaop%handle, threshold, refresh) /= 0
+    end function yaop_set_quiescence_f
+
+    !> Compute the edges with both neighbours in the same cell block right after the block.
+    !!
+    !! It calls the YAOP_Set_fuse_edges C function.
+    subroutine yaop_set_fuse_edges_f(yaop, fuse_edges)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        logical, intent(in) :: fuse_edges
+
+        interface
+            subroutine yaop_set_fuse_edges_c(handle, fuse_edges_c) bind(C, name="YAOP_Set_fuse_edges")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: fuse_edges_c
+            end subroutine yaop_set_fuse_edges_c
+        end interface
+
+        CALL yaop_set_fuse_edges_c(yaop%handle, merge(1, 0, fuse_edges))
+    end subroutine yaop_set_fuse_edges_f
+
+    !> Solver of the tridiagonal system of tke (yaop_tridiag_thomas or yaop_tridiag_pcr).
+    !!
+    !! It calls the YAOP_Set_tridiag_solver C function and returns false if the solver is not applied.
+    function yaop_set_tridiag_solver_f(yaop, solver) result(is_set)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: solver
+        logical :: is_set
+
+        interface
+            function yaop_set_tridiag_solver_c(handle, solver_c) bind(C, name="YAOP_Set_tridiag_solver")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: solver_c
+                integer(c_int)        :: yaop_set_tridiag_solver_c
+            end function yaop_set_tridiag_solver_c
+        end interface
+
+        is_set = yaop_set_tridiag_solver_c(yaop%handle, solver) /= 0
+    end function yaop_set_tridiag_solver_f
+
+    !> Bound of the mixing length of tke (tke_mxl_choice 2 or 3).
+    !!
+    !! It calls the YAOP_Set_tke_mxl_choice C function and returns false if the choice is not applied.
+    function yaop_set_tke_mxl_choice_f(yaop, choice) result(is_set)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: choice
+        logical :: is_set
+
+        interface
+            function yaop_set_tke_mxl_choice_c(handle, choice_c) bind(C, name="YAOP_Set_tke_mxl_choice")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: choice_c
+                integer(c_int)        :: yaop_set_tke_mxl_choice_c
+            end function yaop_set_tke_mxl_choice_c
+        end interface
+
+        is_set = yaop_set_tke_mxl_choice_c(yaop%handle, choice) /= 0
+    end function yaop_set_tke_mxl_choice_f
+
     !> YAOP time loop calculation.
     !!
     !! It calls the YAOP_Calc_tke C function.
-    subroutine yaop_calc_tke_f(depth_CellInterface, prism_center_dist_c, &
+    subroutine yaop_calc_tke_f(yaop, depth_CellInterface, prism_center_dist_c, &
                                inv_prism_center_dist_c, prism_thick_c, &
                                dolic_c, dolic_e, zlev_i, wet_c, &
                                edges_cell_idx, edges_cell_blk, &
@@ -121,7 +357,7 @@ module mod_YAOP
 
         implicit none
 
-
+        type(t_yaop), intent(in)               :: yaop
         real(c_double), intent(in),    TARGET :: depth_CellInterface(:,:,:)
         real(c_double), intent(in),    TARGET :: prism_center_dist_c(:,:,:)
         real(c_double), intent(in),    TARGET :: inv_prism_center_dist_c(:,:,:)
@@ -140,10 +376,10 @@ module mod_YAOP
         real(c_double), intent(in),    TARGET :: p_vn_x2(:,:,:)
         real(c_double), intent(in),    TARGET :: p_vn_x3(:,:,:)
         real(c_double), intent(inout), TARGET :: tke(:,:,:)
-        real(c_double), intent(in),    TARGET :: tke_plc_in(:,:,:)
-        real(c_double), intent(in),    TARGET :: hlc_in(:,:)
-        real(c_double), intent(in),    TARGET :: wlc_in(:,:,:)
-        real(c_double), intent(in),    TARGET :: u_stokes_in(:,:)
+        real(c_double), intent(inout), TARGET :: tke_plc_in(:,:,:)
+        real(c_double), intent(inout), TARGET :: hlc_in(:,:)
+        real(c_double), intent(inout), TARGET :: wlc_in(:,:,:)
+        real(c_double), intent(inout), TARGET :: u_stokes_in(:,:)
         real(c_double), intent(inout), TARGET :: a_veloc_v(:,:,:)
         real(c_double), intent(inout), TARGET :: a_temp_v(:,:,:)
         real(c_double), intent(inout), TARGET :: a_salt_v(:,:,:)
@@ -192,7 +428,7 @@ module mod_YAOP
                        stress_yw_ptr, fu10_ptr, concsum_ptr
 
         interface
-            subroutine yaop_calc_tke_c(depth_CellInterface_c, prism_center_dist_c_c, &
+            subroutine yaop_calc_tke_c(handle, depth_CellInterface_c, prism_center_dist_c_c, &
                                        inv_prism_center_dist_c_c, prism_thick_c_c, &
                                        dolic_c_c, dolic_e_c, zlev_i_c, wet_c_c, &
                                        edges_cell_idx_c, edges_cell_blk_c, &
@@ -213,6 +449,7 @@ module mod_YAOP
                 use iso_c_binding
 
                 implicit none
+                type(c_ptr), value    :: handle
                 type(c_ptr), value    :: depth_CellInterface_c
                 type(c_ptr), value    :: prism_center_dist_c_c
                 type(c_ptr), value    :: inv_prism_center_dist_c_c
@@ -314,7 +551,7 @@ module mod_YAOP
         fu10_ptr                    = c_loc(fu10(1, 1))
         concsum_ptr                 = c_loc(concsum(1, 1))
 
-        CALL yaop_calc_tke_c(depth_CellInterface_ptr, prism_center_dist_c_ptr, &
+        CALL yaop_calc_tke_c(yaop%handle, depth_CellInterface_ptr, prism_center_dist_c_ptr, &
                              inv_prism_center_dist_c_ptr, prism_thick_c_ptr, &
                              dolic_c_ptr, dolic_e_ptr, zlev_i_ptr, wet_c_ptr, &
                              edges_cell_idx_ptr, edges_cell_blk_ptr, &
@@ -335,46 +572,662 @@ module mod_YAOP
 
     end subroutine yaop_calc_tke_f
 
-    subroutine yaop_calc_vertical_stability_f()
+    !> YAOP time loop calculation on the registered fields.
+    !!
+    !! It calls the YAOP_Step C function.
+    subroutine yaop_step_f(yaop, edges_block_size, edges_start_block, edges_end_block, &
+                           edges_start_index, edges_end_index, cells_block_size, &
+                           cells_start_block, cells_end_block, cells_start_index, &
+                           cells_end_index)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: edges_block_size
+        integer, intent(in) :: edges_start_block
+        integer, intent(in) :: edges_end_block
+        integer, intent(in) :: edges_start_index
+        integer, intent(in) :: edges_end_index
+        integer, intent(in) :: cells_block_size
+        integer, intent(in) :: cells_start_block
+        integer, intent(in) :: cells_end_block
+        integer, intent(in) :: cells_start_index
+        integer, intent(in) :: cells_end_index
+
+        interface
+            subroutine yaop_step_c(handle, edges_block_size_c, edges_start_block_c, edges_end_block_c, &
+                                   edges_start_index_c, edges_end_index_c, cells_block_size_c, &
+                                   cells_start_block_c, cells_end_block_c, cells_start_index_c, &
+                                   cells_end_index_c) bind(C, name="YAOP_Step")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: edges_block_size_c
+                integer(c_int), value :: edges_start_block_c
+                integer(c_int), value :: edges_end_block_c
+                integer(c_int), value :: edges_start_index_c
+                integer(c_int), value :: edges_end_index_c
+                integer(c_int), value :: cells_block_size_c
+                integer(c_int), value :: cells_start_block_c
+                integer(c_int), value :: cells_end_block_c
+                integer(c_int), value :: cells_start_index_c
+                integer(c_int), value :: cells_end_index_c
+            end subroutine yaop_step_c
+        end interface
+
+        CALL yaop_step_c(yaop%handle, edges_block_size, edges_start_block-1, edges_end_block-1, &
+                         edges_start_index-1, edges_end_index-1, cells_block_size, &
+                         cells_start_block-1, cells_end_block-1, cells_start_index-1, &
+                         cells_end_index-1)
+    end subroutine yaop_step_f
+
+    !> Calculation with nsubsteps tke steps of dtime / nsubsteps on the registered fields.
+    !!
+    !! It calls the YAOP_Step_substeps C function and returns false if nsubsteps or dtime is not positive.
+    function yaop_step_substeps_f(yaop, edges_block_size, edges_start_block, edges_end_block, &
+                                  edges_start_index, edges_end_index, cells_block_size, &
+                                  cells_start_block, cells_end_block, cells_start_index, &
+                                  cells_end_index, nsubsteps, dtime) result(is_computed)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: edges_block_size
+        integer, intent(in) :: edges_start_block
+        integer, intent(in) :: edges_end_block
+        integer, intent(in) :: edges_start_index
+        integer, intent(in) :: edges_end_index
+        integer, intent(in) :: cells_block_size
+        integer, intent(in) :: cells_start_block
+        integer, intent(in) :: cells_end_block
+        integer, intent(in) :: cells_start_index
+        integer, intent(in) :: cells_end_index
+        integer, intent(in) :: nsubsteps
+        real(dp), intent(in) :: dtime
+        logical :: is_computed
+
+        interface
+            function yaop_step_substeps_c(handle, edges_block_size_c, edges_start_block_c, edges_end_block_c, &
+                                          edges_start_index_c, edges_end_index_c, cells_block_size_c, &
+                                          cells_start_block_c, cells_end_block_c, cells_start_index_c, &
+                                          cells_end_index_c, nsubsteps_c, dtime_c) &
+                                          bind(C, name="YAOP_Step_substeps")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: edges_block_size_c
+                integer(c_int), value :: edges_start_block_c
+                integer(c_int), value :: edges_end_block_c
+                integer(c_int), value :: edges_start_index_c
+                integer(c_int), value :: edges_end_index_c
+                integer(c_int), value :: cells_block_size_c
+                integer(c_int), value :: cells_start_block_c
+                integer(c_int), value :: cells_end_block_c
+                integer(c_int), value :: cells_start_index_c
+                integer(c_int), value :: cells_end_index_c
+                integer(c_int), value :: nsubsteps_c
+                real(c_double), value :: dtime_c
+                integer(c_int)        :: yaop_step_substeps_c
+            end function yaop_step_substeps_c
+        end interface
+
+        is_computed = yaop_step_substeps_c(yaop%handle, edges_block_size, edges_start_block-1, &
+                                           edges_end_block-1, edges_start_index-1, edges_end_index-1, &
+                                           cells_block_size, cells_start_block-1, cells_end_block-1, &
+                                           cells_start_index-1, cells_end_index-1, nsubsteps, dtime) /= 0
+    end function yaop_step_substeps_f
+
+    subroutine yaop_register_field_double_1d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in)          :: name
+        real(c_double), intent(in),    TARGET :: data(:)
+
+        if (.not. is_contiguous(data)) error stop "YAOP: only contiguous fields can be registered"
+        CALL yaop_register_field_double_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1)), 1, &
+                                          [size(data, 1)], c_null_ptr)
+    end subroutine yaop_register_field_double_1d_f
+
+    subroutine yaop_register_field_double_2d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in)          :: name
+        real(c_double), intent(in),    TARGET :: data(:,:)
+
+        if (.not. is_contiguous(data)) error stop "YAOP: only contiguous fields can be registered"
+        CALL yaop_register_field_double_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1, 1)), 2, &
+                                          [size(data, 2), size(data, 1)], c_null_ptr)
+    end subroutine yaop_register_field_double_2d_f
+
+    subroutine yaop_register_field_double_3d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in)          :: name
+        real(c_double), intent(in),    TARGET :: data(:,:,:)
+
+        if (.not. is_contiguous(data)) error stop "YAOP: only contiguous fields can be registered"
+        CALL yaop_register_field_double_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1, 1, 1)), 3, &
+                                          [size(data, 3), size(data, 2), size(data, 1)], c_null_ptr)
+    end subroutine yaop_register_field_double_3d_f
+
+    subroutine yaop_register_field_int_2d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in) :: name
+        integer, intent(in), TARGET  :: data(:,:)
+
+        if (.not. is_contiguous(data)) error stop "YAOP: only contiguous fields can be registered"
+        CALL yaop_register_field_int_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1, 1)), 2, &
+                                       [size(data, 2), size(data, 1)], c_null_ptr)
+    end subroutine yaop_register_field_int_2d_f
+
+    subroutine yaop_register_field_int_3d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in) :: name
+        integer, intent(in), TARGET  :: data(:,:,:)
+
+        if (.not. is_contiguous(data)) error stop "YAOP: only contiguous fields can be registered"
+        CALL yaop_register_field_int_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1, 1, 1)), 3, &
+                                       [size(data, 3), size(data, 2), size(data, 1)], c_null_ptr)
+    end subroutine yaop_register_field_int_3d_f
+
+    subroutine yaop_rebind_field_double_1d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in)          :: name
+        real(c_double), intent(in),    TARGET :: data(:)
+
+        CALL yaop_rebind_field_double_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1)))
+    end subroutine yaop_rebind_field_double_1d_f
+
+    subroutine yaop_rebind_field_double_2d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in)          :: name
+        real(c_double), intent(in),    TARGET :: data(:,:)
+
+        CALL yaop_rebind_field_double_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1, 1)))
+    end subroutine yaop_rebind_field_double_2d_f
+
+    subroutine yaop_rebind_field_double_3d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in)          :: name
+        real(c_double), intent(in),    TARGET :: data(:,:,:)
+
+        CALL yaop_rebind_field_double_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1, 1, 1)))
+    end subroutine yaop_rebind_field_double_3d_f
+
+    subroutine yaop_rebind_field_int_2d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in) :: name
+        integer, intent(in), TARGET  :: data(:,:)
+
+        CALL yaop_rebind_field_int_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1, 1)))
+    end subroutine yaop_rebind_field_int_2d_f
+
+    subroutine yaop_rebind_field_int_3d_f(yaop, name, data)
+        implicit none
+        type(t_yaop), intent(in)     :: yaop
+        character(len=*), intent(in) :: name
+        integer, intent(in), TARGET  :: data(:,:,:)
+
+        CALL yaop_rebind_field_int_c(yaop%handle, trim(name)//c_null_char, c_loc(data(1, 1, 1)))
+    end subroutine yaop_rebind_field_int_3d_f
+
+    !> Save the currently bound fields as a buffer set.
+    !!
+    !! It calls the YAOP_Save_buffer_set C function and returns the buffer set id.
+    function yaop_save_buffer_set_f(yaop) result(id)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer :: id
+
+        interface
+            function yaop_save_buffer_set_c(handle) bind(C, name="YAOP_Save_buffer_set")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value :: handle
+                integer(c_int) :: yaop_save_buffer_set_c
+            end function yaop_save_buffer_set_c
+        end interface
+
+        id = yaop_save_buffer_set_c(yaop%handle)
+    end function yaop_save_buffer_set_f
+
+    !> Bind the fields of a previously saved buffer set.
+    !!
+    !! It calls the YAOP_Select_buffer_set C function.
+    subroutine yaop_select_buffer_set_f(yaop, id)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: id
+
+        interface
+            subroutine yaop_select_buffer_set_c(handle, id_c) bind(C, name="YAOP_Select_buffer_set")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: id_c
+            end subroutine yaop_select_buffer_set_c
+        end interface
+
+        CALL yaop_select_buffer_set_c(yaop%handle, id)
+    end subroutine yaop_select_buffer_set_f
+
+    !> YAOP time loop calculation on an ensemble of saved buffer sets sharing the grid info.
+    !!
+    !! It calls the YAOP_Step_ensemble C function.
+    subroutine yaop_step_ensemble_f(yaop, set_ids, edges_block_size, edges_start_block, edges_end_block, &
+                                    edges_start_index, edges_end_index, cells_block_size, &
+                                    cells_start_block, cells_end_block, cells_start_index, &
+                                    cells_end_index)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer(c_int), intent(in) :: set_ids(:)
+        integer, intent(in) :: edges_block_size
+        integer, intent(in) :: edges_start_block
+        integer, intent(in) :: edges_end_block
+        integer, intent(in) :: edges_start_index
+        integer, intent(in) :: edges_end_index
+        integer, intent(in) :: cells_block_size
+        integer, intent(in) :: cells_start_block
+        integer, intent(in) :: cells_end_block
+        integer, intent(in) :: cells_start_index
+        integer, intent(in) :: cells_end_index
+
+        interface
+            subroutine yaop_step_ensemble_c(handle, nmembers_c, set_ids_c, &
+                                            edges_block_size_c, edges_start_block_c, edges_end_block_c, &
+                                            edges_start_index_c, edges_end_index_c, cells_block_size_c, &
+                                            cells_start_block_c, cells_end_block_c, cells_start_index_c, &
+                                            cells_end_index_c) bind(C, name="YAOP_Step_ensemble")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: nmembers_c
+                integer(c_int)        :: set_ids_c(*)
+                integer(c_int), value :: edges_block_size_c
+                integer(c_int), value :: edges_start_block_c
+                integer(c_int), value :: edges_end_block_c
+                integer(c_int), value :: edges_start_index_c
+                integer(c_int), value :: edges_end_index_c
+                integer(c_int), value :: cells_block_size_c
+                integer(c_int), value :: cells_start_block_c
+                integer(c_int), value :: cells_end_block_c
+                integer(c_int), value :: cells_start_index_c
+                integer(c_int), value :: cells_end_index_c
+            end subroutine yaop_step_ensemble_c
+        end interface
+
+        CALL yaop_step_ensemble_c(yaop%handle, size(set_ids), set_ids, &
+                                  edges_block_size, edges_start_block-1, edges_end_block-1, &
+                                  edges_start_index-1, edges_end_index-1, cells_block_size, &
+                                  cells_start_block-1, cells_end_block-1, cells_start_index-1, &
+                                  cells_end_index-1)
+    end subroutine yaop_step_ensemble_f
+
+    !> Stage timers of the tke scheme.
+    !!
+    !! It calls the YAOP_Timing_report C function.
+    subroutine yaop_timing_report_f(yaop, report)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        type(t_yaop_timing_report), intent(out) :: report
+
+        interface
+            subroutine yaop_timing_report_c(handle, report_c) bind(C, name="YAOP_Timing_report")
+                use iso_c_binding
+                import :: t_yaop_timing_report
+                implicit none
+
+                type(c_ptr), value         :: handle
+                type(t_yaop_timing_report) :: report_c
+            end subroutine yaop_timing_report_c
+        end interface
+
+        CALL yaop_timing_report_c(yaop%handle, report)
+    end subroutine yaop_timing_report_f
+
+    !> Reset the stage timers of the tke scheme.
+    subroutine yaop_reset_timing_f(yaop)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+
+        interface
+            subroutine yaop_reset_timing_c(handle) bind(C, name="YAOP_Reset_timing")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value :: handle
+            end subroutine yaop_reset_timing_c
+        end interface
+
+        CALL yaop_reset_timing_c(yaop%handle)
+    end subroutine yaop_reset_timing_f
+
+    !> Write the execution timeline as Chrome trace JSON.
+    subroutine yaop_dump_trace_f(yaop, filename)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        character(len=*), intent(in) :: filename
+
+        interface
+            subroutine yaop_dump_trace_c(handle, filename_c) bind(C, name="YAOP_Dump_trace")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value                   :: handle
+                character(kind=c_char), dimension(*) :: filename_c
+            end subroutine yaop_dump_trace_c
+        end interface
+
+        CALL yaop_dump_trace_c(yaop%handle, trim(filename) // c_null_char)
+    end subroutine yaop_dump_trace_f
+
+    !> Quiescent columns report of the last call.
+    !!
+    !! It calls the YAOP_Quiescence_report C function.
+    subroutine yaop_quiescence_report_f(yaop, report)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        type(t_yaop_quiescence_report), intent(out) :: report
+
+        interface
+            subroutine yaop_quiescence_report_c(handle, report_c) bind(C, name="YAOP_Quiescence_report")
+                use iso_c_binding
+                import :: t_yaop_quiescence_report
+                implicit none
+
+                type(c_ptr), value             :: handle
+                type(t_yaop_quiescence_report) :: report_c
+            end subroutine yaop_quiescence_report_c
+        end interface
+
+        CALL yaop_quiescence_report_c(yaop%handle, report)
+    end subroutine yaop_quiescence_report_f
+
+    !> Totals of the memory report.
+    !!
+    !! It calls the YAOP_Memory_report C function.
+    subroutine yaop_memory_report_f(yaop, report)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        type(t_yaop_memory_report), intent(out) :: report
+
+        interface
+            subroutine yaop_memory_report_c(handle, report_c) bind(C, name="YAOP_Memory_report")
+                use iso_c_binding
+                import :: t_yaop_memory_report
+                implicit none
+
+                type(c_ptr), value         :: handle
+                type(t_yaop_memory_report) :: report_c
+            end subroutine yaop_memory_report_c
+        end interface
+
+        CALL yaop_memory_report_c(yaop%handle, report)
+    end subroutine yaop_memory_report_f
+
+    !> Name and bytes of a field of the memory report (index from 1).
+    !!
+    !! registered is false for the internal fields and true for the bound fields.
+    !! The name is empty if index is out of range.
+    subroutine yaop_memory_field_f(yaop, registered, index, name, bytes)
         implicit none
+        type(t_yaop), intent(in) :: yaop
+        logical, intent(in) :: registered
+        integer, intent(in) :: index
+        character(len=*), intent(out) :: name
+        integer(c_long_long), intent(out) :: bytes
+
+        type(c_ptr) :: name_c
+        character(kind=c_char), pointer :: chars(:)
+        integer :: i
 
         interface
-            subroutine yaop_calc_vertical_stability_c() bind(C, name="YAOP_Calc_vertical_stability")
+            function yaop_memory_field_c(handle, registered_c, index_c, bytes_c) &
+                                         bind(C, name="YAOP_Memory_field")
                 use iso_c_binding
                 implicit none
 
+                type(c_ptr)                 :: yaop_memory_field_c
+                type(c_ptr), value          :: handle
+                integer(c_int), value       :: registered_c
+                integer(c_int), value       :: index_c
+                integer(c_long_long)        :: bytes_c
+            end function yaop_memory_field_c
+        end interface
+
+        name = ""
+        bytes = 0
+        name_c = yaop_memory_field_c(yaop%handle, merge(1, 0, registered), index-1, bytes)
+        if (.not. c_associated(name_c)) return
+        CALL c_f_pointer(name_c, chars, [len(name)])
+        do i = 1, len(name)
+            if (chars(i) == c_null_char) exit
+            name(i:i) = chars(i)
+        end do
+    end subroutine yaop_memory_field_f
+
+    !> Capture the inputs of a time step (counted from 1) to a binary snapshot.
+    !!
+    !! It calls the YAOP_Capture C function.
+    subroutine yaop_capture_f(yaop, step, filename)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: step
+        character(len=*), intent(in) :: filename
+
+        interface
+            subroutine yaop_capture_c(handle, step_c, filename_c) bind(C, name="YAOP_Capture")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value                   :: handle
+                integer(c_int), value                :: step_c
+                character(kind=c_char), dimension(*) :: filename_c
+            end subroutine yaop_capture_c
+        end interface
+
+        CALL yaop_capture_c(yaop%handle, step, trim(filename) // c_null_char)
+    end subroutine yaop_capture_f
+
+    !> Vertical stability (Nsqr and Ssqr) on the registered fields.
+    !!
+    !! It calls the YAOP_Calc_vertical_stability C function. The result is consumed by the mixing
+    !! schemes called afterwards in the time step with the same cells range.
+    subroutine yaop_calc_vertical_stability_f(yaop, edges_block_size, edges_start_block, edges_end_block, &
+                                              edges_start_index, edges_end_index, cells_block_size, &
+                                              cells_start_block, cells_end_block, cells_start_index, &
+                                              cells_end_index)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: edges_block_size
+        integer, intent(in) :: edges_start_block
+        integer, intent(in) :: edges_end_block
+        integer, intent(in) :: edges_start_index
+        integer, intent(in) :: edges_end_index
+        integer, intent(in) :: cells_block_size
+        integer, intent(in) :: cells_start_block
+        integer, intent(in) :: cells_end_block
+        integer, intent(in) :: cells_start_index
+        integer, intent(in) :: cells_end_index
+
+        interface
+            subroutine yaop_calc_vertical_stability_c(handle, edges_block_size_c, edges_start_block_c, &
+                                                      edges_end_block_c, edges_start_index_c, edges_end_index_c, &
+                                                      cells_block_size_c, cells_start_block_c, cells_end_block_c, &
+                                                      cells_start_index_c, cells_end_index_c) &
+                                                      bind(C, name="YAOP_Calc_vertical_stability")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: edges_block_size_c
+                integer(c_int), value :: edges_start_block_c
+                integer(c_int), value :: edges_end_block_c
+                integer(c_int), value :: edges_start_index_c
+                integer(c_int), value :: edges_end_index_c
+                integer(c_int), value :: cells_block_size_c
+                integer(c_int), value :: cells_start_block_c
+                integer(c_int), value :: cells_end_block_c
+                integer(c_int), value :: cells_start_index_c
+                integer(c_int), value :: cells_end_index_c
             end subroutine yaop_calc_vertical_stability_c
         end interface
 
-        CALL yaop_calc_vertical_stability_c()
+        CALL yaop_calc_vertical_stability_c(yaop%handle, edges_block_size, edges_start_block-1, edges_end_block-1, &
+                                            edges_start_index-1, edges_end_index-1, cells_block_size, &
+                                            cells_start_block-1, cells_end_block-1, cells_start_index-1, &
+                                            cells_end_index-1)
     end subroutine yaop_calc_vertical_stability_f
 
-    subroutine yaop_calc_pp_f()
+    !> Pacanowski-Philander scheme on the registered fields.
+    !!
+    !! It calls the YAOP_Calc_pp C function.
+    subroutine yaop_calc_pp_f(yaop, edges_block_size, edges_start_block, edges_end_block, &
+                              edges_start_index, edges_end_index, cells_block_size, &
+                              cells_start_block, cells_end_block, cells_start_index, &
+                              cells_end_index)
         implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: edges_block_size
+        integer, intent(in) :: edges_start_block
+        integer, intent(in) :: edges_end_block
+        integer, intent(in) :: edges_start_index
+        integer, intent(in) :: edges_end_index
+        integer, intent(in) :: cells_block_size
+        integer, intent(in) :: cells_start_block
+        integer, intent(in) :: cells_end_block
+        integer, intent(in) :: cells_start_index
+        integer, intent(in) :: cells_end_index
 
         interface
-            subroutine yaop_calc_pp_c() bind(C, name="YAOP_Calc_pp")
+            subroutine yaop_calc_pp_c(handle, edges_block_size_c, edges_start_block_c, edges_end_block_c, &
+                                      edges_start_index_c, edges_end_index_c, cells_block_size_c, &
+                                      cells_start_block_c, cells_end_block_c, cells_start_index_c, &
+                                      cells_end_index_c) bind(C, name="YAOP_Calc_pp")
                 use iso_c_binding
                 implicit none
 
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: edges_block_size_c
+                integer(c_int), value :: edges_start_block_c
+                integer(c_int), value :: edges_end_block_c
+                integer(c_int), value :: edges_start_index_c
+                integer(c_int), value :: edges_end_index_c
+                integer(c_int), value :: cells_block_size_c
+                integer(c_int), value :: cells_start_block_c
+                integer(c_int), value :: cells_end_block_c
+                integer(c_int), value :: cells_start_index_c
+                integer(c_int), value :: cells_end_index_c
             end subroutine yaop_calc_pp_c
         end interface
 
-        CALL yaop_calc_pp_c()
+        CALL yaop_calc_pp_c(yaop%handle, edges_block_size, edges_start_block-1, edges_end_block-1, &
+                            edges_start_index-1, edges_end_index-1, cells_block_size, &
+                            cells_start_block-1, cells_end_block-1, cells_start_index-1, &
+                            cells_end_index-1)
     end subroutine yaop_calc_pp_f
 
-    subroutine yaop_calc_idemix_f()
+    !> IDEMIX scheme on the registered fields.
+    !!
+    !! It calls the YAOP_Calc_idemix C function.
+    subroutine yaop_calc_idemix_f(yaop, edges_block_size, edges_start_block, edges_end_block, &
+                                  edges_start_index, edges_end_index, cells_block_size, &
+                                  cells_start_block, cells_end_block, cells_start_index, &
+                                  cells_end_index)
         implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: edges_block_size
+        integer, intent(in) :: edges_start_block
+        integer, intent(in) :: edges_end_block
+        integer, intent(in) :: edges_start_index
+        integer, intent(in) :: edges_end_index
+        integer, intent(in) :: cells_block_size
+        integer, intent(in) :: cells_start_block
+        integer, intent(in) :: cells_end_block
+        integer, intent(in) :: cells_start_index
+        integer, intent(in) :: cells_end_index
 
         interface
-            subroutine yaop_calc_idemix_c() bind(C, name="YAOP_Calc_idemix")
+            subroutine yaop_calc_idemix_c(handle, edges_block_size_c, edges_start_block_c, edges_end_block_c, &
+                                          edges_start_index_c, edges_end_index_c, cells_block_size_c, &
+                                          cells_start_block_c, cells_end_block_c, cells_start_index_c, &
+                                          cells_end_index_c) bind(C, name="YAOP_Calc_idemix")
                 use iso_c_binding
                 implicit none
 
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: edges_block_size_c
+                integer(c_int), value :: edges_start_block_c
+                integer(c_int), value :: edges_end_block_c
+                integer(c_int), value :: edges_start_index_c
+                integer(c_int), value :: edges_end_index_c
+                integer(c_int), value :: cells_block_size_c
+                integer(c_int), value :: cells_start_block_c
+                integer(c_int), value :: cells_end_block_c
+                integer(c_int), value :: cells_start_index_c
+                integer(c_int), value :: cells_end_index_c
             end subroutine yaop_calc_idemix_c
         end interface
 
-        CALL yaop_calc_idemix_c()
+        CALL yaop_calc_idemix_c(yaop%handle, edges_block_size, edges_start_block-1, edges_end_block-1, &
+                                edges_start_index-1, edges_end_index-1, cells_block_size, &
+                                cells_start_block-1, cells_end_block-1, cells_start_index-1, &
+                                cells_end_index-1)
     end subroutine yaop_calc_idemix_f
 
+    !> IDEMIX coupled with the tke scheme on the registered fields.
+    !!
+    !! It calls the YAOP_Step_idemix_tke C function.
+    subroutine yaop_step_idemix_tke_f(yaop, edges_block_size, edges_start_block, edges_end_block, &
+                                      edges_start_index, edges_end_index, cells_block_size, &
+                                      cells_start_block, cells_end_block, cells_start_index, &
+                                      cells_end_index)
+        implicit none
+        type(t_yaop), intent(in) :: yaop
+        integer, intent(in) :: edges_block_size
+        integer, intent(in) :: edges_start_block
+        integer, intent(in) :: edges_end_block
+        integer, intent(in) :: edges_start_index
+        integer, intent(in) :: edges_end_index
+        integer, intent(in) :: cells_block_size
+        integer, intent(in) :: cells_start_block
+        integer, intent(in) :: cells_end_block
+        integer, intent(in) :: cells_start_index
+        integer, intent(in) :: cells_end_index
+
+        interface
+            subroutine yaop_step_idemix_tke_c(handle, edges_block_size_c, edges_start_block_c, edges_end_block_c, &
+                                              edges_start_index_c, edges_end_index_c, cells_block_size_c, &
+                                              cells_start_block_c, cells_end_block_c, cells_start_index_c, &
+                                              cells_end_index_c) bind(C, name="YAOP_Step_idemix_tke")
+                use iso_c_binding
+                implicit none
+
+                type(c_ptr), value    :: handle
+                integer(c_int), value :: edges_block_size_c
+                integer(c_int), value :: edges_start_block_c
+                integer(c_int), value :: edges_end_block_c
+                integer(c_int), value :: edges_start_index_c
+                integer(c_int), value :: edges_end_index_c
+                integer(c_int), value :: cells_block_size_c
+                integer(c_int), value :: cells_start_block_c
+                integer(c_int), value :: cells_end_block_c
+                integer(c_int), value :: cells_start_index_c
+                integer(c_int), value :: cells_end_index_c
+            end subroutine yaop_step_idemix_tke_c
+        end interface
+
+        CALL yaop_step_idemix_tke_c(yaop%handle, edges_block_size, edges_start_block-1, edges_end_block-1, &
+                                    edges_start_index-1, edges_end_index-1, cells_block_size, &
+                                    cells_start_block-1, cells_end_block-1, cells_start_index-1, &
+                                    cells_end_index-1)
+    end subroutine yaop_step_idemix_tke_f
+
 end module mod_YAOP
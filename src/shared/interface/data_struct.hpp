@@ -17,6 +17,16 @@
 #ifndef SRC_SHARED_INTERFACE_DATA_STRUCT_HPP_
 #define SRC_SHARED_INTERFACE_DATA_STRUCT_HPP_
 
+/*! \brief Solvers of the tridiagonal systems of the tke scheme (CPU backend).
+*
+*   thomas is the sequential recurrence along each column, vectorised over the columns of a block.
+*   pcr is the parallel cyclic reduction, vectorised along the vertical axis of each column.
+*/
+enum t_tridiag_solver {
+    tridiag_thomas = 0,
+    tridiag_pcr = 1,
+};
+
 // TKE constants
 struct t_constant {
     int nproma;
@@ -39,7 +49,7 @@ struct t_constant_tke {
     double c_eps;
     double cd;
     double alpha_tke;
-    double clc;
+    double c_stokes;
     double mxl_min;
     double KappaM_min;
     double KappaH_min;
@@ -52,6 +62,32 @@ struct t_constant_tke {
     bool use_Kappa_min;
     bool use_ubound_dirichlet;
     bool use_lbound_dirichlet;
+    int tridiag_solver;
+    int nsubsteps;
+    double quiescent_threshold;
+    int quiescent_refresh;
+    bool fuse_edges;
+};
+
+// PP constants
+struct t_constant_pp {
+    double richardson_factor_veloc;
+    double richardson_factor_tracer;
+    double c1_pp;
+    double velocity_background;
+    double tracer_background;
+    double convection_threshold;
+    double max_vert_diff_veloc;
+    double max_vert_diff_tracer;
+};
+
+// IDEMIX constants
+struct t_constant_idemix {
+    double tau_v;
+    double tau_h;
+    double gamma;
+    double jstar;
+    double mu0;
 };
 
 struct t_patch {
@@ -115,6 +151,119 @@ struct t_sea_ice {
     double *concsum;
 };
 
+// Squared buoyancy and shear frequencies at the cell interfaces, shared by the mixing schemes
+struct t_vertical_stability {
+    double *Nsqr;
+    double *Ssqr;
+};
+
+// Internal wave energy at the cell interfaces and its forcing, prognostic fields of IDEMIX
+struct t_idemix {
+    double *iwe;
+    double *forc_iw_surface;
+    double *forc_iw_bottom;
+};
+
+// Horizontal grid info used by the horizontal propagation of IDEMIX (triangular cells)
+struct t_horizontal_grid {
+    double *f_c;
+    double *cells_area;
+    int *cells_edge_idx;
+    int *cells_edge_blk;
+    double *cells_edge_orientation;
+    double *edges_primal_edge_length;
+    double *edges_dual_edge_length;
+};
+
+struct t_index_range {
+    int edges_block_size;
+    int edges_start_block;
+    int edges_end_block;
+    int edges_start_index;
+    int edges_end_index;
+    int cells_block_size;
+    int cells_start_block;
+    int cells_end_block;
+    int cells_start_index;
+    int cells_end_index;
+};
+
+/*! \brief Fields of one ensemble member.
+*
+*   The members of an ensemble share the grid info (t_patch) and differ in the state and forcing.
+*/
+struct t_ensemble_member {
+    struct t_cvmix p_cvmix;
+    struct t_ocean_state ocean_state;
+    struct t_atmo_fluxes atmos_fluxes;
+    struct t_atmos_for_ocean p_as;
+    struct t_sea_ice p_sea_ice;
+};
+
+/*! \brief Stages of the tke scheme measured by the timers.
+*
+*   The order is the one of the timing report arrays and of the C and Fortran bindings.
+*/
+enum t_timing_stage {
+    timing_view_init = 0,
+    timing_pre_integration,
+    timing_nsqr_ssqr,
+    timing_mixing_length,
+    timing_diffusivity,
+    timing_forcing,
+    timing_tridiag_build,
+    timing_solve,
+    timing_diagnostics,
+    timing_edges,
+    timing_idemix,
+    timing_nstages
+};
+
+/*! \brief Hardware counters of the timing report.
+*
+*   fp_scalar and fp_vector count the retired scalar and packed floating point instructions.
+*/
+enum t_perf_counter {
+    perf_cycles = 0,
+    perf_instructions,
+    perf_cache_misses,
+    perf_fp_scalar,
+    perf_fp_vector,
+    perf_ncounters
+};
+
+/*! \brief Accumulated timers of the tke scheme since the last reset.
+*
+*   seconds and count are accumulated per stage over all the blocks (and threads), while
+*   total_seconds is the wall time of the ncalls backend calls. enabled is 0 when the library
+*   is compiled without timers. counters are the hardware counters accumulated per stage, when
+*   they are collected (YAOP_PERF_COUNTERS), and counters_enabled is the mask of the collected
+*   ones (bit i for the counter i of t_perf_counter).
+*/
+struct t_timing_report {
+    int enabled;
+    int counters_enabled;
+    long long ncalls;
+    double total_seconds;
+    double seconds[timing_nstages];
+    long long count[timing_nstages];
+    long long counters[timing_nstages][perf_ncounters];
+};
+
+/*! \brief Columns skipped by the tke scheme in the last call, with the quiescent columns mode.
+*
+*   enabled is 0 when the mode is off. The columns of the skipped blocks keep tke and the diffusivities
+*   of their last full step, and max_error_bound is the largest bound of the tke error accumulated since
+*   then (the time since the full step times the bound of the tke tendency, in m2/s2).
+*/
+struct t_quiescence_report {
+    int enabled;
+    int nblocks_skipped;
+    long long ncolumns;
+    long long nquiescent;
+    double max_error_bound;
+};
+
 /*! \brief Fill grid info data struct from array pointers.
 *
 */
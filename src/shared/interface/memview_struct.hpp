@@ -94,6 +94,7 @@ template <template <class ...> class memview,
           template <class, size_t> class dext>
 struct t_tke_internal_view {
     memview<double, dext<int, 1>> forc_tke_surf_2D;
+    memview<double, dext<int, 1>> pot_energy_lc_2D;
     memview<double, dext<int, 2>> dzw_stretched;
     memview<double, dext<int, 2>> dzt_stretched;
     memview<double, dext<int, 2>> tke_old;
@@ -115,6 +116,74 @@ struct t_tke_internal_view {
     memview<double, dext<int, 2>> dp;
     memview<double, dext<int, 2>> tke_upd;
     memview<double, dext<int, 2>> tke_unrest;
+    memview<double, dext<int, 2>> iwe_Tdis;
+};
+
+template <template <class ...> class memview,
+          template <class, size_t> class dext>
+struct t_tke_geometry_view {
+    memview<double, dext<int, 3>> dzw_stretched;
+    memview<double, dext<int, 3>> dzt_stretched;
+    memview<double, dext<int, 3>> inv_dzt_stretched;
+    memview<double, dext<int, 2>> stretch_c;
+    memview<double, dext<int, 1>> pressure;
+    memview<int, dext<int, 1>> max_levels;
+};
+
+template <template <class ...> class memview,
+          template <class, size_t> class dext>
+struct t_edge_gather_view {
+    memview<int, dext<int, 3>> cell_offset;
+    memview<int, dext<int, 2>> fused_block;
+    memview<int, dext<int, 1>> fused_start;
+    memview<int, dext<int, 1>> fused_edges;
+};
+
+template <template <class ...> class memview,
+          template <class, size_t> class dext>
+struct t_tke_quiescence_view {
+    memview<double, dext<int, 2>> activity;
+    memview<double, dext<int, 2>> error_bound;
+    memview<int, dext<int, 1>> skipped_steps;
+};
+
+template <template <class ...> class memview,
+          template <class, size_t> class dext>
+struct t_vertical_stability_view {
+    memview<double, dext<int, 3>> Nsqr;
+    memview<double, dext<int, 3>> Ssqr;
+};
+
+template <template <class ...> class memview,
+          template <class, size_t> class dext>
+struct t_idemix_view {
+    memview<double, dext<int, 3>> iwe;
+    memview<double, dext<int, 2>> forc_iw_surface;
+    memview<double, dext<int, 2>> forc_iw_bottom;
+};
+
+template <template <class ...> class memview,
+          template <class, size_t> class dext>
+struct t_horizontal_grid_view {
+    memview<double, dext<int, 2>> f_c;
+    memview<double, dext<int, 2>> cells_area;
+    memview<int, dext<int, 3>> cells_edge_idx;
+    memview<int, dext<int, 3>> cells_edge_blk;
+    memview<double, dext<int, 3>> cells_edge_orientation;
+    memview<double, dext<int, 2>> edges_primal_edge_length;
+    memview<double, dext<int, 2>> edges_dual_edge_length;
+};
+
+template <template <class ...> class memview,
+          template <class, size_t> class dext>
+struct t_idemix_internal_view {
+    memview<double, dext<int, 1>> bN0;
+    memview<double, dext<int, 2>> c0;
+    memview<double, dext<int, 2>> alpha_c;
+    memview<double, dext<int, 2>> iwe_old;
+    memview<double, dext<int, 2>> iwe_Tdis;
+    memview<double, dext<int, 3>> v0;
+    memview<double, dext<int, 3>> flux_h;
 };
 
 #endif  // SRC_SHARED_INTERFACE_MEMVIEW_STRUCT_HPP_
@@ -0,0 +1,53 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "src/shared/memory_accounting.hpp"
+#include <algorithm>
+#include <cstring>
+
+void memory_accounting::add(const char *name, void *data, size_t bytes) {
+    if (data == nullptr)
+        return;
+    m_allocations[data] = {name, bytes};
+    auto field = std::find_if(m_fields.begin(), m_fields.end(),
+                              [name](const t_memory_field &f) { return std::strcmp(f.name, name) == 0; });
+    if (field == m_fields.end())
+        m_fields.push_back({name, bytes});
+    else
+        field->bytes += bytes;
+    m_current += bytes;
+    m_peak = std::max(m_peak, m_current);
+}
+
+void memory_accounting::remove(const void *data) {
+    auto allocation = m_allocations.find(data);
+    if (allocation == m_allocations.end())
+        return;
+    const t_memory_field &removed = allocation->second;
+    for (t_memory_field &field : m_fields)
+        if (std::strcmp(field.name, removed.name) == 0)
+            field.bytes -= removed.bytes;
+    m_current -= removed.bytes;
+    m_allocations.erase(allocation);
+}
+
+std::vector<t_memory_field> memory_accounting::fields() const {
+    std::vector<t_memory_field> fields;
+    for (const t_memory_field &field : m_fields)
+        if (field.bytes > 0)
+            fields.push_back(field);
+    return fields;
+}
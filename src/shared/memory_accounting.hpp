@@ -0,0 +1,103 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SHARED_MEMORY_ACCOUNTING_HPP_
+#define SRC_SHARED_MEMORY_ACCOUNTING_HPP_
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/*! \brief Bytes of one field of the memory report.
+*
+*/
+struct t_memory_field {
+    const char *name;
+    size_t bytes;
+};
+
+/*! \brief Memory allocated by YAOP and memory of the fields registered by the model.
+*
+*   internal_bytes is the memory currently allocated by the backend (internal fields, geometry
+*   cache, thread scratch and ensemble arrays), peak_bytes its maximum since the construction.
+*   The arrays allocated per thread or per ensemble member are summed under the same name.
+*   registered_bytes is the memory of the fields bound by the model, which is not owned by YAOP.
+*/
+struct t_memory_report {
+    size_t internal_bytes;
+    size_t peak_bytes;
+    size_t registered_bytes;
+    std::vector<t_memory_field> internal_fields;
+    std::vector<t_memory_field> registered_fields;
+};
+
+/*! \brief Accounting of the allocations of one backend instance.
+*
+*   The names are not copied, they have to be string literals (or outlive the accounting).
+*/
+class memory_accounting {
+ public:
+    void add(const char *name, void *data, size_t bytes);
+
+    void remove(const void *data);
+
+    size_t current_bytes() const { return m_current; }
+
+    size_t peak_bytes() const { return m_peak; }
+
+    /*! \brief Allocated bytes per name, in order of first allocation.
+    *
+    */
+    std::vector<t_memory_field> fields() const;
+
+ private:
+    std::unordered_map<const void *, t_memory_field> m_allocations;
+    std::vector<t_memory_field> m_fields;
+    size_t m_current = 0;
+    size_t m_peak = 0;
+};
+
+/*! \brief Counting wrapper of a memview_policy.
+*
+*   It allocates and deallocates with the policy and records every allocation with its name
+*   in a memory accounting.
+*/
+template <class memview_policy>
+class counting_memview_policy {
+ public:
+    explicit counting_memview_policy(memory_accounting *memory) : m_memory(memory) {}
+
+    template <class T, class... Dims>
+    auto memview_malloc(const char *name, T *field, Dims... dims) {
+        auto view = memview_policy::memview_malloc(field, dims...);
+        size_t size = sizeof(T);
+        for (int dim : {dims...})
+            size *= static_cast<size_t>(dim);
+        m_memory->add(name, view.data_handle(), size);
+        return view;
+    }
+
+    template <class T>
+    void memview_free(T *field) {
+        m_memory->remove(field);
+        memview_policy::memview_free(field);
+    }
+
+ private:
+    memory_accounting *m_memory;
+};
+
+#endif  // SRC_SHARED_MEMORY_ACCOUNTING_HPP_
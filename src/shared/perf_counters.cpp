@@ -0,0 +1,196 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "src/shared/perf_counters.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+bool perf_counters::requested() {
+    static const bool is_requested = [] {
+        const char *value = std::getenv("YAOP_PERF_COUNTERS");
+        return value != nullptr && value[0] != '\0' && std::strcmp(value, "0") != 0;
+    }();
+    return is_requested;
+}
+
+const char *perf_counter_name(int counter) {
+    static const char *names[perf_ncounters] = {"cycles", "instructions", "cache_misses", "fp_scalar",
+                                                "fp_vector"};
+    if (counter < 0 || counter >= perf_ncounters)
+        return "unknown";
+    return names[counter];
+}
+
+perf_counters::perf_counters() : m_leader_fd(-1), m_nopen(0), m_available(0), m_tid(-1) {
+    for (int counter = 0; counter < perf_ncounters; counter++) {
+        m_fd[counter] = -1;
+        m_position[counter] = -1;
+    }
+}
+
+perf_counters::perf_counters(perf_counters &&other) noexcept
+    : m_leader_fd(other.m_leader_fd), m_nopen(other.m_nopen), m_available(other.m_available), m_tid(other.m_tid) {
+    for (int counter = 0; counter < perf_ncounters; counter++) {
+        m_fd[counter] = other.m_fd[counter];
+        m_position[counter] = other.m_position[counter];
+        other.m_fd[counter] = -1;
+    }
+    other.m_leader_fd = -1;
+    other.m_nopen = 0;
+    other.m_available = 0;
+    other.m_tid = -1;
+}
+
+perf_counters::~perf_counters() {
+    close();
+}
+
+#ifdef __linux__
+
+// Raw event of the floating point instructions: environment variable or Intel FP_ARITH_INST_RETIRED
+// (event 0xc7, umask 0x03 for scalar single and double, 0xfc for 128, 256 and 512 bits packed)
+static bool fp_raw_config(const char *variable, uint64_t intel_config, struct perf_event_attr *attr) {
+    if (const char *value = std::getenv(variable)) {
+        attr->config = std::strtoull(value, nullptr, 0);
+        return true;
+    }
+    static const bool is_intel = [] {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+            if (line.compare(0, 9, "vendor_id") == 0)
+                return line.find("GenuineIntel") != std::string::npos;
+        return false;
+    }();
+    attr->config = intel_config;
+    return is_intel;
+}
+
+static bool perf_event_attr_fill(int counter, struct perf_event_attr *attr) {
+    std::memset(attr, 0, sizeof(struct perf_event_attr));
+    attr->size = sizeof(struct perf_event_attr);
+    attr->read_format = PERF_FORMAT_GROUP;
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->type = PERF_TYPE_HARDWARE;
+    switch (counter) {
+        case perf_cycles:
+            attr->config = PERF_COUNT_HW_CPU_CYCLES;
+            return true;
+        case perf_instructions:
+            attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+            return true;
+        case perf_cache_misses:
+            attr->config = PERF_COUNT_HW_CACHE_MISSES;
+            return true;
+        case perf_fp_scalar:
+            attr->type = PERF_TYPE_RAW;
+            return fp_raw_config("YAOP_PERF_FP_SCALAR", 0x03c7, attr);
+        case perf_fp_vector:
+            attr->type = PERF_TYPE_RAW;
+            return fp_raw_config("YAOP_PERF_FP_VECTOR", 0xfcc7, attr);
+        default:
+            return false;
+    }
+}
+
+static long current_tid() {
+    static thread_local long tid = syscall(SYS_gettid);
+    return tid;
+}
+
+void perf_counters::open() {
+    close();
+    m_tid = current_tid();
+
+    int errno_leader = 0;
+    for (int counter = 0; counter < perf_ncounters; counter++) {
+        struct perf_event_attr attr;
+        if (!perf_event_attr_fill(counter, &attr))
+            continue;
+        // the first opened counter is the group leader
+        m_fd[counter] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, m_leader_fd, 0));
+        if (m_fd[counter] < 0) {
+            if (m_nopen == 0)
+                errno_leader = errno;
+            continue;
+        }
+        if (m_nopen == 0)
+            m_leader_fd = m_fd[counter];
+        m_position[counter] = m_nopen++;
+        m_available |= 1 << counter;
+    }
+
+    static std::atomic<bool> is_warned(false);
+    if (m_nopen == 0 && !is_warned.exchange(true))
+        std::cerr << "YAOP: hardware counters not available (perf_event_open: " << std::strerror(errno_leader)
+                  << ")" << std::endl;
+}
+
+void perf_counters::close() {
+    for (int counter = 0; counter < perf_ncounters; counter++) {
+        if (m_fd[counter] >= 0)
+            ::close(m_fd[counter]);
+        m_fd[counter] = -1;
+        m_position[counter] = -1;
+    }
+    m_leader_fd = -1;
+    m_nopen = 0;
+    m_available = 0;
+    m_tid = -1;
+}
+
+bool perf_counters::read(long long values[perf_ncounters]) {
+    if (!requested())
+        return false;
+    if (current_tid() != m_tid)
+        open();
+    if (m_nopen == 0)
+        return false;
+
+    // the group leader reads the number of counters and then all of them
+    uint64_t group[1 + perf_ncounters];
+    if (::read(m_leader_fd, group, sizeof(group)) < static_cast<ssize_t>((1 + m_nopen) * sizeof(uint64_t)))
+        return false;
+    for (int counter = 0; counter < perf_ncounters; counter++)
+        if (m_position[counter] >= 0)
+            values[counter] = static_cast<long long>(group[1 + m_position[counter]]);
+    return true;
+}
+
+#else
+
+void perf_counters::open() {}
+
+void perf_counters::close() {}
+
+bool perf_counters::read(long long values[perf_ncounters]) {
+    static_cast<void>(values);
+    return false;
+}
+
+#endif
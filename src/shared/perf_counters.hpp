@@ -0,0 +1,77 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SHARED_PERF_COUNTERS_HPP_
+#define SRC_SHARED_PERF_COUNTERS_HPP_
+
+#include "src/shared/interface/data_struct.hpp"
+
+/*! \brief Hardware performance counters of one thread, read with Linux perf_event_open.
+*
+*   The counters are collected only when the environment variable YAOP_PERF_COUNTERS is set (and
+*   not 0). They are opened as a single group at the first read, for the calling thread and for
+*   the user space only, so that all of them are scheduled together. The counters which are not
+*   supported by the processor (or by the kernel permissions) are left out of the group. The
+*   floating point events are the FP_ARITH_INST_RETIRED ones of Intel processors, other raw events
+*   can be given with YAOP_PERF_FP_SCALAR and YAOP_PERF_FP_VECTOR.
+*/
+class perf_counters {
+ public:
+    perf_counters();
+    ~perf_counters();
+
+    // The file descriptors are owned by a single object
+    perf_counters(perf_counters &&other) noexcept;
+    perf_counters(const perf_counters &) = delete;
+    perf_counters &operator=(const perf_counters &) = delete;
+    perf_counters &operator=(perf_counters &&) = delete;
+
+    /*! \brief Read the current values of the counters of the calling thread.
+    *
+    *   The counters are (re)opened when the calling thread is not the one they were opened for.
+    *   Returns false, without changing values, when the counters are not collected.
+    */
+    bool read(long long values[perf_ncounters]);
+
+    /*! \brief Mask of the collected counters (bit i set for the counter i of t_perf_counter).
+    *
+    */
+    int available() const { return m_available; }
+
+    /*! \brief Whether the collection is requested with YAOP_PERF_COUNTERS.
+    *
+    */
+    static bool requested();
+
+ private:
+    void open();
+    void close();
+
+    int m_fd[perf_ncounters];
+    int m_leader_fd;
+    // position of each counter in the values of the group
+    int m_position[perf_ncounters];
+    int m_nopen;
+    int m_available;
+    long m_tid;
+};
+
+/*! \brief Name of a hardware counter of the timing report.
+*
+*/
+const char *perf_counter_name(int counter);
+
+#endif  // SRC_SHARED_PERF_COUNTERS_HPP_
@@ -0,0 +1,161 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/shared/snapshot.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+constexpr char snapshot_magic[8] = {'Y', 'A', 'O', 'P', 'S', 'N', 'A', 'P'};
+constexpr uint32_t snapshot_version = 1;
+constexpr size_t snapshot_alignment = 64;
+
+struct t_snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t nfields;
+    int64_t call;
+    t_snapshot_params params;
+    int32_t range[10];
+};
+
+struct t_snapshot_entry {
+    char name[snapshot_name_length];
+    int32_t type;
+    int32_t ndims;
+    int32_t shape[snapshot_max_dims];
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+static_assert(sizeof(t_index_range) == sizeof(int32_t[10]), "t_index_range has to be made of 10 int");
+
+static size_t align(size_t offset) {
+    return (offset + snapshot_alignment - 1) / snapshot_alignment * snapshot_alignment;
+}
+
+static void snapshot_error(const std::string &filename, const std::string &message) {
+    std::cerr << "YAOP: snapshot " << filename << ": " << message << std::endl;
+    abort();
+}
+
+void snapshot_write(const std::string &filename, const t_snapshot_params &params,
+                    const t_index_range &range, int64_t call,
+                    const std::vector<t_snapshot_field> &fields) {
+    t_snapshot_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.nfields = static_cast<uint32_t>(fields.size());
+    header.call = call;
+    header.params = params;
+    std::memcpy(header.range, &range, sizeof(header.range));
+
+    std::vector<t_snapshot_entry> entries(fields.size());
+    size_t offset = align(sizeof(header) + entries.size() * sizeof(t_snapshot_entry));
+    for (size_t i = 0; i < fields.size(); i++) {
+        const t_snapshot_field &field = fields[i];
+        if (field.name.size() >= snapshot_name_length || field.shape.size() > snapshot_max_dims)
+            snapshot_error(filename, "field " + field.name + " cannot be described in the header");
+        t_snapshot_entry &entry = entries[i];
+        std::memset(&entry, 0, sizeof(entry));
+        std::memcpy(entry.name, field.name.c_str(), field.name.size());
+        entry.type = field.type;
+        entry.ndims = static_cast<int32_t>(field.shape.size());
+        for (size_t d = 0; d < field.shape.size(); d++)
+            entry.shape[d] = field.shape[d];
+        entry.offset = offset;
+        entry.bytes = field.bytes;
+        offset = align(offset + field.bytes);
+    }
+
+    FILE *file = std::fopen(filename.c_str(), "wb");
+    if (file == nullptr)
+        snapshot_error(filename, "cannot open for writing");
+    bool is_written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (!entries.empty())
+        is_written = is_written && std::fwrite(entries.data(), sizeof(t_snapshot_entry), entries.size(), file)
+                                   == entries.size();
+    for (size_t i = 0; i < fields.size() && is_written; i++) {
+        is_written = std::fseek(file, static_cast<long>(entries[i].offset), SEEK_SET) == 0 &&
+                     std::fwrite(fields[i].data, 1, fields[i].bytes, file) == fields[i].bytes;
+    }
+    // the file size covers the padding of the last field
+    is_written = is_written && std::fseek(file, static_cast<long>(offset) - 1, SEEK_SET) == 0 &&
+                 std::fputc(0, file) != EOF;
+    if (std::fclose(file) != 0 || !is_written)
+        snapshot_error(filename, "write failed");
+}
+
+snapshot_reader::snapshot_reader(const std::string &filename, bool writable)
+    : m_mapping(nullptr), m_size(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        snapshot_error(filename, "cannot open");
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(t_snapshot_header))
+        snapshot_error(filename, "not a snapshot");
+    m_size = static_cast<size_t>(file_stat.st_size);
+    int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    m_mapping = mmap(nullptr, m_size, protection, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m_mapping == MAP_FAILED)
+        snapshot_error(filename, "mmap failed");
+
+    const char *base = static_cast<const char *>(m_mapping);
+    t_snapshot_header header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0)
+        snapshot_error(filename, "not a snapshot");
+    if (header.version != snapshot_version)
+        snapshot_error(filename, "unsupported version " + std::to_string(header.version));
+    if (sizeof(header) + header.nfields * sizeof(t_snapshot_entry) > m_size)
+        snapshot_error(filename, "truncated header");
+    m_params = header.params;
+    std::memcpy(&m_range, header.range, sizeof(m_range));
+    m_call = header.call;
+
+    const t_snapshot_entry *entries = reinterpret_cast<const t_snapshot_entry *>(base + sizeof(header));
+    for (uint32_t i = 0; i < header.nfields; i++) {
+        const t_snapshot_entry &entry = entries[i];
+        if (entry.offset + entry.bytes > m_size || entry.ndims < 0 || entry.ndims > snapshot_max_dims)
+            snapshot_error(filename, "truncated field");
+        t_snapshot_field field;
+        field.name = std::string(entry.name, strnlen(entry.name, snapshot_name_length));
+        field.type = static_cast<t_snapshot_type>(entry.type);
+        field.shape.assign(entry.shape, entry.shape + entry.ndims);
+        field.data = static_cast<char *>(m_mapping) + entry.offset;
+        field.bytes = entry.bytes;
+        m_fields.push_back(field);
+    }
+}
+
+snapshot_reader::~snapshot_reader() {
+    munmap(m_mapping, m_size);
+}
+
+const t_snapshot_field *snapshot_reader::find(const std::string &name) const {
+    for (const t_snapshot_field &field : m_fields)
+        if (field.name == name)
+            return &field;
+    return nullptr;
+}
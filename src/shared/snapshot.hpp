@@ -0,0 +1,116 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_SHARED_SNAPSHOT_HPP_
+#define SRC_SHARED_SNAPSHOT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "src/shared/interface/data_struct.hpp"
+
+constexpr int snapshot_max_dims = 4;
+constexpr int snapshot_name_length = 32;
+
+/*! \brief Type of the elements of a snapshot field.
+*
+*/
+enum t_snapshot_type {
+    snapshot_double = 0,
+    snapshot_int = 1,
+};
+
+/*! \brief Constructor parameters of the YAOP instance which produced a snapshot.
+*
+*   dtime and nsubsteps are the ones of the captured step (nsubsteps is 0 in the older snapshots).
+*/
+struct t_snapshot_params {
+    int32_t nproma;
+    int32_t nlevs;
+    int32_t nblocks;
+    int32_t vert_mix_type;
+    int32_t vmix_idemix_tke;
+    int32_t vert_cor_type;
+    int32_t l_lc;
+    int32_t nsubsteps;
+    double dtime;
+    double OceanReferenceDensity;
+    double grav;
+    double clc;
+    double ReferencePressureIndbars;
+    double pi;
+};
+
+/*! \brief One field of a snapshot, the data is not owned.
+*
+*/
+struct t_snapshot_field {
+    std::string name;
+    t_snapshot_type type;
+    std::vector<int> shape;
+    void *data;
+    size_t bytes;
+};
+
+/*! \brief Write the fields and the index ranges of a time step to a binary snapshot.
+*
+*   The file starts with a header (magic, version, constructor parameters, index ranges and the
+*   number of the captured call), followed by a table with name, type, shape, offset and size of
+*   each field and by the raw data of the fields, each aligned to 64 bytes.
+*/
+void snapshot_write(const std::string &filename, const t_snapshot_params &params,
+                    const t_index_range &range, int64_t call,
+                    const std::vector<t_snapshot_field> &fields);
+
+/*! \brief Snapshot mapped in memory.
+*
+*   The file is mapped privately: with writable set the fields can be modified in memory
+*   (for example by a time step) without changing the file.
+*/
+class snapshot_reader {
+ public:
+    snapshot_reader(const std::string &filename, bool writable);
+
+    ~snapshot_reader();
+
+    snapshot_reader(const snapshot_reader &) = delete;
+    snapshot_reader &operator=(const snapshot_reader &) = delete;
+
+    const t_snapshot_params &params() const { return m_params; }
+
+    const t_index_range &range() const { return m_range; }
+
+    int64_t call() const { return m_call; }
+
+    const std::vector<t_snapshot_field> &fields() const { return m_fields; }
+
+    /*! \brief Field with the given name, nullptr if it is not in the snapshot.
+    *
+    */
+    const t_snapshot_field *find(const std::string &name) const;
+
+ private:
+    void *m_mapping;
+    size_t m_size;
+    t_snapshot_params m_params;
+    t_index_range m_range;
+    int64_t m_call;
+    std::vector<t_snapshot_field> m_fields;
+};
+
+#endif  // SRC_SHARED_SNAPSHOT_HPP_
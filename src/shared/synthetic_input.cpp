@@ -0,0 +1,373 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "src/shared/synthetic_input.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include "src/YAOP.hpp"
+
+// Depth of the ocean bottom in the deepest basins [m]
+constexpr double max_depth = 5500.0;
+// Thickness of the surface layer [m]
+constexpr double surface_thickness = 10.0;
+// Earth radius [m] and angular velocity [1/s]
+constexpr double earth_radius = 6.371e6;
+constexpr double earth_angular_velocity = 7.292e-5;
+
+synthetic_input::synthetic_input(int ncells_in, int nlevs_in, int nproma_in)
+    : ncells(ncells_in), nlevs(nlevs_in), nproma(nproma_in), m_memory_size(0) {
+    if (ncells <= 0 || nlevs <= 0 || nproma <= 0) {
+        std::cerr << "YAOP: synthetic input needs positive ncells, nlevs and nproma" << std::endl;
+        abort();
+    }
+
+    // quasi-regular grid: ny rows of nx cells, periodic in longitude, the last row can be partial
+    int ny = std::max(1, static_cast<int>(std::lround(std::sqrt(ncells / 2.0))));
+    int nx = (ncells + ny - 1) / ny;
+    // one edge towards the next cell of the row and one towards the cell of the next row
+    nedges = ncells + std::max(0, ncells - nx);
+    nblocks = (std::max(ncells, nedges) + nproma - 1) / nproma;
+
+    range.cells_block_size = nproma;
+    range.cells_start_block = 0;
+    range.cells_end_block = (ncells - 1) / nproma;
+    range.cells_start_index = 0;
+    range.cells_end_index = (ncells - 1) % nproma;
+    range.edges_block_size = nproma;
+    range.edges_start_block = 0;
+    range.edges_end_block = (nedges - 1) / nproma;
+    range.edges_start_index = 0;
+    range.edges_end_index = (nedges - 1) % nproma;
+
+    size_t size_2d = static_cast<size_t>(nblocks) * nproma;
+    size_t size_3d = size_2d * nlevs;
+    size_t size_3d_i = size_2d * (nlevs + 1);
+
+    p_patch.depth_CellInterface = malloc_double(size_3d_i);
+    p_patch.prism_center_dist_c = malloc_double(size_3d_i);
+    p_patch.inv_prism_center_dist_c = malloc_double(size_3d_i);
+    p_patch.prism_thick_c = malloc_double(size_3d);
+    p_patch.dolic_c = malloc_int(size_2d);
+    p_patch.dolic_e = malloc_int(size_2d);
+    p_patch.zlev_i = malloc_double(nlevs);
+    p_patch.wet_c = malloc_double(size_3d);
+    p_patch.edges_cell_idx = malloc_int(2 * size_2d);
+    p_patch.edges_cell_blk = malloc_int(2 * size_2d);
+
+    p_cvmix.tke = malloc_double(size_3d_i);
+    p_cvmix.tke_plc = malloc_double(size_3d_i);
+    p_cvmix.hlc = malloc_double(size_2d);
+    p_cvmix.wlc = malloc_double(size_3d_i);
+    p_cvmix.u_stokes = malloc_double(size_2d);
+    p_cvmix.a_veloc_v = malloc_double(size_3d_i);
+    p_cvmix.a_temp_v = malloc_double(size_3d_i);
+    p_cvmix.a_salt_v = malloc_double(size_3d_i);
+    p_cvmix.iwe_Tdis = malloc_double(size_3d_i);
+    p_cvmix.cvmix_dummy_1 = malloc_double(size_3d_i);
+    p_cvmix.cvmix_dummy_2 = malloc_double(size_3d_i);
+    p_cvmix.cvmix_dummy_3 = malloc_double(size_3d_i);
+    p_cvmix.tke_Tbpr = malloc_double(size_3d_i);
+    p_cvmix.tke_Tspr = malloc_double(size_3d_i);
+    p_cvmix.tke_Tdif = malloc_double(size_3d_i);
+    p_cvmix.tke_Tdis = malloc_double(size_3d_i);
+    p_cvmix.tke_Twin = malloc_double(size_3d_i);
+    p_cvmix.tke_Tiwf = malloc_double(size_3d_i);
+    p_cvmix.tke_Tbck = malloc_double(size_3d_i);
+    p_cvmix.tke_Ttot = malloc_double(size_3d_i);
+    p_cvmix.tke_Lmix = malloc_double(size_3d_i);
+    p_cvmix.tke_Pr = malloc_double(size_3d_i);
+
+    ocean_state.temp = malloc_double(size_3d);
+    ocean_state.salt = malloc_double(size_3d);
+    ocean_state.stretch_c = malloc_double(size_2d);
+    ocean_state.eta_c = malloc_double(size_2d);
+    ocean_state.p_vn_x1 = malloc_double(size_3d);
+    ocean_state.p_vn_x2 = malloc_double(size_3d);
+    ocean_state.p_vn_x3 = malloc_double(size_3d);
+
+    atmos_fluxes.stress_xw = malloc_double(size_2d);
+    atmos_fluxes.stress_yw = malloc_double(size_2d);
+    p_as.fu10 = malloc_double(size_2d);
+    p_sea_ice.concsum = malloc_double(size_2d);
+
+    p_idemix.iwe = malloc_double(size_3d_i);
+    p_idemix.forc_iw_surface = malloc_double(size_2d);
+    p_idemix.forc_iw_bottom = malloc_double(size_2d);
+    p_horizontal_grid.f_c = malloc_double(size_2d);
+    p_horizontal_grid.cells_area = malloc_double(size_2d);
+    p_horizontal_grid.cells_edge_idx = malloc_int(3 * size_2d);
+    p_horizontal_grid.cells_edge_blk = malloc_int(3 * size_2d);
+    p_horizontal_grid.cells_edge_orientation = malloc_double(3 * size_2d);
+    p_horizontal_grid.edges_primal_edge_length = malloc_double(size_2d);
+    p_horizontal_grid.edges_dual_edge_length = malloc_double(size_2d);
+
+    // vertical grid: thickness growing quadratically from the surface layer to the bottom one
+    std::vector<double> dz(nlevs);
+    double dz_top = std::min(surface_thickness, max_depth / nlevs);
+    double shape_sum = 0.0;
+    for (int level = 0; level < nlevs; level++)
+        shape_sum += nlevs > 1 ? std::pow(static_cast<double>(level) / (nlevs - 1), 2) : 0.0;
+    double dz_growth = shape_sum > 0.0 ? (max_depth - nlevs * dz_top) / shape_sum : 0.0;
+    for (int level = 0; level < nlevs; level++)
+        dz[level] = dz_top + dz_growth * (nlevs > 1 ? std::pow(static_cast<double>(level) / (nlevs - 1), 2) : 0.0);
+
+    std::vector<double> z_interface(nlevs + 1, 0.0);
+    for (int level = 0; level < nlevs; level++)
+        z_interface[level + 1] = z_interface[level] + dz[level];
+    for (int level = 0; level < nlevs; level++)
+        p_patch.zlev_i[level] = z_interface[level];
+
+    std::vector<double> center_dist(nlevs + 1);
+    center_dist[0] = 0.5 * dz[0];
+    center_dist[nlevs] = 0.5 * dz[nlevs - 1];
+    for (int level = 1; level < nlevs; level++)
+        center_dist[level] = 0.5 * (dz[level - 1] + dz[level]);
+
+    const double pi = 3.14159265358979323846;
+    for (int jb = 0; jb < nblocks; jb++) {
+        for (int jc = 0; jc < nproma; jc++) {
+            int cell = jb * nproma + jc;
+            // the padding cells are land and are never computed
+            if (cell >= ncells)
+                continue;
+            size_t idx_2d = static_cast<size_t>(jb) * nproma + jc;
+
+            int row = cell / nx;
+            int row_size = std::min(nx, ncells - row * nx);
+            double lon = 2.0 * pi * ((cell - row * nx) + 0.5) / row_size;
+            double lat = pi * (0.45 - 0.9 * (row + 0.5) / ny);
+
+            // bathymetry: deep basins, mid-ocean ridges and shelves towards the high latitudes
+            double bottom = 0.6 + 0.25 * std::sin(2.0 * lon) * std::cos(3.0 * lat)
+                                + 0.15 * std::cos(5.0 * lon + 2.0 * lat)
+                                - 0.3 * std::pow(std::sin(lat), 4);
+            bottom = max_depth * std::min(1.0, std::max(0.02, bottom));
+            int dolic = 0;
+            while (dolic < nlevs && z_interface[dolic + 1] <= bottom)
+                dolic++;
+            dolic = std::max(std::min(2, nlevs), dolic);
+            p_patch.dolic_c[idx_2d] = dolic;
+
+            // surface forcing: trade winds, westerlies and polar sea ice
+            double tau_x = -0.1 * std::cos(3.0 * lat);
+            double tau_y = 0.01 * std::sin(2.0 * lon) * std::cos(lat);
+            atmos_fluxes.stress_xw[idx_2d] = tau_x;
+            atmos_fluxes.stress_yw[idx_2d] = tau_y;
+            p_as.fu10[idx_2d] = std::max(1.0, std::sqrt(std::hypot(tau_x, tau_y) / (1.2 * 1.3e-3)));
+            double lat_deg = std::fabs(lat) * 180.0 / pi;
+            p_sea_ice.concsum[idx_2d] = std::min(1.0, std::max(0.0, (lat_deg - 65.0) / 10.0));
+            ocean_state.stretch_c[idx_2d] = 1.0;
+            ocean_state.eta_c[idx_2d] = 0.0;
+
+            // internal waves forced by the wind and by the tides over the rough bottom
+            double dlon = 2.0 * pi / row_size;
+            double dlat = 0.9 * pi / ny;
+            p_horizontal_grid.f_c[idx_2d] = 2.0 * earth_angular_velocity * std::sin(lat);
+            p_horizontal_grid.cells_area[idx_2d] = earth_radius * earth_radius * dlon * dlat * std::cos(lat);
+            p_idemix.forc_iw_surface[idx_2d] = 2.0e-3 * std::hypot(tau_x, tau_y) / 1025.0 *
+                                               (1.0 - p_sea_ice.concsum[idx_2d]);
+            p_idemix.forc_iw_bottom[idx_2d] = 1.0e-6 * (1.0 + 0.5 * std::sin(3.0 * lon) * std::cos(2.0 * lat)) *
+                                              (dolic == nlevs ? 1.0 : 0.5);
+
+            double temp_surf = -1.8 + 29.8 * std::pow(std::cos(lat), 2);
+            double salt_surf = 34.0 + 1.5 * std::pow(std::cos(lat), 2);
+            double u_surf = 0.3 * std::cos(3.0 * lat);
+            double v_surf = 0.05 * std::sin(2.0 * lon);
+
+            for (int level = 0; level < nlevs + 1; level++) {
+                size_t idx = (static_cast<size_t>(jb) * (nlevs + 1) + level) * nproma + jc;
+                p_patch.depth_CellInterface[idx] = z_interface[level];
+                p_patch.prism_center_dist_c[idx] = center_dist[level];
+                p_patch.inv_prism_center_dist_c[idx] = 1.0 / center_dist[level];
+                if (level <= dolic) {
+                    p_cvmix.tke[idx] = 1.0e-6 + 1.0e-4 * std::exp(-z_interface[level] / 50.0);
+                    p_idemix.iwe[idx] = 1.0e-3 * std::exp(-z_interface[level] / 1300.0);
+                }
+            }
+
+            for (int level = 0; level < nlevs; level++) {
+                size_t idx = (static_cast<size_t>(jb) * nlevs + level) * nproma + jc;
+                double z = z_interface[level] + 0.5 * dz[level];
+                p_patch.prism_thick_c[idx] = dz[level];
+                p_patch.wet_c[idx] = level < dolic ? 1.0 : 0.0;
+
+                // stratified profiles with a thermocline and a halocline
+                ocean_state.temp[idx] = 1.5 + (temp_surf - 1.5) * std::exp(-z / 700.0);
+                ocean_state.salt[idx] = 34.7 + (salt_surf - 34.7) * std::exp(-z / 500.0);
+
+                // sheared zonal and meridional velocity in cartesian components
+                double u = u_surf * std::exp(-z / 200.0);
+                double v = v_surf * std::exp(-z / 300.0);
+                ocean_state.p_vn_x1[idx] = -u * std::sin(lon) - v * std::sin(lat) * std::cos(lon);
+                ocean_state.p_vn_x2[idx] = u * std::cos(lon) - v * std::sin(lat) * std::sin(lon);
+                ocean_state.p_vn_x3[idx] = v * std::cos(lat);
+            }
+        }
+    }
+
+    // edges: first the ones towards the next cell of the row, then the ones towards the next row
+    size_t edges_offset = static_cast<size_t>(nblocks) * nproma;
+    for (int edge = 0; edge < nedges; edge++) {
+        int cell_1, cell_2;
+        if (edge < ncells) {
+            int row = edge / nx;
+            int row_size = std::min(nx, ncells - row * nx);
+            cell_1 = edge;
+            cell_2 = row * nx + (edge - row * nx + 1) % row_size;
+        } else {
+            cell_1 = edge - ncells;
+            cell_2 = cell_1 + nx;
+        }
+        size_t idx_2d = static_cast<size_t>(edge / nproma) * nproma + edge % nproma;
+        p_patch.edges_cell_idx[idx_2d] = cell_1 % nproma;
+        p_patch.edges_cell_blk[idx_2d] = cell_1 / nproma;
+        p_patch.edges_cell_idx[edges_offset + idx_2d] = cell_2 % nproma;
+        p_patch.edges_cell_blk[edges_offset + idx_2d] = cell_2 / nproma;
+        p_patch.dolic_e[idx_2d] = std::min(p_patch.dolic_c[cell_1], p_patch.dolic_c[cell_2]);
+
+        // lengths of the edge and of the segment between the two cell centers
+        int row = cell_1 / nx;
+        int row_size = std::min(nx, ncells - row * nx);
+        double dlon = 2.0 * pi / row_size;
+        double dlat = 0.9 * pi / ny;
+        double lat = pi * (0.45 - 0.9 * (row + 0.5) / ny);
+        if (edge < ncells) {
+            p_horizontal_grid.edges_primal_edge_length[idx_2d] = earth_radius * dlat;
+            p_horizontal_grid.edges_dual_edge_length[idx_2d] = earth_radius * dlon * std::cos(lat);
+        } else {
+            p_horizontal_grid.edges_primal_edge_length[idx_2d] = earth_radius * dlon * std::cos(lat - 0.5 * dlat);
+            p_horizontal_grid.edges_dual_edge_length[idx_2d] = earth_radius * dlat;
+        }
+    }
+
+    // three edges per cell: towards the previous and the next cell of the row, and towards the next row
+    // or the previous one alternately (brick-wall pattern). The missing edges at the first and at the
+    // last row have no orientation. The flux of an edge enters its first cell and leaves the second one.
+    for (int cell = 0; cell < ncells; cell++) {
+        int row = cell / nx;
+        int col = cell - row * nx;
+        int row_size = std::min(nx, ncells - row * nx);
+        int edges[3] = {cell, row * nx + (col + row_size - 1) % row_size, cell};
+        double orientation[3] = {1.0, -1.0, 0.0};
+        if ((row + col) % 2 == 0 && cell + nx < ncells) {
+            edges[2] = ncells + cell;
+            orientation[2] = 1.0;
+        } else if ((row + col) % 2 == 1 && row > 0) {
+            edges[2] = ncells + cell - nx;
+            orientation[2] = -1.0;
+        }
+        size_t idx_2d = static_cast<size_t>(cell / nproma) * nproma + cell % nproma;
+        for (int i = 0; i < 3; i++) {
+            p_horizontal_grid.cells_edge_idx[i * edges_offset + idx_2d] = edges[i] % nproma;
+            p_horizontal_grid.cells_edge_blk[i * edges_offset + idx_2d] = edges[i] / nproma;
+            p_horizontal_grid.cells_edge_orientation[i * edges_offset + idx_2d] = orientation[i];
+        }
+    }
+}
+
+synthetic_input::~synthetic_input() {
+    for (void *field : m_memory)
+        free(field);
+}
+
+void synthetic_input::register_fields(YAOP *yaop) const {
+    int shape_3d_i[3] = {nblocks, nlevs + 1, nproma};
+    int shape_3d[3] = {nblocks, nlevs, nproma};
+    int shape_2d[2] = {nblocks, nproma};
+    int shape_1d[1] = {nlevs};
+    int shape_edges[3] = {2, nblocks, nproma};
+
+    yaop->register_field("depth_CellInterface", p_patch.depth_CellInterface, 3, shape_3d_i);
+    yaop->register_field("prism_center_dist_c", p_patch.prism_center_dist_c, 3, shape_3d_i);
+    yaop->register_field("inv_prism_center_dist_c", p_patch.inv_prism_center_dist_c, 3, shape_3d_i);
+    yaop->register_field("prism_thick_c", p_patch.prism_thick_c, 3, shape_3d);
+    yaop->register_field("dolic_c", p_patch.dolic_c, 2, shape_2d);
+    yaop->register_field("dolic_e", p_patch.dolic_e, 2, shape_2d);
+    yaop->register_field("zlev_i", p_patch.zlev_i, 1, shape_1d);
+    yaop->register_field("wet_c", p_patch.wet_c, 3, shape_3d);
+    yaop->register_field("edges_cell_idx", p_patch.edges_cell_idx, 3, shape_edges);
+    yaop->register_field("edges_cell_blk", p_patch.edges_cell_blk, 3, shape_edges);
+
+    yaop->register_field("tke", p_cvmix.tke, 3, shape_3d_i);
+    yaop->register_field("tke_plc", p_cvmix.tke_plc, 3, shape_3d_i);
+    yaop->register_field("hlc", p_cvmix.hlc, 2, shape_2d);
+    yaop->register_field("wlc", p_cvmix.wlc, 3, shape_3d_i);
+    yaop->register_field("u_stokes", p_cvmix.u_stokes, 2, shape_2d);
+    yaop->register_field("a_veloc_v", p_cvmix.a_veloc_v, 3, shape_3d_i);
+    yaop->register_field("a_temp_v", p_cvmix.a_temp_v, 3, shape_3d_i);
+    yaop->register_field("a_salt_v", p_cvmix.a_salt_v, 3, shape_3d_i);
+    yaop->register_field("iwe_Tdis", p_cvmix.iwe_Tdis, 3, shape_3d_i);
+    yaop->register_field("cvmix_dummy_1", p_cvmix.cvmix_dummy_1, 3, shape_3d_i);
+    yaop->register_field("cvmix_dummy_2", p_cvmix.cvmix_dummy_2, 3, shape_3d_i);
+    yaop->register_field("cvmix_dummy_3", p_cvmix.cvmix_dummy_3, 3, shape_3d_i);
+    yaop->register_field("tke_Tbpr", p_cvmix.tke_Tbpr, 3, shape_3d_i);
+    yaop->register_field("tke_Tspr", p_cvmix.tke_Tspr, 3, shape_3d_i);
+    yaop->register_field("tke_Tdif", p_cvmix.tke_Tdif, 3, shape_3d_i);
+    yaop->register_field("tke_Tdis", p_cvmix.tke_Tdis, 3, shape_3d_i);
+    yaop->register_field("tke_Twin", p_cvmix.tke_Twin, 3, shape_3d_i);
+    yaop->register_field("tke_Tiwf", p_cvmix.tke_Tiwf, 3, shape_3d_i);
+    yaop->register_field("tke_Tbck", p_cvmix.tke_Tbck, 3, shape_3d_i);
+    yaop->register_field("tke_Ttot", p_cvmix.tke_Ttot, 3, shape_3d_i);
+    yaop->register_field("tke_Lmix", p_cvmix.tke_Lmix, 3, shape_3d_i);
+    yaop->register_field("tke_Pr", p_cvmix.tke_Pr, 3, shape_3d_i);
+
+    yaop->register_field("temp", ocean_state.temp, 3, shape_3d);
+    yaop->register_field("salt", ocean_state.salt, 3, shape_3d);
+    yaop->register_field("stretch_c", ocean_state.stretch_c, 2, shape_2d);
+    yaop->register_field("eta_c", ocean_state.eta_c, 2, shape_2d);
+    yaop->register_field("p_vn_x1", ocean_state.p_vn_x1, 3, shape_3d);
+    yaop->register_field("p_vn_x2", ocean_state.p_vn_x2, 3, shape_3d);
+    yaop->register_field("p_vn_x3", ocean_state.p_vn_x3, 3, shape_3d);
+
+    yaop->register_field("stress_xw", atmos_fluxes.stress_xw, 2, shape_2d);
+    yaop->register_field("stress_yw", atmos_fluxes.stress_yw, 2, shape_2d);
+    yaop->register_field("fu10", p_as.fu10, 2, shape_2d);
+    yaop->register_field("concsum", p_sea_ice.concsum, 2, shape_2d);
+}
+
+void synthetic_input::register_idemix_fields(YAOP *yaop) const {
+    int shape_3d_i[3] = {nblocks, nlevs + 1, nproma};
+    int shape_2d[2] = {nblocks, nproma};
+    int shape_cells_edge[3] = {3, nblocks, nproma};
+
+    yaop->register_field("iwe", p_idemix.iwe, 3, shape_3d_i);
+    yaop->register_field("forc_iw_surface", p_idemix.forc_iw_surface, 2, shape_2d);
+    yaop->register_field("forc_iw_bottom", p_idemix.forc_iw_bottom, 2, shape_2d);
+
+    yaop->register_field("f_c", p_horizontal_grid.f_c, 2, shape_2d);
+    yaop->register_field("cells_area", p_horizontal_grid.cells_area, 2, shape_2d);
+    yaop->register_field("cells_edge_idx", p_horizontal_grid.cells_edge_idx, 3, shape_cells_edge);
+    yaop->register_field("cells_edge_blk", p_horizontal_grid.cells_edge_blk, 3, shape_cells_edge);
+    yaop->register_field("cells_edge_orientation", p_horizontal_grid.cells_edge_orientation, 3, shape_cells_edge);
+    yaop->register_field("edges_primal_edge_length", p_horizontal_grid.edges_primal_edge_length, 2, shape_2d);
+    yaop->register_field("edges_dual_edge_length", p_horizontal_grid.edges_dual_edge_length, 2, shape_2d);
+}
+
+double *synthetic_input::malloc_double(size_t size) {
+    double *field = reinterpret_cast<double *>(calloc(size, sizeof(double)));
+    m_memory.push_back(field);
+    m_memory_size += size * sizeof(double);
+    return field;
+}
+
+int *synthetic_input::malloc_int(size_t size) {
+    int *field = reinterpret_cast<int *>(calloc(size, sizeof(int)));
+    m_memory.push_back(field);
+    m_memory_size += size * sizeof(int);
+    return field;
+}
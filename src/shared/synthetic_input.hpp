@@ -0,0 +1,97 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SHARED_SYNTHETIC_INPUT_HPP_
+#define SRC_SHARED_SYNTHETIC_INPUT_HPP_
+
+#include <cstddef>
+#include <vector>
+#include "src/shared/interface/data_struct.hpp"
+
+class YAOP;
+
+/*! \brief Synthetic global ocean input of the tke scheme.
+ *
+ *  It allocates and fills all the fields for an arbitrary number of cells, vertical levels
+ *  and block size, without external data:
+ *   - a quasi-regular global grid (periodic in longitude) with a consistent cells-edges connectivity
+ *   - a vertical grid with layer thicknesses increasing with depth
+ *   - a bathymetry-like distribution of dolic_c with shelves, ridges and deep basins
+ *   - stratified temperature and salinity profiles depending on latitude
+ *   - sheared velocities, zonal wind stress, wind speed and polar sea ice
+ *   - internal wave energy and its forcing, with a horizontal grid of three edges per cell
+ *     (brick-wall pattern over the rows) for the IDEMIX scheme
+ *  The fields are contiguous in C order with the shapes expected by YAOP::register_field.
+ *  The same number of blocks (enough for the cells and for the edges) is used for all the fields,
+ *  so YAOP has to be created with nblocks.
+ */
+class synthetic_input {
+ public:
+    /*! \brief Allocate and generate the fields.
+     *
+     */
+    synthetic_input(int ncells, int nlevs, int nproma);
+
+    /*! \brief Deallocate the fields.
+     *
+     */
+    ~synthetic_input();
+
+    synthetic_input(const synthetic_input &) = delete;
+    synthetic_input &operator=(const synthetic_input &) = delete;
+
+    /*! \brief Register all the fields in a YAOP instance.
+     *
+     */
+    void register_fields(YAOP *yaop) const;
+
+    /*! \brief Register the IDEMIX fields and the horizontal grid in a YAOP instance.
+     *
+     */
+    void register_idemix_fields(YAOP *yaop) const;
+
+    /*! \brief Memory footprint of the generated fields in bytes.
+     *
+     */
+    size_t memory_size() const { return m_memory_size; }
+
+    int ncells;
+    int nedges;
+    int nlevs;
+    int nproma;
+    int nblocks;
+
+    // Index ranges covering all the cells and all the edges
+    struct t_index_range range;
+
+    struct t_patch p_patch;
+    struct t_cvmix p_cvmix;
+    struct t_ocean_state ocean_state;
+    struct t_atmo_fluxes atmos_fluxes;
+    struct t_atmos_for_ocean p_as;
+    struct t_sea_ice p_sea_ice;
+    struct t_idemix p_idemix;
+    struct t_horizontal_grid p_horizontal_grid;
+
+ private:
+    double *malloc_double(size_t size);
+    int *malloc_int(size_t size);
+
+    std::vector<void *> m_memory;
+    size_t m_memory_size;
+};
+
+#endif  // SRC_SHARED_SYNTHETIC_INPUT_HPP_
@@ -0,0 +1,87 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "src/shared/timing.hpp"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+void timing_reset(struct t_timing_report *report) {
+#ifdef YAOP_TIMING
+    report->enabled = 1;
+#else
+    report->enabled = 0;
+#endif
+    report->counters_enabled = 0;
+    report->ncalls = 0;
+    report->total_seconds = 0.0;
+    for (int stage = 0; stage < timing_nstages; stage++) {
+        report->seconds[stage] = 0.0;
+        report->count[stage] = 0;
+        for (int counter = 0; counter < perf_ncounters; counter++)
+            report->counters[stage][counter] = 0;
+    }
+}
+
+void timing_merge(struct t_timing_report *report, const struct t_timing_report &other) {
+    report->counters_enabled |= other.counters_enabled;
+    report->ncalls += other.ncalls;
+    report->total_seconds += other.total_seconds;
+    for (int stage = 0; stage < timing_nstages; stage++) {
+        report->seconds[stage] += other.seconds[stage];
+        report->count[stage] += other.count[stage];
+        for (int counter = 0; counter < perf_ncounters; counter++)
+            report->counters[stage][counter] += other.counters[stage][counter];
+    }
+}
+
+const char *timing_stage_name(int stage) {
+    static const char *names[trace_nevents] = {"view_init", "pre_integration", "nsqr_ssqr", "mixing_length",
+                                               "diffusivity", "forcing", "tridiag_build", "solve",
+                                               "diagnostics", "edges", "idemix", "cells_block", "call"};
+    if (stage < 0 || stage >= trace_nevents)
+        return "unknown";
+    return names[stage];
+}
+
+void trace_write(const std::string &filename, const std::vector<t_thread_timers> &timers,
+                 std::chrono::steady_clock::time_point origin) {
+    std::ofstream ofile(filename);
+    if (!ofile) {
+        std::cerr << "YAOP: cannot write the trace file " << filename << std::endl;
+        return;
+    }
+
+    // complete events ("X") with timestamps and durations in microseconds
+    ofile << std::fixed << std::setprecision(3);
+    ofile << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+    bool is_first = true;
+    for (size_t thread = 0; thread < timers.size(); thread++) {
+        ofile << (is_first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": "
+              << thread << ", \"args\": {\"name\": \"thread " << thread << "\"}}";
+        is_first = false;
+        const trace_buffer &trace = timers[thread].trace;
+        for (size_t i = 0; i < trace.size(); i++) {
+            const t_trace_event &event = trace[i];
+            double begin = std::chrono::duration<double, std::micro>(event.begin - origin).count();
+            double duration = std::chrono::duration<double, std::micro>(event.end - event.begin).count();
+            ofile << ",\n{\"name\": \"" << timing_stage_name(event.kind) << "\", \"cat\": \"tke\", "
+                  << "\"ph\": \"X\", \"pid\": 0, \"tid\": " << thread << ", \"ts\": " << begin
+                  << ", \"dur\": " << duration << ", \"args\": {\"block\": " << event.block << "}}";
+        }
+    }
+    ofile << std::endl << "]}" << std::endl;
+}
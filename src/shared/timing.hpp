@@ -0,0 +1,187 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SHARED_TIMING_HPP_
+#define SRC_SHARED_TIMING_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "src/shared/interface/data_struct.hpp"
+#include "src/shared/perf_counters.hpp"
+
+// Stage timers, compiled only with YAOP_TIMING (ENABLE_TIMING in cmake) or YAOP_TRACING
+// (ENABLE_TRACING in cmake). Without them the macros expand to nothing and the timers
+// pointers are never used.
+#if defined(YAOP_TIMING) || defined(YAOP_TRACING)
+#define YAOP_TIMER_START(timer, timers) t_timer_start timer = timing_start(timers)
+#define YAOP_TIMER_STOP(timer, timers, stage) timing_add(timers, stage, timer)
+#else
+#define YAOP_TIMER_START(timer, timers)
+#define YAOP_TIMER_STOP(timer, timers, stage)
+#endif
+
+// Timeline only events (whole blocks and calls), compiled only with YAOP_TRACING
+#ifdef YAOP_TRACING
+#define YAOP_TRACE_START(timer) YAOP_TIMER_START(timer, nullptr)
+#define YAOP_TRACE_STOP(timer, timers, event) timing_add(timers, event, timer)
+#else
+#define YAOP_TRACE_START(timer)
+#define YAOP_TRACE_STOP(timer, timers, event)
+#endif
+
+// Events of the timeline which are not stages of the timing report
+enum t_trace_event_kind {
+    trace_cells_block = timing_nstages,
+    trace_call,
+    trace_nevents
+};
+
+/*! \brief Event of the execution timeline: one stage (or block, or call) on one thread.
+*
+*/
+struct t_trace_event {
+    int kind;
+    int block;
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::time_point end;
+};
+
+/*! \brief Fixed capacity ring buffer of trace events.
+*
+*   Each buffer is written by a single thread, so no synchronization is needed. When it is full
+*   the oldest events are overwritten. It is read outside of the parallel regions.
+*/
+class trace_buffer {
+ public:
+    void reserve(size_t capacity) {
+        if (m_events.size() < capacity)
+            m_events.resize(capacity);
+    }
+
+    void push(const t_trace_event &event) {
+        if (m_events.empty())
+            return;
+        m_events[m_next % m_events.size()] = event;
+        m_next++;
+    }
+
+    // Number of stored events
+    size_t size() const { return m_next < m_events.size() ? m_next : m_events.size(); }
+
+    // Stored event, from the oldest one
+    const t_trace_event &operator[](size_t i) const {
+        size_t first = m_next < m_events.size() ? 0 : m_next % m_events.size();
+        return m_events[(first + i) % m_events.size()];
+    }
+
+    void clear() { m_next = 0; }
+
+ private:
+    std::vector<t_trace_event> m_events;
+    size_t m_next = 0;
+};
+
+/*! \brief Timers of one thread: stage timers, hardware counters, block being computed and timeline.
+*
+*/
+struct t_thread_timers {
+    struct t_timing_report report;
+    perf_counters counters;
+    int block;
+    trace_buffer trace;
+};
+
+/*! \brief Start of a timer: time and, when they are collected, hardware counters of the thread.
+*
+*/
+struct t_timer_start {
+    std::chrono::steady_clock::time_point time;
+    bool has_counters;
+    long long counters[perf_ncounters];
+};
+
+/*! \brief Start a timer of a thread (timers can be null for the timeline only events).
+*
+*/
+inline t_timer_start timing_start([[maybe_unused]] struct t_thread_timers *timers) {
+    t_timer_start start;
+    start.has_counters = false;
+#ifdef YAOP_TIMING
+    if (timers != nullptr)
+        start.has_counters = timers->counters.read(start.counters);
+#endif
+    start.time = std::chrono::steady_clock::now();
+    return start;
+}
+
+/*! \brief Add the time elapsed since start to a stage (or timeline event) of the timers of a thread.
+*
+*   Each thread accumulates in its own timers, which can be null when timing is not needed. The
+*   hardware counters are accumulated only for the stages.
+*/
+inline void timing_add([[maybe_unused]] struct t_thread_timers *timers, [[maybe_unused]] int kind,
+                       [[maybe_unused]] const t_timer_start &start) {
+#if defined(YAOP_TIMING) || defined(YAOP_TRACING)
+    if (timers == nullptr)
+        return;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+#endif
+#ifdef YAOP_TIMING
+    if (kind < timing_nstages) {
+        timers->report.seconds[kind] += std::chrono::duration<double>(end - start.time).count();
+        timers->report.count[kind]++;
+        long long counters[perf_ncounters];
+        if (start.has_counters && timers->counters.read(counters)) {
+            timers->report.counters_enabled = timers->counters.available();
+            for (int counter = 0; counter < perf_ncounters; counter++)
+                if (timers->report.counters_enabled & (1 << counter))
+                    timers->report.counters[kind][counter] += counters[counter] - start.counters[counter];
+        }
+    } else if (kind == trace_call) {
+        timers->report.total_seconds += std::chrono::duration<double>(end - start.time).count();
+        timers->report.ncalls++;
+    }
+#endif
+#ifdef YAOP_TRACING
+    timers->trace.push({kind, timers->block, start.time, end});
+#endif
+}
+
+/*! \brief Reset a timing report.
+*
+*/
+void timing_reset(struct t_timing_report *report);
+
+/*! \brief Add the timers of a timing report to another one.
+*
+*/
+void timing_merge(struct t_timing_report *report, const struct t_timing_report &other);
+
+/*! \brief Name of a stage of the timing report or of an event of the timeline.
+*
+*/
+const char *timing_stage_name(int stage);
+
+/*! \brief Write the timelines of all the threads as Chrome trace JSON.
+*
+*   The timestamps are relative to origin. The file can be opened in chrome://tracing or Perfetto.
+*/
+void trace_write(const std::string &filename, const std::vector<t_thread_timers> &timers,
+                 std::chrono::steady_clock::time_point origin);
+
+#endif  // SRC_SHARED_TIMING_HPP_
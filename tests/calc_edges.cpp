@@ -0,0 +1,128 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include "src/backends/CPU/cpu_kernels.hpp"
+#include "src/shared/utils.hpp"
+
+// Test the edges pass on the gather table, with and without the edges computed after the cells of their
+// block, against the one on the cell indices and blocks. The edges range starts and ends inside a block,
+// the edges outside of it are not written
+TEST(calc_edges, gather_and_fused_2D) {
+    int nblocks = 4;
+    int nproma = 5;
+    int nlevs = 6;
+    t_constant p_constant = {};
+    p_constant.nblocks = nblocks;
+    p_constant.nproma = nproma;
+    p_constant.nlevs = nlevs;
+    t_index_range range = {nproma, 0, nblocks-1, 2, 1, nproma, 0, nblocks-1, 0, nproma-1};
+
+    t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch;
+    t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix;
+    t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal;
+    t_edge_gather_view<cpu_memview::mdspan, cpu_memview::dextents> p_gather;
+    p_patch.dolic_e = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks, nproma);
+    p_patch.edges_cell_idx = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), 2, nblocks, nproma);
+    p_patch.edges_cell_blk = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), 2, nblocks, nproma);
+    p_internal.tke_Av = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nlevs+1, nproma);
+    mdspan_3d_double a_veloc_v_ref = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                     nlevs+1, nproma);
+    p_cvmix.a_veloc_v = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nlevs+1, nproma);
+    p_gather.cell_offset = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), 2, nblocks, nproma);
+    p_gather.fused_block = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks, nproma);
+    p_gather.fused_start = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks+1);
+    p_gather.fused_edges = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks * nproma);
+
+    // one edge out of three connects two blocks, the last edge has undefined neighbours
+    for (int jb = 0; jb < nblocks; jb++) {
+        for (int je = 0; je < nproma; je++) {
+            int edge = jb * nproma + je;
+            p_patch.edges_cell_idx(0, jb, je) = je;
+            p_patch.edges_cell_blk(0, jb, je) = jb;
+            p_patch.edges_cell_idx(1, jb, je) = (je + 2) % nproma;
+            p_patch.edges_cell_blk(1, jb, je) = edge % 3 == 0 ? (jb + 1) % nblocks : jb;
+            p_patch.dolic_e(jb, je) = 1 + edge % nlevs;
+            for (int level = 0; level < nlevs+1; level++)
+                p_internal.tke_Av(jb, level, je) = 1.0 + edge + 0.1 * level;
+        }
+    }
+    p_patch.edges_cell_idx(1, nblocks-1, nproma-1) = -1;
+    p_patch.edges_cell_blk(1, nblocks-1, nproma-1) = 1 << 30;
+
+    init_edge_gather(p_patch, p_gather, p_constant);
+    EXPECT_EQ(p_gather.cell_offset(1, 0, 0), (nlevs+1) * nproma + 2);
+    EXPECT_EQ(p_gather.fused_block(0, 0), -1);
+    EXPECT_EQ(p_gather.fused_block(0, 1), 0);
+    EXPECT_EQ(p_gather.fused_block(nblocks-1, nproma-1), -1);
+    EXPECT_EQ(p_gather.fused_start(nblocks), 12);
+    for (int cell_blk = 0; cell_blk < nblocks; cell_blk++)
+        for (int i = p_gather.fused_start(cell_blk); i < p_gather.fused_start(cell_blk+1); i++)
+            EXPECT_EQ(p_gather.fused_block(p_gather.fused_edges(i) / nproma, p_gather.fused_edges(i) % nproma),
+                      cell_blk);
+
+    for (int jb = 0; jb < nblocks; jb++)
+        for (int level = 0; level < nlevs+1; level++)
+            for (int je = 0; je < nproma; je++)
+                a_veloc_v_ref(jb, level, je) = -1.0;
+    p_cvmix.a_veloc_v = a_veloc_v_ref;
+    for (int jb = range.edges_start_block; jb <= range.edges_end_block; jb++) {
+        int start_index, end_index;
+        get_index_range(range.edges_block_size, range.edges_start_block, range.edges_end_block,
+                        range.edges_start_index, range.edges_end_index, jb, &start_index, &end_index);
+        calc_impl_edges(jb, start_index, end_index, p_patch, p_cvmix, p_internal, p_constant);
+    }
+
+    for (int fuse = 0; fuse < 2; fuse++) {
+        mdspan_3d_double a_veloc_v = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                     nlevs+1, nproma);
+        for (int jb = 0; jb < nblocks; jb++)
+            for (int level = 0; level < nlevs+1; level++)
+                for (int je = 0; je < nproma; je++)
+                    a_veloc_v(jb, level, je) = -1.0;
+        p_cvmix.a_veloc_v = a_veloc_v;
+        if (fuse)
+            for (int jb = range.cells_start_block; jb <= range.cells_end_block; jb++)
+                calc_fused_edges(jb, range, p_patch, p_cvmix, p_internal, p_gather, p_constant);
+        for (int jb = range.edges_start_block; jb <= range.edges_end_block; jb++) {
+            int start_index, end_index;
+            get_index_range(range.edges_block_size, range.edges_start_block, range.edges_end_block,
+                            range.edges_start_index, range.edges_end_index, jb, &start_index, &end_index);
+            calc_impl_edges_gather(jb, start_index, end_index, fuse ? range.cells_start_block : 0,
+                                   fuse ? range.cells_end_block : -1, p_patch, p_cvmix, p_internal,
+                                   p_gather, p_constant);
+        }
+
+        for (int jb = 0; jb < nblocks; jb++)
+            for (int level = 0; level < nlevs+1; level++)
+                for (int je = 0; je < nproma; je++)
+                    EXPECT_EQ(a_veloc_v(jb, level, je), a_veloc_v_ref(jb, level, je));
+        free(a_veloc_v.data_handle());
+    }
+    EXPECT_EQ(a_veloc_v_ref(0, 1, 1), -1.0);
+    EXPECT_DOUBLE_EQ(a_veloc_v_ref(0, 1, 2), 4.1);
+    EXPECT_EQ(a_veloc_v_ref(0, 5, 3), 0.0);
+
+    free(p_patch.dolic_e.data_handle());
+    free(p_patch.edges_cell_idx.data_handle());
+    free(p_patch.edges_cell_blk.data_handle());
+    free(p_internal.tke_Av.data_handle());
+    free(a_veloc_v_ref.data_handle());
+    free(p_gather.cell_offset.data_handle());
+    free(p_gather.fused_block.data_handle());
+    free(p_gather.fused_start.data_handle());
+    free(p_gather.fused_edges.data_handle());
+}
@@ -0,0 +1,221 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "src/backends/CPU/cpu_kernels.hpp"
+
+// Columns of different depths with a stratification decreasing with depth
+class calc_idemix_test : public ::testing::Test {
+ protected:
+    static const int nlevs = 5;
+    static const int nproma = 3;
+
+    void SetUp() override {
+        p_constant.nlevs = nlevs;
+        p_constant.nproma = nproma;
+        p_constant.dtime = 3600.0;
+        p_constant.pi = 3.14159265358979323846;
+        p_constant_idemix.tau_v = 86400.0;
+        p_constant_idemix.tau_h = 1296000.0;
+        p_constant_idemix.gamma = 1.57;
+        p_constant_idemix.jstar = 5.0;
+        p_constant_idemix.mu0 = 4.0 / 3.0;
+
+        p_patch.dolic_c = malloc_int(1, nproma);
+        p_idemix.iwe = malloc_double(1, nlevs+1, nproma);
+        p_idemix.forc_iw_surface = malloc_double(1, nproma);
+        p_idemix.forc_iw_bottom = malloc_double(1, nproma);
+        p_grid.f_c = malloc_double(1, nproma);
+        p_geometry.dzw_stretched = malloc_double(1, nlevs, nproma);
+        p_geometry.dzt_stretched = malloc_double(1, nlevs+1, nproma);
+        p_geometry.max_levels = malloc_int(1);
+        p_stability.Nsqr = malloc_double(1, nlevs+1, nproma);
+        p_idemix_internal.bN0 = malloc_double(nproma);
+        p_idemix_internal.c0 = malloc_double(nlevs+1, nproma);
+        p_idemix_internal.alpha_c = malloc_double(nlevs+1, nproma);
+        p_idemix_internal.iwe_old = malloc_double(nlevs+1, nproma);
+        p_idemix_internal.iwe_Tdis = malloc_double(nlevs+1, nproma);
+        p_idemix_internal.v0 = malloc_double(1, nlevs+1, nproma);
+        p_internal.a_tri = malloc_double(nlevs+1, nproma);
+        p_internal.b_tri = malloc_double(nlevs+1, nproma);
+        p_internal.c_tri = malloc_double(nlevs+1, nproma);
+        p_internal.d_tri = malloc_double(nlevs+1, nproma);
+        p_internal.cp = malloc_double(nlevs+1, nproma);
+        p_internal.dp = malloc_double(nlevs+1, nproma);
+
+        int dolic[nproma] = {0, 2, nlevs};
+        double dz[nlevs] = {10.0, 20.0, 40.0, 80.0, 160.0};
+        p_geometry.max_levels(0) = nlevs;
+        for (int jc = 0; jc < nproma; jc++) {
+            p_patch.dolic_c(0, jc) = dolic[jc];
+            p_idemix.forc_iw_surface(0, jc) = 1.0e-6;
+            p_idemix.forc_iw_bottom(0, jc) = 2.0e-6;
+            p_grid.f_c(0, jc) = 1.0e-4;
+            for (int level = 0; level < nlevs; level++)
+                p_geometry.dzw_stretched(0, level, jc) = dz[level];
+            for (int level = 0; level < nlevs+1; level++) {
+                p_geometry.dzt_stretched(0, level, jc) = level == 0 ? 0.5 * dz[0] : level == nlevs ?
+                    0.5 * dz[nlevs-1] : 0.5 * (dz[level-1] + dz[level]);
+                p_stability.Nsqr(0, level, jc) = level > 0 && level < dolic[jc] ? 1.0e-5 / level : 0.0;
+                p_idemix.iwe(0, level, jc) = level <= dolic[jc] ? 1.0e-3 / (level + 1) : 0.0;
+            }
+        }
+    }
+
+    void TearDown() override {
+        for (double *field : m_memory)
+            free(field);
+        for (int *field : m_memory_int)
+            free(field);
+    }
+
+    // zero initialized arrays, released in TearDown
+    mdspan_1d_double malloc_double(int dim1) {
+        mdspan_1d_double view = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), dim1);
+        std::fill_n(view.data_handle(), dim1, 0.0);
+        m_memory.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_2d_double malloc_double(int dim1, int dim2) {
+        mdspan_2d_double view = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), dim1, dim2);
+        std::fill_n(view.data_handle(), dim1 * dim2, 0.0);
+        m_memory.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_3d_double malloc_double(int dim1, int dim2, int dim3) {
+        mdspan_3d_double view = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), dim1, dim2, dim3);
+        std::fill_n(view.data_handle(), dim1 * dim2 * dim3, 0.0);
+        m_memory.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_1d_int malloc_int(int dim1) {
+        mdspan_1d_int view = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), dim1);
+        std::fill_n(view.data_handle(), dim1, 0);
+        m_memory_int.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_2d_int malloc_int(int dim1, int dim2) {
+        mdspan_2d_int view = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), dim1, dim2);
+        std::fill_n(view.data_handle(), dim1 * dim2, 0);
+        m_memory_int.push_back(view.data_handle());
+        return view;
+    }
+    mdspan_3d_int malloc_int(int dim1, int dim2, int dim3) {
+        mdspan_3d_int view = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), dim1, dim2, dim3);
+        std::fill_n(view.data_handle(), dim1 * dim2 * dim3, 0);
+        m_memory_int.push_back(view.data_handle());
+        return view;
+    }
+
+    t_constant p_constant;
+    t_constant_idemix p_constant_idemix;
+    t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch;
+    t_idemix_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix;
+    t_horizontal_grid_view<cpu_memview::mdspan, cpu_memview::dextents> p_grid;
+    t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry;
+    t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability;
+    t_idemix_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_idemix_internal;
+    t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal;
+    std::vector<double *> m_memory;
+    std::vector<int *> m_memory_int;
+};
+
+// Test that the vertical propagation conserves the energy: the change of the column energy is the
+// forcing plus the dissipation
+TEST_F(calc_idemix_test, vertical_energy_budget) {
+    std::vector<double> iwe_old((nlevs+1) * nproma);
+    for (int level = 0; level < nlevs+1; level++)
+        for (int jc = 0; jc < nproma; jc++)
+            iwe_old[level * nproma + jc] = p_idemix.iwe(0, level, jc);
+
+    calc_idemix_vertical(0, 0, nproma-1, p_patch, p_idemix, p_grid, p_geometry, p_stability,
+                         p_idemix_internal, p_internal, p_constant, p_constant_idemix);
+
+    for (int jc = 1; jc < nproma; jc++) {
+        double energy_change = 0.0;
+        double dissipation = 0.0;
+        for (int level = 0; level <= p_patch.dolic_c(0, jc); level++) {
+            double dzt = p_geometry.dzt_stretched(0, level, jc);
+            energy_change += dzt * (p_idemix.iwe(0, level, jc) - iwe_old[level * nproma + jc]);
+            dissipation += dzt * p_idemix_internal.iwe_Tdis(level, jc);
+            EXPECT_LE(p_idemix_internal.iwe_Tdis(level, jc), 0.0) << "level " << level << " column " << jc;
+        }
+        double budget = p_constant.dtime * (p_idemix.forc_iw_surface(0, jc) + p_idemix.forc_iw_bottom(0, jc) +
+                                            dissipation);
+        EXPECT_NEAR(energy_change, budget, 1.0e-12 * fabs(budget)) << "column " << jc;
+        EXPECT_LT(dissipation, 0.0) << "column " << jc;
+    }
+
+    // the land column is not modified and has no dissipation
+    for (int level = 0; level < nlevs+1; level++) {
+        EXPECT_EQ(p_idemix.iwe(0, level, 0), iwe_old[level * nproma]);
+        EXPECT_EQ(p_idemix_internal.iwe_Tdis(level, 0), 0.0);
+    }
+}
+
+// Test that the horizontal propagation between two cells of different area conserves the energy
+// and moves it towards the cell with lower energy
+TEST_F(calc_idemix_test, horizontal_conservation) {
+    p_patch.dolic_e = malloc_int(1, 1);
+    p_patch.edges_cell_idx = malloc_int(2, 1, 1);
+    p_patch.edges_cell_blk = malloc_int(2, 1, 1);
+    p_grid.cells_area = malloc_double(1, nproma);
+    p_grid.cells_edge_idx = malloc_int(3, 1, nproma);
+    p_grid.cells_edge_blk = malloc_int(3, 1, nproma);
+    p_grid.cells_edge_orientation = malloc_double(3, 1, nproma);
+    p_grid.edges_primal_edge_length = malloc_double(1, 1);
+    p_grid.edges_dual_edge_length = malloc_double(1, 1);
+    p_idemix_internal.flux_h = malloc_double(1, nlevs+1, 1);
+
+    // one edge from the deepest column (first cell) to the intermediate one (second cell)
+    p_patch.dolic_e(0, 0) = 2;
+    p_patch.edges_cell_idx(0, 0, 0) = 2;
+    p_patch.edges_cell_idx(1, 0, 0) = 1;
+    p_grid.edges_primal_edge_length(0, 0) = 1.0e4;
+    p_grid.edges_dual_edge_length(0, 0) = 2.0e4;
+    p_grid.cells_area(0, 1) = 1.0e8;
+    p_grid.cells_area(0, 2) = 3.0e8;
+    p_grid.cells_edge_orientation(0, 0, 1) = -1.0;
+    p_grid.cells_edge_orientation(0, 0, 2) = 1.0;
+    for (int level = 0; level < nlevs+1; level++) {
+        for (int jc = 0; jc < nproma; jc++) {
+            p_idemix_internal.v0(0, level, jc) = level <= p_patch.dolic_c(0, jc) ? 0.1 : 0.0;
+            p_idemix.iwe(0, level, jc) = level <= p_patch.dolic_c(0, jc) ? 1.0e-3 * (jc + 1) : 0.0;
+        }
+    }
+
+    calc_idemix_edges(0, 0, 0, p_patch, p_idemix, p_grid, p_idemix_internal, p_constant, p_constant_idemix);
+    calc_idemix_horizontal(0, 0, nproma-1, p_patch, p_idemix, p_grid, p_idemix_internal, p_constant);
+
+    for (int level = 0; level < nlevs+1; level++) {
+        double iwe_1 = level <= 2 ? 2.0e-3 : 0.0;
+        double iwe_2 = 3.0e-3;
+        double energy_old = p_grid.cells_area(0, 1) * iwe_1 + p_grid.cells_area(0, 2) * iwe_2;
+        double energy_new = p_grid.cells_area(0, 1) * p_idemix.iwe(0, level, 1) +
+                            p_grid.cells_area(0, 2) * p_idemix.iwe(0, level, 2);
+        EXPECT_NEAR(energy_new, energy_old, 1.0e-12 * energy_old) << "level " << level;
+        if (level <= 2) {
+            EXPECT_GT(p_idemix.iwe(0, level, 1), iwe_1) << "level " << level;
+            EXPECT_LT(p_idemix.iwe(0, level, 2), iwe_2) << "level " << level;
+        } else {
+            // below the edge bottom there is no exchange
+            EXPECT_EQ(p_idemix.iwe(0, level, 2), iwe_2) << "level " << level;
+        }
+    }
+}
@@ -0,0 +1,139 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include "src/backends/CPU/cpu_kernels.hpp"
+
+// Test the depth of the Langmuir cells and their production term on columns with the same
+// stratification and different Stokes drift: the cells are deeper for a stronger drift and
+// reach at most the bottom, without drift they stop at the first interface
+TEST(calc_langmuir, depth_and_production_1D) {
+    int nblocks = 1;
+    int nproma = 4;
+    int blockNo = 0;
+    int start_index = 0;
+    int end_index = nproma-1;
+    int nlevs = 4;
+    int max_levels = nlevs;
+    double c_stokes = 0.016;
+    double clc = 0.15;
+    double pi = M_PI;
+    int dolic[4] = {nlevs, nlevs, nlevs, 2};
+    double fu10[4] = {10.0, 10.0, 100.0, 100.0};
+    double concsum[4] = {0.0, 1.0, 0.0, 0.0};
+    double depth[5] = {0.0, 10.0, 30.0, 70.0, 150.0};
+    double dzt[5] = {0.0, 10.0, 20.0, 40.0, 80.0};
+
+    mdspan_2d_int dolic_c = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks, nproma);
+    mdspan_2d_double fu10_2D = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nproma);
+    mdspan_2d_double concsum_2D = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nproma);
+    mdspan_2d_double u_stokes = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nproma);
+    mdspan_2d_double hlc = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nproma);
+    mdspan_1d_double pot_energy = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nproma);
+    mdspan_3d_double depth_CellInterface = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                           nlevs+1, nproma);
+    mdspan_3d_double tke_Av = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                              nlevs+1, nproma);
+    mdspan_3d_double tke_Tspr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                nlevs+1, nproma);
+    mdspan_3d_double tke_Tbpr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                nlevs+1, nproma);
+    mdspan_3d_double wlc = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nlevs+1, nproma);
+    mdspan_3d_double tke_plc = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                               nlevs+1, nproma);
+    mdspan_3d_double tke_Tiwf = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                nlevs+1, nproma);
+    mdspan_2d_double dzt_stretched = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+    mdspan_2d_double Nsqr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+    mdspan_2d_double Ssqr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+    mdspan_2d_double tke_kv = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+    mdspan_2d_double forc = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+
+    // no shear and no buoyancy flux, the forcing is only the Langmuir production
+    for (int jc = 0; jc < nproma; jc++) {
+        dolic_c(0, jc) = dolic[jc];
+        fu10_2D(0, jc) = fu10[jc];
+        concsum_2D(0, jc) = concsum[jc];
+        for (int level = 0; level < nlevs+1; level++) {
+            depth_CellInterface(0, level, jc) = depth[level];
+            dzt_stretched(level, jc) = dzt[level];
+            Nsqr(level, jc) = 1.0e-4;
+            Ssqr(level, jc) = 0.0;
+            tke_Av(0, level, jc) = 0.0;
+            tke_kv(level, jc) = 0.0;
+            tke_Tiwf(0, level, jc) = 0.0;
+            wlc(0, level, jc) = -1.0;
+            tke_plc(0, level, jc) = -1.0;
+            forc(level, jc) = 0.0;
+        }
+    }
+
+    calc_langmuir_depth(blockNo, start_index, end_index, max_levels, c_stokes,
+                        dolic_c, depth_CellInterface, dzt_stretched, Nsqr, fu10_2D, concsum_2D,
+                        u_stokes, hlc, pot_energy);
+
+    // the potential energy at the interfaces is 0.01, 0.07, 0.35 and 1.55
+    EXPECT_DOUBLE_EQ(u_stokes(0, 0), 0.16);
+    EXPECT_EQ(hlc(0, 0), 30.0);
+    EXPECT_EQ(u_stokes(0, 1), 0.0);
+    EXPECT_EQ(hlc(0, 1), 10.0);
+    EXPECT_DOUBLE_EQ(u_stokes(0, 2), 1.6);
+    EXPECT_EQ(hlc(0, 2), 150.0);
+    EXPECT_EQ(hlc(0, 3), 30.0);
+
+    calc_forcing(blockNo, start_index, end_index, max_levels, true, true, clc, pi,
+                 dolic_c, Ssqr, Nsqr, tke_Av, tke_kv, tke_Tspr, tke_Tbpr,
+                 depth_CellInterface, hlc, u_stokes, wlc, tke_plc, tke_Tiwf, forc);
+
+    for (int jc = 0; jc < nproma; jc++) {
+        for (int level = 0; level < dolic[jc]+1; level++) {
+            double wlc_ref = 0.0;
+            if (depth[level] < hlc(0, jc))
+                wlc_ref = clc * u_stokes(0, jc) * sin(pi * depth[level] / hlc(0, jc));
+            EXPECT_DOUBLE_EQ(wlc(0, level, jc), wlc_ref);
+            EXPECT_DOUBLE_EQ(tke_plc(0, level, jc), pow(wlc_ref, 3.0) / hlc(0, jc));
+            EXPECT_EQ(forc(level, jc), tke_plc(0, level, jc));
+        }
+        // below the bottom nothing is written
+        for (int level = dolic[jc]+1; level < nlevs+1; level++)
+            EXPECT_EQ(tke_plc(0, level, jc), -1.0);
+    }
+    // the production is positive only inside the cells
+    EXPECT_GT(tke_plc(0, 1, 0), 0.0);
+    EXPECT_EQ(tke_plc(0, 2, 0), 0.0);
+    EXPECT_GT(tke_plc(0, 3, 2), 0.0);
+
+    free(dolic_c.data_handle());
+    free(fu10_2D.data_handle());
+    free(concsum_2D.data_handle());
+    free(u_stokes.data_handle());
+    free(hlc.data_handle());
+    free(pot_energy.data_handle());
+    free(depth_CellInterface.data_handle());
+    free(tke_Av.data_handle());
+    free(tke_Tspr.data_handle());
+    free(tke_Tbpr.data_handle());
+    free(wlc.data_handle());
+    free(tke_plc.data_handle());
+    free(tke_Tiwf.data_handle());
+    free(dzt_stretched.data_handle());
+    free(Nsqr.data_handle());
+    free(Ssqr.data_handle());
+    free(tke_kv.data_handle());
+    free(forc.data_handle());
+}
@@ -0,0 +1,172 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include "src/backends/CPU/cpu_kernels.hpp"
+
+// Test single point with single vertical level
+TEST(calculate_mxl_3, min_val_0D) {
+    int nblocks = 1;
+    int nproma = 1;
+    int blockNo = 0;
+    int start_index = 0;
+    int end_index = 0;
+    int max_levels = 1;
+    double mxl_min = 0.01;
+
+    // Allocate memory and create memview objs
+    mdspan_2d_int dolic_c = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks, nproma);
+    mdspan_3d_double tke_Lmix = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                max_levels+1, nproma);
+    mdspan_3d_double depth_CellInterface = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                           max_levels+1, nproma);
+
+    // Initialize arrays
+    for (int jb = 0; jb < nblocks; jb++)
+        for (int jc = 0; jc < nproma; jc++)
+            dolic_c(jb, jc) = max_levels;
+
+    for (int jb = 0; jb < nblocks; jb++) {
+        for (int level = 0; level < max_levels+1; level++) {
+            for (int jc = 0; jc < nproma; jc++) {
+                tke_Lmix(jb, level, jc) = 0.0;
+                depth_CellInterface(jb, level, jc) = static_cast<double>(level);
+            }
+        }
+    }
+
+    // compute mixing length scale
+    calc_mxl_3(blockNo, start_index, end_index, max_levels, mxl_min,
+               dolic_c, tke_Lmix, depth_CellInterface);
+
+    // checks
+    for (int jb = 0; jb < nblocks; jb++)
+        for (int level = 0; level < max_levels+1; level++)
+            for (int jc = 0; jc < nproma; jc++)
+                ASSERT_EQ(tke_Lmix(jb, level, jc), mxl_min);
+
+    free(dolic_c.data_handle());
+    free(tke_Lmix.data_handle());
+    free(depth_CellInterface.data_handle());
+}
+
+// Test columns of different depths with a large mixing length: the inner interfaces are bounded by the
+// distance to the surface and to the bottom of each column, and the interfaces below the bottom are unchanged
+TEST(calculate_mxl_3, distance_bound_1D) {
+    int nblocks = 1;
+    int nproma = 3;
+    int blockNo = 0;
+    int start_index = 0;
+    int end_index = nproma-1;
+    int nlevs = 4;
+    int max_levels = nlevs;
+    double mxl_min = 0.01;
+    double Lmix_large = 1.0e4;
+    int dolic[3] = {0, 2, nlevs};
+    double depth[5] = {0.0, 10.0, 30.0, 70.0, 150.0};
+
+    mdspan_2d_int dolic_c = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks, nproma);
+    mdspan_3d_double tke_Lmix = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                nlevs+1, nproma);
+    mdspan_3d_double depth_CellInterface = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                           nlevs+1, nproma);
+
+    for (int jc = 0; jc < nproma; jc++) {
+        dolic_c(0, jc) = dolic[jc];
+        for (int level = 0; level < nlevs+1; level++) {
+            tke_Lmix(0, level, jc) = Lmix_large;
+            depth_CellInterface(0, level, jc) = depth[level];
+        }
+    }
+    // a small mixing length in the middle of the deepest column is not modified
+    tke_Lmix(0, 2, 2) = 5.0;
+
+    calc_mxl_3(blockNo, start_index, end_index, max_levels, mxl_min,
+               dolic_c, tke_Lmix, depth_CellInterface);
+
+    // land column and surface and bottom interfaces: not bounded by the distances
+    for (int level = 0; level < nlevs+1; level++)
+        EXPECT_EQ(tke_Lmix(0, level, 0), Lmix_large);
+
+    // column with two levels
+    EXPECT_EQ(tke_Lmix(0, 0, 1), Lmix_large);
+    EXPECT_EQ(tke_Lmix(0, 1, 1), 10.0);
+    EXPECT_EQ(tke_Lmix(0, 2, 1), Lmix_large);
+    EXPECT_EQ(tke_Lmix(0, 3, 1), Lmix_large);
+    EXPECT_EQ(tke_Lmix(0, 4, 1), Lmix_large);
+
+    // full column
+    EXPECT_EQ(tke_Lmix(0, 0, 2), Lmix_large);
+    EXPECT_EQ(tke_Lmix(0, 1, 2), 10.0);
+    EXPECT_EQ(tke_Lmix(0, 2, 2), 5.0);
+    EXPECT_EQ(tke_Lmix(0, 3, 2), 70.0);
+    EXPECT_EQ(tke_Lmix(0, 4, 2), Lmix_large);
+
+    free(dolic_c.data_handle());
+    free(tke_Lmix.data_handle());
+    free(depth_CellInterface.data_handle());
+}
+
+// Test against the tke_mxl_choice == 3 branch of cvmix_tke (CVMix-src, src/shared/cvmix_tke.F90): the
+// mixing lengths of sqrt(2) sqrt(tke) / sqrt(max(1e-12, Nsqr)) and the expected values were computed by
+// that branch in Fortran for a column of 6 levels and a column of 3 levels of the same grid
+TEST(calculate_mxl_3, cvmix_reference_1D) {
+    int nblocks = 1;
+    int nproma = 2;
+    int blockNo = 0;
+    int start_index = 0;
+    int end_index = nproma-1;
+    int nlevs = 6;
+    int max_levels = nlevs;
+    double mxl_min = 1.0e-8;
+    int dolic[2] = {6, 3};
+    double depth[7] = {0.0, 5.5, 13.25, 24.0, 39.5, 61.0, 90.0};
+    double Lmix_input[2][7] = {{2.04939015319192004e+04, 1.21583751774865796e+01, 4.62377663223771940e+00,
+                                2.07744782694637387e+00, 8.79882690128119704e-01, 7.74596669241483369e+01,
+                                1.41421356237309533e+03},
+                               {3.54964786985976971e+04, 2.97818152861629741e+01, 1.13258934335868418e+01,
+                                5.08868714327234617e+00, 0.0, 0.0, 0.0}};
+    double Lmix_cvmix[2][7] = {{2.04939015319192004e+04, 5.5, 4.62377663223771940e+00,
+                                2.07744782694637387e+00, 8.79882690128119704e-01, 29.0,
+                                1.41421356237309533e+03},
+                               {3.54964786985976971e+04, 5.5, 10.75, 5.08868714327234617e+00, 0.0, 0.0, 0.0}};
+
+    mdspan_2d_int dolic_c = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks, nproma);
+    mdspan_3d_double tke_Lmix = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                nlevs+1, nproma);
+    mdspan_3d_double depth_CellInterface = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks,
+                                                                           nlevs+1, nproma);
+
+    for (int jc = 0; jc < nproma; jc++) {
+        dolic_c(0, jc) = dolic[jc];
+        for (int level = 0; level < nlevs+1; level++) {
+            tke_Lmix(0, level, jc) = Lmix_input[jc][level];
+            depth_CellInterface(0, level, jc) = depth[level];
+        }
+    }
+
+    calc_mxl_3(blockNo, start_index, end_index, max_levels, mxl_min,
+               dolic_c, tke_Lmix, depth_CellInterface);
+
+    for (int jc = 0; jc < nproma; jc++)
+        for (int level = 0; level < dolic[jc]+1; level++)
+            EXPECT_EQ(tke_Lmix(0, level, jc), Lmix_cvmix[jc][level]);
+
+    free(dolic_c.data_handle());
+    free(tke_Lmix.data_handle());
+    free(depth_CellInterface.data_handle());
+}
@@ -0,0 +1,113 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include "src/backends/CPU/cpu_kernels.hpp"
+
+// Columns of different depths with neutral, stable and unstable interfaces
+class calc_pp_test : public ::testing::Test {
+ protected:
+    static const int nlevs = 5;
+    static const int nproma = 3;
+
+    void SetUp() override {
+        p_constant.nlevs = nlevs;
+        p_constant_pp.richardson_factor_veloc = 0.5e-2;
+        p_constant_pp.richardson_factor_tracer = 0.5e-2;
+        p_constant_pp.c1_pp = 5.0;
+        p_constant_pp.velocity_background = 1.0e-4;
+        p_constant_pp.tracer_background = 1.0e-5;
+        p_constant_pp.convection_threshold = -5.0e-8;
+        p_constant_pp.max_vert_diff_veloc = 0.1;
+        p_constant_pp.max_vert_diff_tracer = 0.1;
+
+        p_patch.dolic_c = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), 1, nproma);
+        p_cvmix.a_temp_v = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs+1, nproma);
+        p_cvmix.a_salt_v = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs+1, nproma);
+        p_stability.Nsqr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs+1, nproma);
+        p_stability.Ssqr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs+1, nproma);
+        pp_Av = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs+1, nproma);
+
+        int dolic[nproma] = {0, 2, nlevs};
+        for (int jc = 0; jc < nproma; jc++) {
+            p_patch.dolic_c(0, jc) = dolic[jc];
+            for (int level = 0; level < nlevs+1; level++) {
+                // Ri = 0, 1, -1 and 0.2 at the interfaces 1 to 4
+                double Nsqr[nlevs+1] = {0.0, 0.0, 1.0e-5, -1.0e-5, 2.0e-6, 0.0};
+                p_stability.Nsqr(0, level, jc) = Nsqr[level];
+                p_stability.Ssqr(0, level, jc) = 1.0e-5;
+                p_cvmix.a_temp_v(0, level, jc) = -1.0;
+                p_cvmix.a_salt_v(0, level, jc) = -1.0;
+                pp_Av(0, level, jc) = -1.0;
+            }
+        }
+    }
+
+    void TearDown() override {
+        free(p_patch.dolic_c.data_handle());
+        free(p_cvmix.a_temp_v.data_handle());
+        free(p_cvmix.a_salt_v.data_handle());
+        free(p_stability.Nsqr.data_handle());
+        free(p_stability.Ssqr.data_handle());
+        free(pp_Av.data_handle());
+    }
+
+    t_constant p_constant;
+    t_constant_pp p_constant_pp;
+    t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch;
+    t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix;
+    t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability;
+    mdspan_3d_double pp_Av;
+};
+
+// Test the viscosity and diffusivity as functions of the Richardson number
+TEST_F(calc_pp_test, richardson_number) {
+    calc_pp_cells(0, 0, nproma-1, p_patch, p_cvmix, p_stability, pp_Av, p_constant, p_constant_pp);
+
+    int jc = nproma - 1;
+    // neutral
+    EXPECT_DOUBLE_EQ(pp_Av(0, 1, jc), 1.0e-4 + 0.5e-2);
+    EXPECT_DOUBLE_EQ(p_cvmix.a_temp_v(0, 1, jc), 1.0e-5 + 0.5e-2);
+    // stable, Ri = 1
+    EXPECT_DOUBLE_EQ(pp_Av(0, 2, jc), 1.0e-4 + 0.5e-2 / 36.0);
+    EXPECT_DOUBLE_EQ(p_cvmix.a_temp_v(0, 2, jc), 1.0e-5 + 0.5e-2 / 216.0);
+    // unstable, convection
+    EXPECT_DOUBLE_EQ(pp_Av(0, 3, jc), 0.1);
+    EXPECT_DOUBLE_EQ(p_cvmix.a_temp_v(0, 3, jc), 0.1);
+    // weakly stable, Ri = 0.2
+    EXPECT_DOUBLE_EQ(pp_Av(0, 4, jc), 1.0e-4 + 0.5e-2 / 4.0);
+    EXPECT_DOUBLE_EQ(p_cvmix.a_salt_v(0, 4, jc), 1.0e-5 + 0.5e-2 / 8.0);
+    // the viscosity decreases with the stability
+    EXPECT_GT(pp_Av(0, 1, jc), pp_Av(0, 4, jc));
+    EXPECT_GT(pp_Av(0, 4, jc), pp_Av(0, 2, jc));
+}
+
+// Test that the surface and the interfaces below the bottom are zero
+TEST_F(calc_pp_test, zero_outside) {
+    calc_pp_cells(0, 0, nproma-1, p_patch, p_cvmix, p_stability, pp_Av, p_constant, p_constant_pp);
+
+    for (int jc = 0; jc < nproma; jc++) {
+        for (int level = 0; level < nlevs+1; level++) {
+            if (level > 0 && level < p_patch.dolic_c(0, jc))
+                continue;
+            EXPECT_EQ(pp_Av(0, level, jc), 0.0) << "level " << level << " column " << jc;
+            EXPECT_EQ(p_cvmix.a_temp_v(0, level, jc), 0.0) << "level " << level << " column " << jc;
+            EXPECT_EQ(p_cvmix.a_salt_v(0, level, jc), 0.0) << "level " << level << " column " << jc;
+        }
+    }
+}
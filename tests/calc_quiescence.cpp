@@ -0,0 +1,114 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <limits>
+#include "src/backends/CPU/cpu_kernels.hpp"
+
+// Test the skipping of a block of quiescent columns: the first step is always a full one, then the block is
+// skipped while the tendency bound of all the wet columns is below the threshold, with the error bound
+// accumulating, until a column becomes active or quiescent_refresh steps have been skipped
+TEST(calc_quiescence, skip_and_refresh_1D) {
+    int nblocks = 1;
+    int nproma = 3;
+    int blockNo = 0;
+    int start_index = 0;
+    int end_index = nproma-1;
+    int nlevs = 3;
+    int dolic[3] = {nlevs, 2, 0};
+
+    t_constant p_constant = {};
+    p_constant.dtime = 10.0;
+    t_constant_tke p_constant_tke = {};
+    p_constant_tke.cd = 3.75;
+    p_constant_tke.nsubsteps = 1;
+    p_constant_tke.quiescent_threshold = 1.0e-6;
+    p_constant_tke.quiescent_refresh = 2;
+
+    t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch;
+    t_cvmix_view<cpu_memview::mdspan, cpu_memview::dextents> p_cvmix;
+    t_tke_internal_view<cpu_memview::mdspan, cpu_memview::dextents> p_internal;
+    t_tke_quiescence_view<cpu_memview::mdspan, cpu_memview::dextents> p_quiescence;
+    p_patch.dolic_c = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks, nproma);
+    p_cvmix.tke_Ttot = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nlevs+1, nproma);
+    p_internal.tke_Av = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nlevs+1, nproma);
+    p_internal.forc_tke_surf_2D = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nproma);
+    p_internal.dzt_stretched = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+    p_internal.Ssqr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+    p_quiescence.activity = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nproma);
+    p_quiescence.error_bound = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nblocks, nproma);
+    p_quiescence.skipped_steps = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), nblocks);
+
+    // no wind and no shear, the land column has a large tendency which is never read
+    for (int jc = 0; jc < nproma; jc++) {
+        p_patch.dolic_c(0, jc) = dolic[jc];
+        p_internal.forc_tke_surf_2D(jc) = 0.0;
+        p_quiescence.activity(0, jc) = std::numeric_limits<double>::max();
+        p_quiescence.error_bound(0, jc) = 0.0;
+        for (int level = 0; level < nlevs+1; level++) {
+            p_cvmix.tke_Ttot(0, level, jc) = jc == 2 ? 1.0 : 0.0;
+            p_internal.tke_Av(0, level, jc) = 1.0e-4;
+            p_internal.dzt_stretched(level, jc) = 10.0;
+            p_internal.Ssqr(level, jc) = 0.0;
+        }
+    }
+    p_quiescence.skipped_steps(0) = 0;
+    p_cvmix.tke_Ttot(0, 1, 0) = -1.0e-7;
+    p_cvmix.tke_Ttot(0, 2, 1) = 2.0e-8;
+
+    // the first step is a full step, which records the tendency of the wet columns
+    EXPECT_FALSE(update_quiescence(blockNo, start_index, end_index, p_patch, p_internal, p_quiescence,
+                                   p_constant, p_constant_tke));
+    record_activity(blockNo, start_index, end_index, p_patch, p_cvmix, p_quiescence);
+    EXPECT_EQ(p_quiescence.activity(0, 0), 1.0e-7);
+    EXPECT_EQ(p_quiescence.activity(0, 1), 2.0e-8);
+
+    // two skipped steps, then the refresh
+    EXPECT_TRUE(update_quiescence(blockNo, start_index, end_index, p_patch, p_internal, p_quiescence,
+                                  p_constant, p_constant_tke));
+    EXPECT_TRUE(update_quiescence(blockNo, start_index, end_index, p_patch, p_internal, p_quiescence,
+                                  p_constant, p_constant_tke));
+    EXPECT_EQ(p_quiescence.skipped_steps(0), 2);
+    EXPECT_DOUBLE_EQ(p_quiescence.error_bound(0, 0), 2.0e-6);
+    EXPECT_DOUBLE_EQ(p_quiescence.error_bound(0, 1), 4.0e-7);
+    EXPECT_EQ(p_quiescence.error_bound(0, 2), 0.0);
+    EXPECT_FALSE(update_quiescence(blockNo, start_index, end_index, p_patch, p_internal, p_quiescence,
+                                   p_constant, p_constant_tke));
+    EXPECT_EQ(p_quiescence.skipped_steps(0), 0);
+    record_activity(blockNo, start_index, end_index, p_patch, p_cvmix, p_quiescence);
+    EXPECT_EQ(p_quiescence.error_bound(0, 0), 0.0);
+
+    // the shear production of one interface above the threshold makes the block active again
+    p_internal.Ssqr(1, 1) = 1.0e-2;
+    EXPECT_FALSE(update_quiescence(blockNo, start_index, end_index, p_patch, p_internal, p_quiescence,
+                                   p_constant, p_constant_tke));
+    p_internal.Ssqr(1, 1) = 0.0;
+
+    // as does the wind forcing
+    p_internal.forc_tke_surf_2D(0) = 1.0e-3;
+    EXPECT_FALSE(update_quiescence(blockNo, start_index, end_index, p_patch, p_internal, p_quiescence,
+                                   p_constant, p_constant_tke));
+
+    free(p_patch.dolic_c.data_handle());
+    free(p_cvmix.tke_Ttot.data_handle());
+    free(p_internal.tke_Av.data_handle());
+    free(p_internal.forc_tke_surf_2D.data_handle());
+    free(p_internal.dzt_stretched.data_handle());
+    free(p_internal.Ssqr.data_handle());
+    free(p_quiescence.activity.data_handle());
+    free(p_quiescence.error_bound.data_handle());
+    free(p_quiescence.skipped_steps.data_handle());
+}
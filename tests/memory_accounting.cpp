@@ -0,0 +1,58 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include "src/backends/CPU/cpu_memory.hpp"
+#include "src/shared/memory_accounting.hpp"
+
+// Test the accounting of the allocations done through the counting policy
+TEST(memory_accounting, counting_memview_policy) {
+    int nlevs = 3;
+    int nproma = 4;
+
+    memory_accounting memory;
+    counting_memview_policy<cpu_mdspan_impl> policy(&memory);
+
+    double *field_1 = NULL;
+    double *field_2 = NULL;
+    int *field_3 = NULL;
+    mdspan_2d_double view_1 = policy.memview_malloc("scratch", field_1, nlevs, nproma);
+    mdspan_2d_double view_2 = policy.memview_malloc("scratch", field_2, nlevs, nproma);
+    mdspan_1d_int view_3 = policy.memview_malloc("levels", field_3, nproma);
+
+    size_t double_bytes = nlevs * nproma * sizeof(double);
+    size_t int_bytes = nproma * sizeof(int);
+    ASSERT_EQ(memory.current_bytes(), 2 * double_bytes + int_bytes);
+    ASSERT_EQ(memory.peak_bytes(), 2 * double_bytes + int_bytes);
+
+    std::vector<t_memory_field> fields = memory.fields();
+    ASSERT_EQ(fields.size(), 2u);
+    ASSERT_EQ(strcmp(fields[0].name, "scratch"), 0);
+    ASSERT_EQ(fields[0].bytes, 2 * double_bytes);
+    ASSERT_EQ(strcmp(fields[1].name, "levels"), 0);
+    ASSERT_EQ(fields[1].bytes, int_bytes);
+
+    policy.memview_free(view_2.data_handle());
+    ASSERT_EQ(memory.current_bytes(), double_bytes + int_bytes);
+    ASSERT_EQ(memory.peak_bytes(), 2 * double_bytes + int_bytes);
+
+    policy.memview_free(view_1.data_handle());
+    policy.memview_free(view_3.data_handle());
+    ASSERT_EQ(memory.current_bytes(), 0u);
+    ASSERT_EQ(memory.fields().size(), 0u);
+}
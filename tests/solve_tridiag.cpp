@@ -0,0 +1,113 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include "src/backends/CPU/cpu_kernels.hpp"
+
+// Diagonally dominant tridiagonal systems of columns with different depths
+class solve_tridiag_test : public ::testing::Test {
+ protected:
+    static const int nlevs = 6;
+    static const int nproma = 4;
+    static const int max_levels = 5;
+
+    void SetUp() override {
+        dolic_c = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), 1, nproma);
+        a = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+        b = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+        c = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+        d = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+        cp = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+        dp = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs+1, nproma);
+        x = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs+1, nproma);
+
+        int dolic[nproma] = {0, 1, 3, max_levels};
+        for (int jc = 0; jc < nproma; jc++) {
+            dolic_c(0, jc) = dolic[jc];
+            for (int level = 0; level < nlevs+1; level++) {
+                a(level, jc) = level == 0 ? 0.0 : -0.3 - 0.05 * level;
+                c(level, jc) = level == dolic[jc] ? 0.0 : -0.2 - 0.01 * jc;
+                b(level, jc) = 1.0 + 0.1 * level + 0.2 * jc;
+                d(level, jc) = std::sin(1.0 + level + 7.0 * jc);
+                x(0, level, jc) = -1.0;
+            }
+        }
+    }
+
+    void TearDown() override {
+        free(dolic_c.data_handle());
+        free(a.data_handle());
+        free(b.data_handle());
+        free(c.data_handle());
+        free(d.data_handle());
+        free(cp.data_handle());
+        free(dp.data_handle());
+        free(x.data_handle());
+    }
+
+    // residual of the system of column jc
+    double residual(int jc, int level) {
+        double ax = b(level, jc) * x(0, level, jc);
+        if (level > 0)
+            ax += a(level, jc) * x(0, level-1, jc);
+        if (level < dolic_c(0, jc))
+            ax += c(level, jc) * x(0, level+1, jc);
+        return ax - d(level, jc);
+    }
+
+    mdspan_2d_int dolic_c;
+    mdspan_2d_double a, b, c, d, cp, dp;
+    mdspan_3d_double x;
+};
+
+// Test the solution of each column down to its bottom level
+TEST_F(solve_tridiag_test, residual) {
+    solve_tridiag(0, 0, nproma-1, max_levels, dolic_c, a, b, c, d, x, cp, dp);
+
+    for (int jc = 0; jc < nproma; jc++) {
+        for (int level = 0; level <= dolic_c(0, jc); level++)
+            ASSERT_NEAR(residual(jc, level), 0.0, 1.0e-14);
+        // levels below the bottom are not touched
+        for (int level = dolic_c(0, jc)+1; level < nlevs+1; level++)
+            ASSERT_EQ(x(0, level, jc), -1.0);
+    }
+}
+
+// Test the sweep of a new right-hand side with the factors of a previous solution
+TEST_F(solve_tridiag_test, factor_once) {
+    factor_tridiag(0, 0, nproma-1, max_levels, dolic_c, a, b, c, cp, dp);
+    for (int level = 0; level < nlevs+1; level++)
+        for (int jc = 0; jc < nproma; jc++)
+            d(level, jc) = std::cos(2.0 * level - jc);
+    sweep_tridiag(0, 0, nproma-1, max_levels, dolic_c, a, d, cp, dp, x);
+
+    for (int jc = 0; jc < nproma; jc++)
+        for (int level = 0; level <= dolic_c(0, jc); level++)
+            ASSERT_NEAR(residual(jc, level), 0.0, 1.0e-14);
+}
+
+// Test the solution of the parallel cyclic reduction
+TEST_F(solve_tridiag_test, pcr) {
+    solve_tridiag_pcr(0, 0, nproma-1, dolic_c, a, b, c, d, x);
+    for (int jc = 0; jc < nproma; jc++) {
+        for (int level = 0; level <= dolic_c(0, jc); level++)
+            ASSERT_NEAR(residual(jc, level), 0.0, 1.0e-14);
+        for (int level = dolic_c(0, jc)+1; level < nlevs+1; level++)
+            ASSERT_EQ(x(0, level, jc), -1.0);
+    }
+}
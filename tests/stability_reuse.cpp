@@ -0,0 +1,99 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include "src/YAOP.hpp"
+#include "src/shared/synthetic_input.hpp"
+
+namespace {
+
+const int ncells = 300;
+const int nlevs = 12;
+const int nproma = 16;
+
+YAOP *new_yaop(int nblocks) {
+    double grav = 9.80665;
+    return new YAOP(nproma, nlevs, nblocks, 2, 4, 0, 600.0, 1025.022, grav, 0, 0.15, 1035.0*grav*1.0e-4,
+                    3.14159265358979323846264338327950288);
+}
+
+// in place update of the state between two calls: the stratification changes with the level
+void warm_surface(synthetic_input *input) {
+    for (int jb = 0; jb < input->nblocks; jb++)
+        for (int level = 0; level < input->nlevs; level++)
+            for (int jc = 0; jc < input->nproma; jc++)
+                input->ocean_state.temp[(static_cast<size_t>(jb) * input->nlevs + level) * input->nproma + jc] +=
+                    2.0 / (level + 1);
+}
+
+void expect_equal_mixing(const synthetic_input &a, const synthetic_input &b) {
+    size_t size_3d = static_cast<size_t>(a.nblocks) * (a.nlevs+1) * a.nproma;
+    for (size_t i = 0; i < size_3d; i++) {
+        EXPECT_EQ(a.p_cvmix.a_veloc_v[i], b.p_cvmix.a_veloc_v[i]);
+        EXPECT_EQ(a.p_cvmix.a_temp_v[i], b.p_cvmix.a_temp_v[i]);
+    }
+}
+
+}  // namespace
+
+// Test that the stability computed by a tke step is not reused by the PP scheme after the state
+// has been updated in place
+TEST(stability_reuse, pp_after_state_update) {
+    synthetic_input reused(ncells, nlevs, nproma), fresh(ncells, nlevs, nproma);
+
+    YAOP *yaop_reused = new_yaop(reused.nblocks);
+    reused.register_fields(yaop_reused);
+    yaop_reused->step(reused.range);
+    warm_surface(&reused);
+    yaop_reused->calc_pp(reused.range);
+    delete yaop_reused;
+
+    YAOP *yaop_fresh = new_yaop(fresh.nblocks);
+    fresh.register_fields(yaop_fresh);
+    warm_surface(&fresh);
+    yaop_fresh->calc_pp(fresh.range);
+    delete yaop_fresh;
+
+    expect_equal_mixing(reused, fresh);
+}
+
+// Test that the stability published by calc_vertical_stability is consumed by the step of its time
+// step only, the next step recomputes it from the updated state
+TEST(stability_reuse, published_for_one_step) {
+    synthetic_input published(ncells, nlevs, nproma), computed(ncells, nlevs, nproma);
+
+    YAOP *yaop_published = new_yaop(published.nblocks);
+    published.register_fields(yaop_published);
+    yaop_published->calc_vertical_stability(published.range);
+    yaop_published->step(published.range);
+    warm_surface(&published);
+    yaop_published->step(published.range);
+    delete yaop_published;
+
+    YAOP *yaop_computed = new_yaop(computed.nblocks);
+    computed.register_fields(yaop_computed);
+    yaop_computed->step(computed.range);
+    warm_surface(&computed);
+    yaop_computed->step(computed.range);
+    delete yaop_computed;
+
+    expect_equal_mixing(published, computed);
+    size_t size_3d = static_cast<size_t>(published.nblocks) * (nlevs+1) * nproma;
+    for (size_t i = 0; i < size_3d; i++)
+        EXPECT_EQ(published.p_cvmix.tke[i], computed.p_cvmix.tke[i]);
+}
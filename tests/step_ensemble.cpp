@@ -0,0 +1,154 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include "src/YAOP.hpp"
+#include "src/shared/synthetic_input.hpp"
+
+namespace {
+
+const int ncells = 300;
+const int nlevs = 12;
+const int nproma = 16;
+
+YAOP *new_yaop(int nblocks) {
+    double grav = 9.80665;
+    return new YAOP(nproma, nlevs, nblocks, 2, 4, 0, 600.0, 1025.022, grav, 0, 0.15, 1035.0*grav*1.0e-4,
+                    3.14159265358979323846264338327950288);
+}
+
+// the second member is warmer and has more tke than the first one
+void perturb(synthetic_input *input) {
+    size_t size_levels = static_cast<size_t>(input->nblocks) * input->nlevs * input->nproma;
+    size_t size_interfaces = static_cast<size_t>(input->nblocks) * (input->nlevs+1) * input->nproma;
+    for (size_t i = 0; i < size_levels; i++)
+        input->ocean_state.temp[i] += 0.5;
+    for (size_t i = 0; i < size_interfaces; i++)
+        input->p_cvmix.tke[i] *= 2.0;
+}
+
+// grid info of the instance rebound to the one of input
+void rebind_patch(YAOP *yaop, const synthetic_input &input) {
+    yaop->rebind_field("depth_CellInterface", input.p_patch.depth_CellInterface);
+    yaop->rebind_field("prism_center_dist_c", input.p_patch.prism_center_dist_c);
+    yaop->rebind_field("inv_prism_center_dist_c", input.p_patch.inv_prism_center_dist_c);
+    yaop->rebind_field("prism_thick_c", input.p_patch.prism_thick_c);
+    yaop->rebind_field("dolic_c", input.p_patch.dolic_c);
+    yaop->rebind_field("dolic_e", input.p_patch.dolic_e);
+    yaop->rebind_field("zlev_i", input.p_patch.zlev_i);
+    yaop->rebind_field("wet_c", input.p_patch.wet_c);
+    yaop->rebind_field("edges_cell_idx", input.p_patch.edges_cell_idx);
+    yaop->rebind_field("edges_cell_blk", input.p_patch.edges_cell_blk);
+}
+
+void expect_equal_outputs(const synthetic_input &a, const synthetic_input &b) {
+    size_t size_3d = static_cast<size_t>(a.nblocks) * (a.nlevs+1) * a.nproma;
+    for (size_t i = 0; i < size_3d; i++) {
+        EXPECT_EQ(a.p_cvmix.tke[i], b.p_cvmix.tke[i]);
+        EXPECT_EQ(a.p_cvmix.a_veloc_v[i], b.p_cvmix.a_veloc_v[i]);
+        EXPECT_EQ(a.p_cvmix.a_temp_v[i], b.p_cvmix.a_temp_v[i]);
+        EXPECT_EQ(a.p_cvmix.tke_Tdif[i], b.p_cvmix.tke_Tdif[i]);
+    }
+}
+
+}  // namespace
+
+// Test a 2 member ensemble sharing the grid info against the same members computed one after the
+// other by selecting their buffer sets
+TEST(step_ensemble, two_members_as_buffer_sets) {
+    synthetic_input ens_1(ncells, nlevs, nproma), ens_2(ncells, nlevs, nproma);
+    synthetic_input seq_1(ncells, nlevs, nproma), seq_2(ncells, nlevs, nproma);
+    perturb(&ens_2);
+    perturb(&seq_2);
+
+    YAOP *yaop_ens = new_yaop(ens_1.nblocks);
+    ens_1.register_fields(yaop_ens);
+    int set_ids[2];
+    set_ids[0] = yaop_ens->save_buffer_set();
+    ens_2.register_fields(yaop_ens);
+    rebind_patch(yaop_ens, ens_1);
+    set_ids[1] = yaop_ens->save_buffer_set();
+    yaop_ens->step_ensemble(2, set_ids, ens_1.range);
+    delete yaop_ens;
+
+    YAOP *yaop_seq = new_yaop(seq_1.nblocks);
+    seq_1.register_fields(yaop_seq);
+    int set_1 = yaop_seq->save_buffer_set();
+    seq_2.register_fields(yaop_seq);
+    int set_2 = yaop_seq->save_buffer_set();
+    yaop_seq->select_buffer_set(set_1);
+    yaop_seq->step(seq_1.range);
+    yaop_seq->select_buffer_set(set_2);
+    yaop_seq->step(seq_2.range);
+    delete yaop_seq;
+
+    expect_equal_outputs(ens_1, seq_1);
+    expect_equal_outputs(ens_2, seq_2);
+
+    // the members differ, so the buffer sets were not mixed
+    EXPECT_NE(ens_1.p_cvmix.tke[nproma], ens_2.p_cvmix.tke[nproma]);
+}
+
+// Test a change of the grid info while a member is not in the ensemble: the member cached with the
+// previous grid info is computed with the new one when it is back, as in the steps computed one after
+// the other by selecting their buffer sets
+TEST(step_ensemble, grid_change_with_absent_member) {
+    synthetic_input ens_1(ncells, nlevs, nproma), ens_2(ncells, nlevs, nproma);
+    synthetic_input seq_1(ncells, nlevs, nproma), seq_2(ncells, nlevs, nproma);
+    perturb(&ens_2);
+    perturb(&seq_2);
+    // the second grid info has thicker layers
+    synthetic_input grid(ncells, nlevs, nproma);
+    size_t size_levels = static_cast<size_t>(grid.nblocks) * grid.nlevs * grid.nproma;
+    for (size_t i = 0; i < size_levels; i++)
+        grid.p_patch.prism_thick_c[i] *= 1.5;
+
+    YAOP *yaop_ens = new_yaop(ens_1.nblocks);
+    ens_1.register_fields(yaop_ens);
+    int first_ids[2], second_ids[2];
+    first_ids[0] = yaop_ens->save_buffer_set();
+    rebind_patch(yaop_ens, grid);
+    second_ids[0] = yaop_ens->save_buffer_set();
+    ens_2.register_fields(yaop_ens);
+    rebind_patch(yaop_ens, ens_1);
+    first_ids[1] = yaop_ens->save_buffer_set();
+    rebind_patch(yaop_ens, grid);
+    second_ids[1] = yaop_ens->save_buffer_set();
+    yaop_ens->step_ensemble(2, first_ids, ens_1.range);
+    yaop_ens->step_ensemble(1, second_ids, ens_1.range);
+    yaop_ens->step_ensemble(2, second_ids, ens_1.range);
+    delete yaop_ens;
+
+    YAOP *yaop_seq = new_yaop(seq_1.nblocks);
+    seq_1.register_fields(yaop_seq);
+    int first_1 = yaop_seq->save_buffer_set();
+    rebind_patch(yaop_seq, grid);
+    int second_1 = yaop_seq->save_buffer_set();
+    seq_2.register_fields(yaop_seq);
+    rebind_patch(yaop_seq, seq_1);
+    int first_2 = yaop_seq->save_buffer_set();
+    rebind_patch(yaop_seq, grid);
+    int second_2 = yaop_seq->save_buffer_set();
+    for (int set_id : {first_1, first_2, second_1, second_1, second_2}) {
+        yaop_seq->select_buffer_set(set_id);
+        yaop_seq->step(seq_1.range);
+    }
+    delete yaop_seq;
+
+    expect_equal_outputs(ens_1, seq_1);
+    expect_equal_outputs(ens_2, seq_2);
+}
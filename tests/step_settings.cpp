@@ -0,0 +1,125 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <vector>
+#include "src/YAOP.hpp"
+#include "src/shared/synthetic_input.hpp"
+
+namespace {
+
+const int ncells = 300;
+const int nlevs = 12;
+const int nproma = 16;
+
+YAOP *new_yaop(int nblocks, int vert_mix_type = 2) {
+    double grav = 9.80665;
+    return new YAOP(nproma, nlevs, nblocks, vert_mix_type, 4, 0, 600.0, 1025.022, grav, 0, 0.15,
+                    1035.0*grav*1.0e-4, 3.14159265358979323846264338327950288);
+}
+
+}  // namespace
+
+// Test that invalid settings are rejected without changing the instance
+TEST(step_settings, invalid_values) {
+    YAOP *yaop = new_yaop(1);
+    EXPECT_FALSE(yaop->set_quiescence(-1.0));
+    EXPECT_FALSE(yaop->set_quiescence(1.0e-6, 0));
+    EXPECT_FALSE(yaop->set_tridiag_solver(2));
+    EXPECT_FALSE(yaop->set_tke_mxl_choice(1));
+    EXPECT_TRUE(yaop->set_quiescence(1.0e-6, 5));
+    EXPECT_TRUE(yaop->set_tridiag_solver(tridiag_pcr));
+    EXPECT_TRUE(yaop->set_tke_mxl_choice(3));
+    delete yaop;
+
+    // the quiescent columns mode is not available with IDEMIX
+    YAOP *yaop_idemix = new_yaop(1, 4);
+    EXPECT_FALSE(yaop_idemix->set_quiescence(1.0e-6));
+    EXPECT_TRUE(yaop_idemix->set_quiescence(0.0));
+    delete yaop_idemix;
+}
+
+// Test two instances of the same process with different settings: the mixing length choice changes
+// the result, the fused edges do not
+TEST(step_settings, per_instance) {
+    synthetic_input input_2(ncells, nlevs, nproma), input_3(ncells, nlevs, nproma);
+
+    YAOP *yaop_2 = new_yaop(input_2.nblocks);
+    YAOP *yaop_3 = new_yaop(input_3.nblocks);
+    EXPECT_TRUE(yaop_3->set_tke_mxl_choice(3));
+    input_2.register_fields(yaop_2);
+    input_3.register_fields(yaop_3);
+    yaop_2->step(input_2.range);
+    yaop_3->step(input_3.range);
+    delete yaop_2;
+    delete yaop_3;
+
+    size_t size_3d = static_cast<size_t>(input_2.nblocks) * (nlevs+1) * nproma;
+    size_t ndiffer = 0;
+    for (size_t i = 0; i < size_3d; i++)
+        ndiffer += input_2.p_cvmix.tke_Lmix[i] != input_3.p_cvmix.tke_Lmix[i];
+    EXPECT_GT(ndiffer, 0u);
+
+    synthetic_input input_fused(ncells, nlevs, nproma), input_separate(ncells, nlevs, nproma);
+    YAOP *yaop_fused = new_yaop(input_fused.nblocks);
+    YAOP *yaop_separate = new_yaop(input_separate.nblocks);
+    yaop_fused->set_fuse_edges(true);
+    input_fused.register_fields(yaop_fused);
+    input_separate.register_fields(yaop_separate);
+    yaop_fused->step(input_fused.range);
+    yaop_separate->step(input_separate.range);
+    delete yaop_fused;
+    delete yaop_separate;
+
+    for (size_t i = 0; i < size_3d; i++)
+        EXPECT_EQ(input_fused.p_cvmix.a_veloc_v[i], input_separate.p_cvmix.a_veloc_v[i]);
+}
+
+// Test the quiescent columns mode with a threshold above every tendency: tke rebound between a full step
+// and a step which would skip every block is computed by a full step, as without the mode, and the next
+// step skips the blocks again
+TEST(step_settings, quiescence_after_rebind) {
+    synthetic_input quiescent(ncells, nlevs, nproma), reference(ncells, nlevs, nproma);
+    size_t size_3d = static_cast<size_t>(quiescent.nblocks) * (nlevs+1) * nproma;
+    std::vector<double> quiescent_tke(quiescent.p_cvmix.tke, quiescent.p_cvmix.tke + size_3d);
+    std::vector<double> reference_tke(reference.p_cvmix.tke, reference.p_cvmix.tke + size_3d);
+
+    YAOP *yaop_quiescent = new_yaop(quiescent.nblocks);
+    YAOP *yaop_reference = new_yaop(reference.nblocks);
+    EXPECT_TRUE(yaop_quiescent->set_quiescence(1.0e10, 100));
+    quiescent.register_fields(yaop_quiescent);
+    reference.register_fields(yaop_reference);
+    yaop_quiescent->step(quiescent.range);
+    yaop_reference->step(reference.range);
+
+    yaop_quiescent->rebind_field("tke", quiescent_tke.data());
+    yaop_reference->rebind_field("tke", reference_tke.data());
+    yaop_quiescent->step(quiescent.range);
+    yaop_reference->step(reference.range);
+    EXPECT_EQ(yaop_quiescent->quiescence_report().nblocks_skipped, 0);
+    for (size_t i = 0; i < size_3d; i++) {
+        EXPECT_EQ(quiescent_tke[i], reference_tke[i]);
+        EXPECT_EQ(quiescent.p_cvmix.a_temp_v[i], reference.p_cvmix.a_temp_v[i]);
+        EXPECT_EQ(quiescent.p_cvmix.tke_Ttot[i], reference.p_cvmix.tke_Ttot[i]);
+    }
+
+    yaop_quiescent->step(quiescent.range);
+    EXPECT_GT(yaop_quiescent->quiescence_report().nblocks_skipped, 0);
+    delete yaop_quiescent;
+    delete yaop_reference;
+}
@@ -0,0 +1,82 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <vector>
+#include "src/YAOP.hpp"
+#include "src/shared/synthetic_input.hpp"
+
+namespace {
+
+const int ncells = 300;
+const int nlevs = 12;
+const int nproma = 16;
+const double dtime = 600.0;
+
+YAOP *new_yaop(int nblocks) {
+    double grav = 9.80665;
+    return new YAOP(nproma, nlevs, nblocks, 2, 4, 0, dtime, 1025.022, grav, 0, 0.15, 1035.0*grav*1.0e-4,
+                    3.14159265358979323846264338327950288);
+}
+
+}  // namespace
+
+// Test one call with 4 substeps against 4 steps of the time step of the construction, the quiescent
+// columns are not skipped by default
+TEST(step_substeps, four_substeps_as_four_steps) {
+    synthetic_input substeps(ncells, nlevs, nproma), steps(ncells, nlevs, nproma);
+
+    YAOP *yaop_substeps = new_yaop(substeps.nblocks);
+    substeps.register_fields(yaop_substeps);
+    yaop_substeps->step(substeps.range, 4, 4.0 * dtime);
+    delete yaop_substeps;
+
+    YAOP *yaop_steps = new_yaop(steps.nblocks);
+    steps.register_fields(yaop_steps);
+    for (int step = 0; step < 4; step++)
+        yaop_steps->step(steps.range);
+    delete yaop_steps;
+
+    size_t size_3d = static_cast<size_t>(steps.nblocks) * (nlevs+1) * nproma;
+    for (size_t i = 0; i < size_3d; i++) {
+        EXPECT_EQ(substeps.p_cvmix.tke[i], steps.p_cvmix.tke[i]);
+        EXPECT_EQ(substeps.p_cvmix.a_veloc_v[i], steps.p_cvmix.a_veloc_v[i]);
+        EXPECT_EQ(substeps.p_cvmix.a_temp_v[i], steps.p_cvmix.a_temp_v[i]);
+        EXPECT_EQ(substeps.p_cvmix.a_salt_v[i], steps.p_cvmix.a_salt_v[i]);
+        EXPECT_EQ(substeps.p_cvmix.tke_Tdif[i], steps.p_cvmix.tke_Tdif[i]);
+        EXPECT_EQ(substeps.p_cvmix.tke_Ttot[i], steps.p_cvmix.tke_Ttot[i]);
+    }
+}
+
+// Test that a call with a number of substeps or a time step which is not positive is rejected and
+// computes nothing
+TEST(step_substeps, invalid_values) {
+    synthetic_input input(ncells, nlevs, nproma);
+
+    YAOP *yaop = new_yaop(input.nblocks);
+    input.register_fields(yaop);
+    size_t size_3d = static_cast<size_t>(input.nblocks) * (nlevs+1) * nproma;
+    std::vector<double> tke(input.p_cvmix.tke, input.p_cvmix.tke + size_3d);
+    EXPECT_FALSE(yaop->step(input.range, 0, dtime));
+    EXPECT_FALSE(yaop->step(input.range, 2, 0.0));
+    EXPECT_FALSE(yaop->step(input.range, 2, -dtime));
+    for (size_t i = 0; i < size_3d; i++)
+        EXPECT_EQ(input.p_cvmix.tke[i], tke[i]);
+    EXPECT_TRUE(yaop->step(input.range, 2, dtime));
+    delete yaop;
+}
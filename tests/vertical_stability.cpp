@@ -0,0 +1,124 @@
+/* Copyright (C) 2023  Enrico Degregori, Wilton Jaciel Loch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include "src/backends/CPU/cpu_kernels.hpp"
+#include "src/backends/kernels.hpp"
+
+// Stably stratified columns of different depths with a sheared velocity
+class vertical_stability_test : public ::testing::Test {
+ protected:
+    static const int nlevs = 6;
+    static const int nproma = 4;
+    static const int max_levels = 5;
+
+    void SetUp() override {
+        p_constant.nlevs = nlevs;
+        p_constant.grav = 9.81;
+        p_constant.OceanReferenceDensity = 1025.022;
+
+        p_patch.dolic_c = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), 1, nproma);
+        ocean_state.temp = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs, nproma);
+        ocean_state.salt = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs, nproma);
+        ocean_state.p_vn_x1 = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs, nproma);
+        ocean_state.p_vn_x2 = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs, nproma);
+        ocean_state.p_vn_x3 = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs, nproma);
+        p_geometry.inv_dzt_stretched = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL),
+                                                                       1, nlevs+1, nproma);
+        p_geometry.pressure = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), nlevs);
+        p_geometry.max_levels = cpu_mdspan_impl::memview_malloc(static_cast<int *>(NULL), 1);
+        p_stability.Nsqr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs+1, nproma);
+        p_stability.Ssqr = cpu_mdspan_impl::memview_malloc(static_cast<double *>(NULL), 1, nlevs+1, nproma);
+
+        int dolic[nproma] = {0, 1, 3, max_levels};
+        p_geometry.max_levels(0) = max_levels;
+        for (int level = 0; level < nlevs; level++)
+            p_geometry.pressure(level) = 10.0 * level;
+        for (int jc = 0; jc < nproma; jc++) {
+            p_patch.dolic_c(0, jc) = dolic[jc];
+            for (int level = 0; level < nlevs; level++) {
+                ocean_state.temp(0, level, jc) = 20.0 - 2.0 * level - 0.5 * jc;
+                ocean_state.salt(0, level, jc) = 35.0 + 0.1 * level;
+                ocean_state.p_vn_x1(0, level, jc) = 0.5 - 0.1 * level;
+                ocean_state.p_vn_x2(0, level, jc) = 0.05 * level * jc;
+                ocean_state.p_vn_x3(0, level, jc) = 0.0;
+            }
+            // stale values of a previous step
+            for (int level = 0; level < nlevs+1; level++) {
+                p_geometry.inv_dzt_stretched(0, level, jc) = 1.0 / (10.0 + level);
+                p_stability.Nsqr(0, level, jc) = -1.0;
+                p_stability.Ssqr(0, level, jc) = -1.0;
+            }
+        }
+    }
+
+    void TearDown() override {
+        free(p_patch.dolic_c.data_handle());
+        free(ocean_state.temp.data_handle());
+        free(ocean_state.salt.data_handle());
+        free(ocean_state.p_vn_x1.data_handle());
+        free(ocean_state.p_vn_x2.data_handle());
+        free(ocean_state.p_vn_x3.data_handle());
+        free(p_geometry.inv_dzt_stretched.data_handle());
+        free(p_geometry.pressure.data_handle());
+        free(p_geometry.max_levels.data_handle());
+        free(p_stability.Nsqr.data_handle());
+        free(p_stability.Ssqr.data_handle());
+    }
+
+    t_constant p_constant;
+    t_patch_view<cpu_memview::mdspan, cpu_memview::dextents> p_patch;
+    t_ocean_state_view<cpu_memview::mdspan, cpu_memview::dextents> ocean_state;
+    t_tke_geometry_view<cpu_memview::mdspan, cpu_memview::dextents> p_geometry;
+    t_vertical_stability_view<cpu_memview::mdspan, cpu_memview::dextents> p_stability;
+};
+
+// Test the frequencies at the wet interfaces of each column
+TEST_F(vertical_stability_test, wet_interfaces) {
+    calc_vertical_stability(0, 0, nproma-1, p_patch, ocean_state, p_geometry, p_stability, p_constant);
+
+    for (int jc = 0; jc < nproma; jc++) {
+        for (int level = 1; level < p_patch.dolic_c(0, jc); level++) {
+            double rho_up = calculate_density(ocean_state.temp(0, level-1, jc), ocean_state.salt(0, level-1, jc),
+                                              p_geometry.pressure(level));
+            double rho_down = calculate_density(ocean_state.temp(0, level, jc), ocean_state.salt(0, level, jc),
+                                                p_geometry.pressure(level));
+            double inv_dzt = p_geometry.inv_dzt_stretched(0, level, jc);
+            double du1 = (ocean_state.p_vn_x1(0, level-1, jc) - ocean_state.p_vn_x1(0, level, jc)) * inv_dzt;
+            double du2 = (ocean_state.p_vn_x2(0, level-1, jc) - ocean_state.p_vn_x2(0, level, jc)) * inv_dzt;
+            EXPECT_DOUBLE_EQ(p_stability.Nsqr(0, level, jc),
+                             p_constant.grav / p_constant.OceanReferenceDensity * (rho_down - rho_up) * inv_dzt);
+            EXPECT_GT(p_stability.Nsqr(0, level, jc), 0.0);
+            EXPECT_DOUBLE_EQ(p_stability.Ssqr(0, level, jc), du1 * du1 + du2 * du2);
+        }
+    }
+}
+
+// Test that the surface and the interfaces below the bottom do not keep values of a previous step
+TEST_F(vertical_stability_test, zero_outside) {
+    calc_vertical_stability(0, 0, nproma-1, p_patch, ocean_state, p_geometry, p_stability, p_constant);
+
+    for (int jc = 0; jc < nproma; jc++) {
+        for (int level = 0; level < nlevs+1; level++) {
+            if (level > 0 && level < p_patch.dolic_c(0, jc))
+                continue;
+            EXPECT_EQ(p_stability.Nsqr(0, level, jc), 0.0) << "level " << level << " column " << jc;
+            EXPECT_EQ(p_stability.Ssqr(0, level, jc), 0.0) << "level " << level << " column " << jc;
+        }
+    }
+}